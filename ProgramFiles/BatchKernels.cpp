@@ -0,0 +1,484 @@
+#include "BatchKernels.h"
+#include "Triangle.h" // Scalar tests used for the remainder and for the elements the filters cannot decide.
+#include "Predicates.h" // Error bounds of the filters.
+#include <atomic> // The selected code path may be read by several threads.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCHKERNELS_X86 // Vector code paths are only compiled on x86 with GCC or Clang.
+#include <immintrin.h> // SSE2, AVX2 and AVX-512 intrinsics.
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off") // Fusing a multiply and an add would invalidate the error bounds of the filters.
+#endif
+
+/*
+    The kernels below take their inputs as an array of pointers in the order px, py, ax, ay, bx, by, cx, cy. Bit k
+    of broadcast is set if input k is a single value used for every element rather than an array. Each kernel
+    handles whole vectors and returns how many elements it did, the caller finishes the rest with the scalar code.
+    The kernels convert the floats to doubles and evaluate the determinants with the same pivots as the calls
+    made by the scalar tests, so the filters are those of Predicates::orientation() and Predicates::inCircle().
+*/
+
+/*
+    Scalar point-in-triangle test for element i. It calls the test in Triangle so both are always the same.
+*/
+static unsigned char triangleScalar(const float *const in[8], unsigned int broadcast, int i)
+{
+    float v[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        v[k] = ((broadcast >> k) & 1) ? in[k][0] : in[k][i];
+    }
+    return Triangle::isPointInTriangle(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+}
+
+/*
+    Scalar point-in-circumcircle test for element i, also the one in Triangle.
+*/
+static unsigned char circleScalar(const float *const in[8], unsigned int broadcast, int i)
+{
+    float v[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        v[k] = ((broadcast >> k) & 1) ? in[k][0] : in[k][i];
+    }
+    return Triangle::isPointInCircumcircle(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+}
+
+#ifdef BATCHKERNELS_X86
+
+/*
+    SSE2 versions, two elements at a time. SSE2 is part of every x86-64 processor.
+*/
+__attribute__((target("sse2"))) static inline __m128d loadSse2(const float *p, bool isBroadcast, int i)
+{
+    return isBroadcast ? _mm_set1_pd(*p) : _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)(p + i))));
+}
+
+__attribute__((target("sse2"))) static inline __m128d absSse2(__m128d x)
+{
+    return _mm_andnot_pd(_mm_set1_pd(-0.0), x);
+}
+
+// Elements whose orientation determinant left - right is larger than its error bound.
+__attribute__((target("sse2"))) static inline __m128d isCertainSse2(__m128d left, __m128d right, __m128d determinant, __m128d bound)
+{
+    return _mm_cmpge_pd(absSse2(determinant), _mm_mul_pd(bound, _mm_add_pd(absSse2(left), absSse2(right))));
+}
+
+__attribute__((target("sse2"))) static int triangleSse2(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m128d zero(_mm_setzero_pd()), bound(_mm_set1_pd(Predicates::ORIENTATION_BOUND));
+    int i(0), decided(0); // decided counts the elements the filters settled.
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d px(loadSse2(in[0], broadcast & 1, i)), py(loadSse2(in[1], broadcast & 2, i));
+        __m128d ax(loadSse2(in[2], broadcast & 4, i)), ay(loadSse2(in[3], broadcast & 8, i));
+        __m128d bx(loadSse2(in[4], broadcast & 16, i)), by(loadSse2(in[5], broadcast & 32, i));
+        __m128d cx(loadSse2(in[6], broadcast & 64, i)), cy(loadSse2(in[7], broadcast & 128, i));
+
+        // Orientation of the triangle, with C as the pivot.
+        __m128d left(_mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(by, cy))), right(_mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(bx, cx)));
+        __m128d side(_mm_sub_pd(left, right)), isCertain(isCertainSse2(left, right, side, bound));
+
+        // Orientations of the edges BC, CA and AB with the point as the pivot.
+        __m128d apx(_mm_sub_pd(ax, px)), apy(_mm_sub_pd(ay, py)), bpx(_mm_sub_pd(bx, px)), bpy(_mm_sub_pd(by, py)), cpx(_mm_sub_pd(cx, px)), cpy(_mm_sub_pd(cy, py));
+        left = _mm_mul_pd(bpx, cpy);
+        right = _mm_mul_pd(bpy, cpx);
+        __m128d sideA(_mm_sub_pd(left, right));
+        isCertain = _mm_and_pd(isCertain, isCertainSse2(left, right, sideA, bound));
+        left = _mm_mul_pd(cpx, apy);
+        right = _mm_mul_pd(cpy, apx);
+        __m128d sideB(_mm_sub_pd(left, right));
+        isCertain = _mm_and_pd(isCertain, isCertainSse2(left, right, sideB, bound));
+        left = _mm_mul_pd(apx, bpy);
+        right = _mm_mul_pd(apy, bpx);
+        __m128d sideC(_mm_sub_pd(left, right));
+        isCertain = _mm_and_pd(isCertain, isCertainSse2(left, right, sideC, bound));
+
+        // Inside if no edge has the point on the side opposite to the orientation of the triangle.
+        __m128d positive(_mm_and_pd(_mm_cmpgt_pd(side, zero), _mm_and_pd(_mm_cmpge_pd(sideA, zero), _mm_and_pd(_mm_cmpge_pd(sideB, zero), _mm_cmpge_pd(sideC, zero)))));
+        __m128d negative(_mm_and_pd(_mm_cmplt_pd(side, zero), _mm_and_pd(_mm_cmple_pd(sideA, zero), _mm_and_pd(_mm_cmple_pd(sideB, zero), _mm_cmple_pd(sideC, zero)))));
+        int mask(_mm_movemask_pd(_mm_or_pd(positive, negative))), certain(_mm_movemask_pd(isCertain));
+        for (int k = 0; k < 2; ++k)
+        {
+            inside[i + k] = ((certain >> k) & 1) ? (mask >> k) & 1 : triangleScalar(in, broadcast, i + k);
+            decided += (certain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(4ULL * decided, 0); // The others were counted by the scalar test.
+    return i;
+}
+
+__attribute__((target("sse2"))) static int circleSse2(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m128d zero(_mm_setzero_pd()), orientationBound(_mm_set1_pd(Predicates::ORIENTATION_BOUND)), inCircleBound(_mm_set1_pd(Predicates::IN_CIRCLE_BOUND));
+    int i(0), decided(0); // decided counts the elements the filters settled.
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128d px(loadSse2(in[0], broadcast & 1, i)), py(loadSse2(in[1], broadcast & 2, i));
+        __m128d ax(loadSse2(in[2], broadcast & 4, i)), ay(loadSse2(in[3], broadcast & 8, i));
+        __m128d bx(loadSse2(in[4], broadcast & 16, i)), by(loadSse2(in[5], broadcast & 32, i));
+        __m128d cx(loadSse2(in[6], broadcast & 64, i)), cy(loadSse2(in[7], broadcast & 128, i));
+
+        // Orientation of the triangle, with C as the pivot.
+        __m128d left(_mm_mul_pd(_mm_sub_pd(ax, cx), _mm_sub_pd(by, cy))), right(_mm_mul_pd(_mm_sub_pd(ay, cy), _mm_sub_pd(bx, cx)));
+        __m128d side(_mm_sub_pd(left, right)), isCertain(isCertainSse2(left, right, side, orientationBound));
+
+        // In-circle determinant with the point as the pivot.
+        __m128d adx(_mm_sub_pd(ax, px)), ady(_mm_sub_pd(ay, py)), bdx(_mm_sub_pd(bx, px)), bdy(_mm_sub_pd(by, py)), cdx(_mm_sub_pd(cx, px)), cdy(_mm_sub_pd(cy, py));
+        __m128d bdxcdy(_mm_mul_pd(bdx, cdy)), cdxbdy(_mm_mul_pd(cdx, bdy)), aLift(_mm_add_pd(_mm_mul_pd(adx, adx), _mm_mul_pd(ady, ady)));
+        __m128d cdxady(_mm_mul_pd(cdx, ady)), adxcdy(_mm_mul_pd(adx, cdy)), bLift(_mm_add_pd(_mm_mul_pd(bdx, bdx), _mm_mul_pd(bdy, bdy)));
+        __m128d adxbdy(_mm_mul_pd(adx, bdy)), bdxady(_mm_mul_pd(bdx, ady)), cLift(_mm_add_pd(_mm_mul_pd(cdx, cdx), _mm_mul_pd(cdy, cdy)));
+        __m128d determinant(_mm_add_pd(_mm_add_pd(_mm_mul_pd(aLift, _mm_sub_pd(bdxcdy, cdxbdy)), _mm_mul_pd(bLift, _mm_sub_pd(cdxady, adxcdy))), _mm_mul_pd(cLift, _mm_sub_pd(adxbdy, bdxady))));
+        __m128d permanent(_mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_add_pd(absSse2(bdxcdy), absSse2(cdxbdy)), aLift), _mm_mul_pd(_mm_add_pd(absSse2(cdxady), absSse2(adxcdy)), bLift)), _mm_mul_pd(_mm_add_pd(absSse2(adxbdy), absSse2(bdxady)), cLift)));
+        isCertain = _mm_and_pd(isCertain, _mm_cmpgt_pd(absSse2(determinant), _mm_mul_pd(inCircleBound, permanent)));
+
+        // Inside or on the circle if the determinant does not have the opposite sign of the orientation.
+        __m128d positive(_mm_and_pd(_mm_cmpgt_pd(side, zero), _mm_cmpge_pd(determinant, zero)));
+        __m128d negative(_mm_and_pd(_mm_cmplt_pd(side, zero), _mm_cmple_pd(determinant, zero)));
+        int mask(_mm_movemask_pd(_mm_or_pd(positive, negative))), certain(_mm_movemask_pd(isCertain));
+        for (int k = 0; k < 2; ++k)
+        {
+            inside[i + k] = ((certain >> k) & 1) ? (mask >> k) & 1 : circleScalar(in, broadcast, i + k);
+            decided += (certain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(decided, decided);
+    return i;
+}
+
+/*
+    AVX2 versions, four elements at a time.
+*/
+__attribute__((target("avx2"))) static inline __m256d loadAvx2(const float *p, bool isBroadcast, int i)
+{
+    return isBroadcast ? _mm256_set1_pd(*p) : _mm256_cvtps_pd(_mm_loadu_ps(p + i));
+}
+
+__attribute__((target("avx2"))) static inline __m256d absAvx2(__m256d x)
+{
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+}
+
+__attribute__((target("avx2"))) static inline __m256d isCertainAvx2(__m256d left, __m256d right, __m256d determinant, __m256d bound)
+{
+    return _mm256_cmp_pd(absAvx2(determinant), _mm256_mul_pd(bound, _mm256_add_pd(absAvx2(left), absAvx2(right))), _CMP_GE_OQ);
+}
+
+__attribute__((target("avx2"))) static int triangleAvx2(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m256d zero(_mm256_setzero_pd()), bound(_mm256_set1_pd(Predicates::ORIENTATION_BOUND));
+    int i(0), decided(0);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d px(loadAvx2(in[0], broadcast & 1, i)), py(loadAvx2(in[1], broadcast & 2, i));
+        __m256d ax(loadAvx2(in[2], broadcast & 4, i)), ay(loadAvx2(in[3], broadcast & 8, i));
+        __m256d bx(loadAvx2(in[4], broadcast & 16, i)), by(loadAvx2(in[5], broadcast & 32, i));
+        __m256d cx(loadAvx2(in[6], broadcast & 64, i)), cy(loadAvx2(in[7], broadcast & 128, i));
+
+        __m256d left(_mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(by, cy))), right(_mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(bx, cx)));
+        __m256d side(_mm256_sub_pd(left, right)), isCertain(isCertainAvx2(left, right, side, bound));
+
+        __m256d apx(_mm256_sub_pd(ax, px)), apy(_mm256_sub_pd(ay, py)), bpx(_mm256_sub_pd(bx, px)), bpy(_mm256_sub_pd(by, py)), cpx(_mm256_sub_pd(cx, px)), cpy(_mm256_sub_pd(cy, py));
+        left = _mm256_mul_pd(bpx, cpy);
+        right = _mm256_mul_pd(bpy, cpx);
+        __m256d sideA(_mm256_sub_pd(left, right));
+        isCertain = _mm256_and_pd(isCertain, isCertainAvx2(left, right, sideA, bound));
+        left = _mm256_mul_pd(cpx, apy);
+        right = _mm256_mul_pd(cpy, apx);
+        __m256d sideB(_mm256_sub_pd(left, right));
+        isCertain = _mm256_and_pd(isCertain, isCertainAvx2(left, right, sideB, bound));
+        left = _mm256_mul_pd(apx, bpy);
+        right = _mm256_mul_pd(apy, bpx);
+        __m256d sideC(_mm256_sub_pd(left, right));
+        isCertain = _mm256_and_pd(isCertain, isCertainAvx2(left, right, sideC, bound));
+
+        __m256d positive(_mm256_and_pd(_mm256_cmp_pd(side, zero, _CMP_GT_OQ), _mm256_and_pd(_mm256_cmp_pd(sideA, zero, _CMP_GE_OQ), _mm256_and_pd(_mm256_cmp_pd(sideB, zero, _CMP_GE_OQ), _mm256_cmp_pd(sideC, zero, _CMP_GE_OQ)))));
+        __m256d negative(_mm256_and_pd(_mm256_cmp_pd(side, zero, _CMP_LT_OQ), _mm256_and_pd(_mm256_cmp_pd(sideA, zero, _CMP_LE_OQ), _mm256_and_pd(_mm256_cmp_pd(sideB, zero, _CMP_LE_OQ), _mm256_cmp_pd(sideC, zero, _CMP_LE_OQ)))));
+        int mask(_mm256_movemask_pd(_mm256_or_pd(positive, negative))), certain(_mm256_movemask_pd(isCertain));
+        for (int k = 0; k < 4; ++k)
+        {
+            inside[i + k] = ((certain >> k) & 1) ? (mask >> k) & 1 : triangleScalar(in, broadcast, i + k);
+            decided += (certain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(4ULL * decided, 0); // The others were counted by the scalar test.
+    return i;
+}
+
+__attribute__((target("avx2"))) static int circleAvx2(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m256d zero(_mm256_setzero_pd()), orientationBound(_mm256_set1_pd(Predicates::ORIENTATION_BOUND)), inCircleBound(_mm256_set1_pd(Predicates::IN_CIRCLE_BOUND));
+    int i(0), decided(0);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256d px(loadAvx2(in[0], broadcast & 1, i)), py(loadAvx2(in[1], broadcast & 2, i));
+        __m256d ax(loadAvx2(in[2], broadcast & 4, i)), ay(loadAvx2(in[3], broadcast & 8, i));
+        __m256d bx(loadAvx2(in[4], broadcast & 16, i)), by(loadAvx2(in[5], broadcast & 32, i));
+        __m256d cx(loadAvx2(in[6], broadcast & 64, i)), cy(loadAvx2(in[7], broadcast & 128, i));
+
+        __m256d left(_mm256_mul_pd(_mm256_sub_pd(ax, cx), _mm256_sub_pd(by, cy))), right(_mm256_mul_pd(_mm256_sub_pd(ay, cy), _mm256_sub_pd(bx, cx)));
+        __m256d side(_mm256_sub_pd(left, right)), isCertain(isCertainAvx2(left, right, side, orientationBound));
+
+        __m256d adx(_mm256_sub_pd(ax, px)), ady(_mm256_sub_pd(ay, py)), bdx(_mm256_sub_pd(bx, px)), bdy(_mm256_sub_pd(by, py)), cdx(_mm256_sub_pd(cx, px)), cdy(_mm256_sub_pd(cy, py));
+        __m256d bdxcdy(_mm256_mul_pd(bdx, cdy)), cdxbdy(_mm256_mul_pd(cdx, bdy)), aLift(_mm256_add_pd(_mm256_mul_pd(adx, adx), _mm256_mul_pd(ady, ady)));
+        __m256d cdxady(_mm256_mul_pd(cdx, ady)), adxcdy(_mm256_mul_pd(adx, cdy)), bLift(_mm256_add_pd(_mm256_mul_pd(bdx, bdx), _mm256_mul_pd(bdy, bdy)));
+        __m256d adxbdy(_mm256_mul_pd(adx, bdy)), bdxady(_mm256_mul_pd(bdx, ady)), cLift(_mm256_add_pd(_mm256_mul_pd(cdx, cdx), _mm256_mul_pd(cdy, cdy)));
+        __m256d determinant(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(aLift, _mm256_sub_pd(bdxcdy, cdxbdy)), _mm256_mul_pd(bLift, _mm256_sub_pd(cdxady, adxcdy))), _mm256_mul_pd(cLift, _mm256_sub_pd(adxbdy, bdxady))));
+        __m256d permanent(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(absAvx2(bdxcdy), absAvx2(cdxbdy)), aLift), _mm256_mul_pd(_mm256_add_pd(absAvx2(cdxady), absAvx2(adxcdy)), bLift)), _mm256_mul_pd(_mm256_add_pd(absAvx2(adxbdy), absAvx2(bdxady)), cLift)));
+        isCertain = _mm256_and_pd(isCertain, _mm256_cmp_pd(absAvx2(determinant), _mm256_mul_pd(inCircleBound, permanent), _CMP_GT_OQ));
+
+        __m256d positive(_mm256_and_pd(_mm256_cmp_pd(side, zero, _CMP_GT_OQ), _mm256_cmp_pd(determinant, zero, _CMP_GE_OQ)));
+        __m256d negative(_mm256_and_pd(_mm256_cmp_pd(side, zero, _CMP_LT_OQ), _mm256_cmp_pd(determinant, zero, _CMP_LE_OQ)));
+        int mask(_mm256_movemask_pd(_mm256_or_pd(positive, negative))), certain(_mm256_movemask_pd(isCertain));
+        for (int k = 0; k < 4; ++k)
+        {
+            inside[i + k] = ((certain >> k) & 1) ? (mask >> k) & 1 : circleScalar(in, broadcast, i + k);
+            decided += (certain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(decided, decided);
+    return i;
+}
+
+/*
+    AVX-512 versions, eight elements at a time.
+*/
+__attribute__((target("avx512f"))) static inline __m512d loadAvx512(const float *p, bool isBroadcast, int i)
+{
+    return isBroadcast ? _mm512_set1_pd(*p) : _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p + i)); // Same as _mm512_cvtps_pd, which makes GCC 12 warn about its own header.
+}
+
+__attribute__((target("avx512f"))) static inline __m512d absAvx512(__m512d x) // Clears the sign bits.
+{
+    return _mm512_castsi512_pd(_mm512_and_epi64(_mm512_castpd_si512(x), _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL)));
+}
+
+__attribute__((target("avx512f"))) static inline __mmask8 isCertainAvx512(__m512d left, __m512d right, __m512d determinant, __m512d bound)
+{
+    return _mm512_cmp_pd_mask(absAvx512(determinant), _mm512_mul_pd(bound, _mm512_add_pd(absAvx512(left), absAvx512(right))), _CMP_GE_OQ);
+}
+
+__attribute__((target("avx512f"))) static int triangleAvx512(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m512d zero(_mm512_setzero_pd()), bound(_mm512_set1_pd(Predicates::ORIENTATION_BOUND));
+    int i(0), decided(0);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512d px(loadAvx512(in[0], broadcast & 1, i)), py(loadAvx512(in[1], broadcast & 2, i));
+        __m512d ax(loadAvx512(in[2], broadcast & 4, i)), ay(loadAvx512(in[3], broadcast & 8, i));
+        __m512d bx(loadAvx512(in[4], broadcast & 16, i)), by(loadAvx512(in[5], broadcast & 32, i));
+        __m512d cx(loadAvx512(in[6], broadcast & 64, i)), cy(loadAvx512(in[7], broadcast & 128, i));
+
+        __m512d left(_mm512_mul_pd(_mm512_sub_pd(ax, cx), _mm512_sub_pd(by, cy))), right(_mm512_mul_pd(_mm512_sub_pd(ay, cy), _mm512_sub_pd(bx, cx)));
+        __m512d side(_mm512_sub_pd(left, right));
+        __mmask8 isCertain(isCertainAvx512(left, right, side, bound));
+
+        __m512d apx(_mm512_sub_pd(ax, px)), apy(_mm512_sub_pd(ay, py)), bpx(_mm512_sub_pd(bx, px)), bpy(_mm512_sub_pd(by, py)), cpx(_mm512_sub_pd(cx, px)), cpy(_mm512_sub_pd(cy, py));
+        left = _mm512_mul_pd(bpx, cpy);
+        right = _mm512_mul_pd(bpy, cpx);
+        __m512d sideA(_mm512_sub_pd(left, right));
+        isCertain &= isCertainAvx512(left, right, sideA, bound);
+        left = _mm512_mul_pd(cpx, apy);
+        right = _mm512_mul_pd(cpy, apx);
+        __m512d sideB(_mm512_sub_pd(left, right));
+        isCertain &= isCertainAvx512(left, right, sideB, bound);
+        left = _mm512_mul_pd(apx, bpy);
+        right = _mm512_mul_pd(apy, bpx);
+        __m512d sideC(_mm512_sub_pd(left, right));
+        isCertain &= isCertainAvx512(left, right, sideC, bound);
+
+        __mmask8 positive(_mm512_cmp_pd_mask(side, zero, _CMP_GT_OQ) & _mm512_cmp_pd_mask(sideA, zero, _CMP_GE_OQ) & _mm512_cmp_pd_mask(sideB, zero, _CMP_GE_OQ) & _mm512_cmp_pd_mask(sideC, zero, _CMP_GE_OQ));
+        __mmask8 negative(_mm512_cmp_pd_mask(side, zero, _CMP_LT_OQ) & _mm512_cmp_pd_mask(sideA, zero, _CMP_LE_OQ) & _mm512_cmp_pd_mask(sideB, zero, _CMP_LE_OQ) & _mm512_cmp_pd_mask(sideC, zero, _CMP_LE_OQ));
+        int mask(positive | negative);
+        for (int k = 0; k < 8; ++k)
+        {
+            inside[i + k] = ((isCertain >> k) & 1) ? (mask >> k) & 1 : triangleScalar(in, broadcast, i + k);
+            decided += (isCertain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(4ULL * decided, 0); // The others were counted by the scalar test.
+    return i;
+}
+
+__attribute__((target("avx512f"))) static int circleAvx512(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    const __m512d zero(_mm512_setzero_pd()), orientationBound(_mm512_set1_pd(Predicates::ORIENTATION_BOUND)), inCircleBound(_mm512_set1_pd(Predicates::IN_CIRCLE_BOUND));
+    int i(0), decided(0);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512d px(loadAvx512(in[0], broadcast & 1, i)), py(loadAvx512(in[1], broadcast & 2, i));
+        __m512d ax(loadAvx512(in[2], broadcast & 4, i)), ay(loadAvx512(in[3], broadcast & 8, i));
+        __m512d bx(loadAvx512(in[4], broadcast & 16, i)), by(loadAvx512(in[5], broadcast & 32, i));
+        __m512d cx(loadAvx512(in[6], broadcast & 64, i)), cy(loadAvx512(in[7], broadcast & 128, i));
+
+        __m512d left(_mm512_mul_pd(_mm512_sub_pd(ax, cx), _mm512_sub_pd(by, cy))), right(_mm512_mul_pd(_mm512_sub_pd(ay, cy), _mm512_sub_pd(bx, cx)));
+        __m512d side(_mm512_sub_pd(left, right));
+        __mmask8 isCertain(isCertainAvx512(left, right, side, orientationBound));
+
+        __m512d adx(_mm512_sub_pd(ax, px)), ady(_mm512_sub_pd(ay, py)), bdx(_mm512_sub_pd(bx, px)), bdy(_mm512_sub_pd(by, py)), cdx(_mm512_sub_pd(cx, px)), cdy(_mm512_sub_pd(cy, py));
+        __m512d bdxcdy(_mm512_mul_pd(bdx, cdy)), cdxbdy(_mm512_mul_pd(cdx, bdy)), aLift(_mm512_add_pd(_mm512_mul_pd(adx, adx), _mm512_mul_pd(ady, ady)));
+        __m512d cdxady(_mm512_mul_pd(cdx, ady)), adxcdy(_mm512_mul_pd(adx, cdy)), bLift(_mm512_add_pd(_mm512_mul_pd(bdx, bdx), _mm512_mul_pd(bdy, bdy)));
+        __m512d adxbdy(_mm512_mul_pd(adx, bdy)), bdxady(_mm512_mul_pd(bdx, ady)), cLift(_mm512_add_pd(_mm512_mul_pd(cdx, cdx), _mm512_mul_pd(cdy, cdy)));
+        __m512d determinant(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(aLift, _mm512_sub_pd(bdxcdy, cdxbdy)), _mm512_mul_pd(bLift, _mm512_sub_pd(cdxady, adxcdy))), _mm512_mul_pd(cLift, _mm512_sub_pd(adxbdy, bdxady))));
+        __m512d permanent(_mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(absAvx512(bdxcdy), absAvx512(cdxbdy)), aLift), _mm512_mul_pd(_mm512_add_pd(absAvx512(cdxady), absAvx512(adxcdy)), bLift)), _mm512_mul_pd(_mm512_add_pd(absAvx512(adxbdy), absAvx512(bdxady)), cLift)));
+        isCertain &= _mm512_cmp_pd_mask(absAvx512(determinant), _mm512_mul_pd(inCircleBound, permanent), _CMP_GT_OQ);
+
+        __mmask8 positive(_mm512_cmp_pd_mask(side, zero, _CMP_GT_OQ) & _mm512_cmp_pd_mask(determinant, zero, _CMP_GE_OQ));
+        __mmask8 negative(_mm512_cmp_pd_mask(side, zero, _CMP_LT_OQ) & _mm512_cmp_pd_mask(determinant, zero, _CMP_LE_OQ));
+        int mask(positive | negative);
+        for (int k = 0; k < 8; ++k)
+        {
+            inside[i + k] = ((isCertain >> k) & 1) ? (mask >> k) & 1 : circleScalar(in, broadcast, i + k);
+            decided += (isCertain >> k) & 1;
+        }
+    }
+    Predicates::countFilteredTests(decided, decided);
+    return i;
+}
+
+#endif
+
+/*
+    The code path in use. It starts as the best one the processor supports.
+*/
+static std::atomic<int> &selectedInstructionSet()
+{
+    static std::atomic<int> selected(BatchKernels::detect()); // Initialised once, safely even with several threads.
+    return selected;
+}
+
+/*
+    The following functions run the selected vector kernel over as many whole vectors as fit and finish the
+    remaining elements with the scalar code.
+*/
+static void runTriangles(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    int done(0);
+#ifdef BATCHKERNELS_X86
+    switch (selectedInstructionSet().load(std::memory_order_relaxed))
+    {
+    case BatchKernels::AVX512:
+        done = triangleAvx512(in, broadcast, count, inside);
+        break;
+    case BatchKernels::AVX2:
+        done = triangleAvx2(in, broadcast, count, inside);
+        break;
+    case BatchKernels::SSE2:
+        done = triangleSse2(in, broadcast, count, inside);
+        break;
+    default:
+        break;
+    }
+#endif
+    for (int i = done; i < count; ++i)
+    {
+        inside[i] = triangleScalar(in, broadcast, i);
+    }
+}
+
+static void runCircles(const float *const in[8], unsigned int broadcast, int count, unsigned char *inside)
+{
+    int done(0);
+#ifdef BATCHKERNELS_X86
+    switch (selectedInstructionSet().load(std::memory_order_relaxed))
+    {
+    case BatchKernels::AVX512:
+        done = circleAvx512(in, broadcast, count, inside);
+        break;
+    case BatchKernels::AVX2:
+        done = circleAvx2(in, broadcast, count, inside);
+        break;
+    case BatchKernels::SSE2:
+        done = circleSse2(in, broadcast, count, inside);
+        break;
+    default:
+        break;
+    }
+#endif
+    for (int i = done; i < count; ++i)
+    {
+        inside[i] = circleScalar(in, broadcast, i);
+    }
+}
+
+/*
+    Tests one point against count triangles. The output is written to inside.
+*/
+void BatchKernels::pointInTriangles(float px, float py, const float *ax, const float *ay, const float *bx, const float *by, const float *cx, const float *cy, int count, unsigned char *inside)
+{
+    const float *in[8] = {&px, &py, ax, ay, bx, by, cx, cy};
+    runTriangles(in, 1 | 2, count, inside); // The point is the same for every element.
+}
+
+/*
+    Tests count points against one triangle. The output is written to inside.
+*/
+void BatchKernels::pointsInTriangle(const float *px, const float *py, int count, float ax, float ay, float bx, float by, float cx, float cy, unsigned char *inside)
+{
+    const float *in[8] = {px, py, &ax, &ay, &bx, &by, &cx, &cy};
+    runTriangles(in, 0xFC, count, inside); // The triangle is the same for every element.
+}
+
+/*
+    Tests one point against the circumcircles of count triangles. The output is written to inside.
+*/
+void BatchKernels::pointInCircumcircles(float px, float py, const float *ax, const float *ay, const float *bx, const float *by, const float *cx, const float *cy, int count, unsigned char *inside)
+{
+    const float *in[8] = {&px, &py, ax, ay, bx, by, cx, cy};
+    runCircles(in, 1 | 2, count, inside);
+}
+
+/*
+    Tests count points against the circumcircle of one triangle. The output is written to inside.
+*/
+void BatchKernels::pointsInCircumcircle(const float *px, const float *py, int count, float ax, float ay, float bx, float by, float cx, float cy, unsigned char *inside)
+{
+    const float *in[8] = {px, py, &ax, &ay, &bx, &by, &cx, &cy};
+    runCircles(in, 0xFC, count, inside);
+}
+
+/*
+    The following method finds the best code path supported by the processor this program runs on.
+*/
+BatchKernels::InstructionSet BatchKernels::detect()
+{
+#ifdef BATCHKERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SSE2;
+    }
+#endif
+    return SCALAR;
+}
+
+BatchKernels::InstructionSet BatchKernels::getInstructionSet() // Returns the code path in use.
+{
+    return (InstructionSet)selectedInstructionSet().load();
+}
+
+/*
+    The following method forces a code path. A path the processor does not support is lowered to the best one it does.
+*/
+void BatchKernels::setInstructionSet(InstructionSet instructionSet)
+{
+    InstructionSet best(detect());
+    selectedInstructionSet().store(instructionSet > best ? best : instructionSet);
+}
+
+const char *BatchKernels::getInstructionSetName() // Returns a printable name of the code path in use.
+{
+    static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+    return names[getInstructionSet()];
+}
@@ -0,0 +1,38 @@
+#ifndef BATCHKERNELS_H
+#define BATCHKERNELS_H
+
+/*
+    The following BatchKernels class provides the point-in-triangle and point-in-circumcircle tests for many
+    inputs at once. Either one point is tested against many triangles (or circles), or many points against one.
+    The inputs are flat float arrays. The work is done with AVX-512, AVX2 or SSE2 depending on what the processor
+    supports, which is checked once at run time, and with plain scalar code otherwise.
+    The vector code evaluates the floating point filters of the predicates (see Predicates) in double precision.
+    Elements the filters cannot decide are handed to the scalar tests in Triangle, which fall back to exact
+    arithmetic, so the results are always those of the exact tests. The output is one byte per input, 1 for inside
+    or on the boundary.
+*/
+class BatchKernels
+{
+public:
+    enum InstructionSet { SCALAR, SSE2, AVX2, AVX512 }; // Code paths, from slowest to fastest.
+
+    // One point (px, py) against count triangles given by the coordinates of their vertices A, B and C.
+    static void pointInTriangles(float px, float py, const float *ax, const float *ay, const float *bx, const float *by, const float *cx, const float *cy, int count, unsigned char *inside);
+
+    // count points against the one triangle A, B, C.
+    static void pointsInTriangle(const float *px, const float *py, int count, float ax, float ay, float bx, float by, float cx, float cy, unsigned char *inside);
+
+    // One point against the circumcircles of count triangles given by the coordinates of their vertices.
+    static void pointInCircumcircles(float px, float py, const float *ax, const float *ay, const float *bx, const float *by, const float *cx, const float *cy, int count, unsigned char *inside);
+
+    // count points against the circumcircle of one triangle.
+    static void pointsInCircumcircle(const float *px, const float *py, int count, float ax, float ay, float bx, float by, float cx, float cy, unsigned char *inside);
+
+    static InstructionSet getInstructionSet(); // The code path in use.
+    static void setInstructionSet(InstructionSet instructionSet); // Forces a code path, limited to what the processor supports. Used for testing.
+    static const char *getInstructionSetName(); // Name of the code path in use, for reports.
+
+    static InstructionSet detect(); // Finds the best code path this processor supports.
+};
+
+#endif
@@ -0,0 +1,372 @@
+#include "Triangulation.h"
+#include "MeshGenerator.h"
+#include <chrono> // Timing of the operations.
+#include <random> // Query points.
+#include <string> // Command line and file names.
+#include <sstream> // Parsing of the list of sizes.
+#include <cstdio> // std::remove for the temporary files.
+#include <cstdlib> // malloc and free behind the counting operator new.
+#include <new> // std::bad_alloc.
+#include <atomic> // Counters of the operator new replacement, shared by all threads.
+
+/*
+    Times the main operations of the interface on generated meshes and writes the results as JSON, so that the
+    output of successive runs can be compared by a script. Usage:
+
+        triangulation_benchmark [--sizes 1000,10000,...] [--distribution grid|uniform|clustered|cocircular]
+                                [--min-time seconds] [--threads n] [--output file]
+
+    For every size a mesh of at least that many cells is written as a .tri file by MeshGenerator, by default the
+    regular grid. Every operation is repeated until it has run for at least the minimum time. The results are
+    the time per operation, the operations per second and the bytes (and number) of heap allocations made per
+    operation. Progress is reported on std::cerr.
+*/
+
+/*
+    Every heap allocation of the program goes through the following replacements of the global operator new, which
+    count the allocations and their bytes. Only the counts taken while an operation is timed are reported.
+*/
+static std::atomic<unsigned long long> allocatedBytes(0), allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *pointer(std::malloc(size > 0 ? size : 1));
+    if (pointer == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+/*
+    The following Stopwatch class adds up the time and the allocations of the timed parts of an operation. Each run
+    of an operation calls start() and stop() around the part to measure, so that preparing the input is left out.
+*/
+class Stopwatch
+{
+public:
+    Stopwatch() : seconds(0.0), bytes(0), allocations(0), startBytes(0), startAllocations(0) {;}
+
+    void start()
+    {
+        startBytes = allocatedBytes.load(std::memory_order_relaxed);
+        startAllocations = allocationCount.load(std::memory_order_relaxed);
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        std::chrono::steady_clock::time_point stopTime(std::chrono::steady_clock::now());
+        seconds += std::chrono::duration<double>(stopTime - startTime).count();
+        bytes += allocatedBytes.load(std::memory_order_relaxed) - startBytes;
+        allocations += allocationCount.load(std::memory_order_relaxed) - startAllocations;
+    }
+
+    double seconds; // Total time of the timed parts.
+    unsigned long long bytes, allocations; // Total heap allocations during the timed parts.
+
+private:
+    std::chrono::steady_clock::time_point startTime;
+    unsigned long long startBytes, startAllocations;
+};
+
+struct BenchmarkResult // One line of the report.
+{
+    std::string name;
+    int cells;
+    long long operations;
+    double seconds;
+    unsigned long long bytes, allocations;
+};
+
+/*
+    Runs operation until the timed parts add up to minimumTime, at least once. Each run counts as
+    operationsPerRun operations, for example the number of query points it tests.
+*/
+template<typename T>
+BenchmarkResult measure(const char *name, int cells, long long operationsPerRun, double minimumTime, T operation)
+{
+    Stopwatch stopwatch;
+    long long runs(0);
+    do
+    {
+        operation(stopwatch);
+        ++runs;
+    } while (stopwatch.seconds < minimumTime);
+
+    BenchmarkResult result;
+    result.name = name;
+    result.cells = cells;
+    result.operations = runs * operationsPerRun;
+    result.seconds = stopwatch.seconds;
+    result.bytes = stopwatch.bytes;
+    result.allocations = stopwatch.allocations;
+    std::cerr << "  " << name << ": " << (result.seconds * 1e9 / result.operations) << " ns/op\n";
+    return result;
+}
+
+struct linear { // Function integrated by the benchmarks.
+    float operator()(float x, float y) {
+        return x + 2 * y;
+    }
+};
+
+/*
+    Runs every benchmark on a mesh of about the given number of cells and appends the results.
+*/
+static bool runBenchmarks(int targetCells, MeshGenerator::Distribution distribution, double minimumTime, int numberOfThreads, std::vector<BenchmarkResult> &results)
+{
+    const char *meshName("benchmark_mesh.tri"), *writtenName("benchmark_written.tri");
+    MeshGenerator generator(distribution, targetCells);
+    int cells(generator.getNumberOfCells());
+    std::ofstream myMesh(meshName, std::ios::binary);
+    if (!generator.write(myMesh))
+    {
+        std::cerr << "Unable to write " << meshName << ".\n";
+        return false;
+    }
+    myMesh.close();
+    std::cerr << cells << " cells:\n";
+
+    results.push_back(measure("operator>>", cells, 1, minimumTime, [&](Stopwatch &stopwatch) {
+        Triangulation *myTriangulation(new Triangulation);
+        std::ifstream myFile(meshName);
+        stopwatch.start();
+        myFile >> *myTriangulation;
+        stopwatch.stop();
+        delete myTriangulation;
+    }));
+
+    Triangulation myTriangulation; // The mesh the remaining operations work on.
+    std::ifstream myFile(meshName);
+    myFile >> myTriangulation;
+
+    results.push_back(measure("operator<<", cells, 1, minimumTime, [&](Stopwatch &stopwatch) {
+        std::ofstream myOutput(writtenName);
+        stopwatch.start();
+        myOutput << myTriangulation;
+        myOutput.close(); // Includes writing the last of the data.
+        stopwatch.stop();
+    }));
+    std::remove(writtenName);
+
+    // Query points spread over the bounding box of the mesh, the same for every run.
+    PackedMesh &packed(myTriangulation.getPackedMesh());
+    float *pointX(packed.getX()), *pointY(packed.getY());
+    float minimumX(pointX[0]), maximumX(pointX[0]), minimumY(pointY[0]), maximumY(pointY[0]);
+    for (int i = 1; i < packed.getNumberOfPoints(); ++i)
+    {
+        minimumX = std::min(minimumX, pointX[i]);
+        maximumX = std::max(maximumX, pointX[i]);
+        minimumY = std::min(minimumY, pointY[i]);
+        maximumY = std::max(maximumY, pointY[i]);
+    }
+    const int numberOfQueries(1024);
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> xDistribution(minimumX, maximumX), yDistribution(minimumY, maximumY);
+    std::vector<Vertex> queries;
+    for (int i = 0; i < numberOfQueries; ++i)
+    {
+        float x(xDistribution(random)), y(yDistribution(random));
+        queries.push_back(Vertex(x, y, 0.0f));
+    }
+
+    std::vector<Triangle*> inTriangles;
+    inTriangles.reserve(64);
+    myTriangulation.isPointInAnyTriangle(queries[0], inTriangles); // Builds the point location grid outside the timing.
+    results.push_back(measure("isPointInAnyTriangle", cells, numberOfQueries, minimumTime, [&](Stopwatch &stopwatch) {
+        stopwatch.start();
+        for (int i = 0; i < numberOfQueries; ++i)
+        {
+            inTriangles.clear();
+            myTriangulation.isPointInAnyTriangle(queries[i], inTriangles);
+        }
+        stopwatch.stop();
+    }));
+
+    // Each query tests every triangle, so fewer are used on the large meshes.
+    int numberOfCircleQueries(std::max(1, std::min(numberOfQueries, 4000000 / cells)));
+    results.push_back(measure("isPointInCircumcircle", cells, numberOfCircleQueries, minimumTime, [&](Stopwatch &stopwatch) {
+        stopwatch.start();
+        for (int i = 0; i < numberOfCircleQueries; ++i)
+        {
+            inTriangles.clear();
+            myTriangulation.isPointInCircumcircle(queries[i], inTriangles);
+        }
+        stopwatch.stop();
+    }));
+
+    bool isDelaunay(true);
+    results.push_back(measure("isDelaunay", cells, 1, minimumTime, [&](Stopwatch &stopwatch) {
+        stopwatch.start();
+        isDelaunay = myTriangulation.isDelaunay(numberOfThreads) && isDelaunay;
+        stopwatch.stop();
+    }));
+    if (!isDelaunay)
+    {
+        std::cerr << "  The generated mesh should be Delaunay.\n";
+    }
+
+    linear myLinear;
+    volatile float sum(0.0f); // Keeps the results from being optimised away.
+    results.push_back(measure("integration/constant", cells, 1, minimumTime, [&](Stopwatch &stopwatch) {
+        stopwatch.start();
+        sum = sum + myTriangulation.integration(myLinear, true);
+        stopwatch.stop();
+    }));
+    results.push_back(measure("integration/linear", cells, 1, minimumTime, [&](Stopwatch &stopwatch) {
+        stopwatch.start();
+        sum = sum + myTriangulation.integration(myLinear, false);
+        stopwatch.stop();
+    }));
+
+    std::remove(meshName);
+    return true;
+}
+
+/*
+    Writes the results as one JSON object: the settings of the run followed by one entry per operation and size.
+*/
+static void writeJson(std::ostream &myOutput, const std::vector<BenchmarkResult> &results, MeshGenerator::Distribution distribution, double minimumTime, int numberOfThreads)
+{
+    myOutput.precision(6);
+    myOutput << "{\n";
+    myOutput << "  \"context\": {\n";
+    myOutput << "    \"instruction_set\": \"" << BatchKernels::getInstructionSetName() << "\",\n";
+    myOutput << "    \"distribution\": \"" << MeshGenerator::getName(distribution) << "\",\n";
+    myOutput << "    \"threads\": " << getNumberOfThreads(numberOfThreads) << ",\n";
+    myOutput << "    \"min_time\": " << minimumTime << "\n";
+    myOutput << "  },\n";
+    myOutput << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult &result(results[i]);
+        double operations((double)result.operations);
+        myOutput << (i > 0 ? ",\n" : "\n");
+        myOutput << "    {\"name\": \"" << result.name << "\", \"cells\": " << result.cells;
+        myOutput << ", \"iterations\": " << result.operations;
+        myOutput << ", \"ns_per_op\": " << (result.seconds * 1e9 / operations);
+        myOutput << ", \"ops_per_sec\": " << (result.seconds > 0.0 ? operations / result.seconds : 0.0);
+        myOutput << ", \"bytes_allocated_per_op\": " << (result.bytes / operations);
+        myOutput << ", \"allocations_per_op\": " << (result.allocations / operations) << "}";
+    }
+    myOutput << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    // Defaults: 1K to 1M cells. 10000000 can be added with --sizes on machines with several GB of free memory.
+    std::vector<int> sizes;
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+    sizes.push_back(100000);
+    sizes.push_back(1000000);
+    double minimumTime(0.5);
+    int numberOfThreads(0);
+    MeshGenerator::Distribution distribution(MeshGenerator::GRID);
+    std::string outputName;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument(argv[i]);
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << argument << ".\n";
+            return -1;
+        }
+        std::string value(argv[++i]);
+        if (argument == "--sizes")
+        {
+            sizes.clear();
+            std::stringstream list(value);
+            std::string size;
+            while (std::getline(list, size, ','))
+            {
+                int cells(std::atoi(size.c_str()));
+                if (cells < 2)
+                {
+                    std::cerr << "Invalid size " << size << ".\n";
+                    return -1;
+                }
+                sizes.push_back(cells);
+            }
+        }
+        else if (argument == "--min-time")
+        {
+            minimumTime = std::atof(value.c_str());
+        }
+        else if (argument == "--distribution")
+        {
+            if (!MeshGenerator::parseDistribution(value.c_str(), distribution))
+            {
+                std::cerr << "Unknown distribution " << value << ".\n";
+                return -1;
+            }
+        }
+        else if (argument == "--threads")
+        {
+            numberOfThreads = std::atoi(value.c_str());
+        }
+        else if (argument == "--output")
+        {
+            outputName = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << ".\n";
+            return -1;
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+    {
+        if (!runBenchmarks(sizes[i], distribution, minimumTime, numberOfThreads, results))
+        {
+            return -2;
+        }
+    }
+
+    if (outputName.empty())
+    {
+        writeJson(std::cout, results, distribution, minimumTime, numberOfThreads);
+    }
+    else
+    {
+        std::ofstream myOutput(outputName.c_str());
+        writeJson(myOutput, results, distribution, minimumTime, numberOfThreads);
+        if (!myOutput)
+        {
+            std::cerr << "Unable to write " << outputName << ".\n";
+            return -3;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "EdgeMap.h"
+
+void EdgeMap::set(long long key, int value)
+{
+    if (2 * (std::size_t)(myCount + 1) > myEntries.size()) // Keep the table at most half full.
+    {
+        resize(myEntries.empty() ? 16 : 2 * myEntries.size());
+    }
+    std::size_t k(hash(key));
+    for (; myEntries[k].key != -1; k = (k + 1) & (myEntries.size() - 1))
+    {
+        if (myEntries[k].key == key)
+        {
+            myEntries[k].value = value;
+            return;
+        }
+    }
+    myEntries[k].key = key;
+    myEntries[k].value = value;
+    ++myCount;
+}
+
+/*
+    The following method removes a key. The entries after it are shifted back into the gap where their probe
+    sequence allows it, the same deletion as in IdIndex::erase().
+*/
+bool EdgeMap::erase(long long key)
+{
+    if (myEntries.empty())
+    {
+        return false;
+    }
+    std::size_t mask(myEntries.size() - 1), gap(hash(key));
+    for (; myEntries[gap].key != key; gap = (gap + 1) & mask)
+    {
+        if (myEntries[gap].key == -1)
+        {
+            return false;
+        }
+    }
+    for (std::size_t k = (gap + 1) & mask; myEntries[k].key != -1; k = (k + 1) & mask)
+    {
+        std::size_t home(hash(myEntries[k].key)); // Where the probe for this entry starts.
+        if (((k - home) & mask) >= ((k - gap) & mask)) // The gap lies on its probe sequence, so it may move there.
+        {
+            myEntries[gap] = myEntries[k];
+            gap = k;
+        }
+    }
+    myEntries[gap].key = -1;
+    --myCount;
+    return true;
+}
+
+void EdgeMap::clear()
+{
+    for (std::size_t k = 0; k < myEntries.size(); ++k)
+    {
+        myEntries[k].key = -1;
+    }
+    myCount = 0;
+}
+
+void EdgeMap::reserve(int count)
+{
+    std::size_t size(myEntries.empty() ? 16 : myEntries.size());
+    while (size < 2 * (std::size_t)count)
+    {
+        size *= 2;
+    }
+    if (size > myEntries.size())
+    {
+        resize(size);
+    }
+}
+
+void EdgeMap::resize(std::size_t size)
+{
+    std::vector<Entry> old;
+    old.swap(myEntries);
+    Entry empty = {-1, -1};
+    myEntries.assign(size, empty);
+    myShift = 64;
+    for (std::size_t s = size; s > 1; s /= 2)
+    {
+        --myShift;
+    }
+    myCount = 0;
+    for (std::size_t k = 0; k < old.size(); ++k)
+    {
+        if (old[k].key != -1)
+        {
+            set(old[k].key, old[k].value);
+        }
+    }
+}
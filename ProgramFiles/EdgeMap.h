@@ -0,0 +1,65 @@
+#ifndef EDGEMAP_H
+#define EDGEMAP_H
+
+#include <vector> // Table of the map.
+
+/*
+    The following EdgeMap class maps the key of an edge to the position of a triangle. It is an open addressing
+    hash table with linear probing held in one array, so unlike a node based map, adding and removing entries
+    does not allocate; the array only grows, doubling when it becomes half full. Removed entries are closed up
+    by shifting the following entries back, so no tombstones are left behind. Keys must not be negative.
+*/
+class EdgeMap
+{
+public:
+    EdgeMap() : myCount(0), myShift(64) {;}
+
+    void set(long long key, int value); // Stores the value for the key, replacing the old one if there is one.
+    bool erase(long long key); // Removes the key. Returns false if it is not there.
+    void clear(); // Removes every key but keeps the table.
+    void reserve(int count); // Makes room for count keys without growing.
+
+    int find(long long key) const // Value stored for the key, or -1 if there is none.
+    {
+        if (myEntries.empty())
+        {
+            return -1;
+        }
+        for (std::size_t k = hash(key); ; k = (k + 1) & (myEntries.size() - 1))
+        {
+            if (myEntries[k].key == key)
+            {
+                return myEntries[k].value;
+            }
+            if (myEntries[k].key == -1)
+            {
+                return -1;
+            }
+        }
+    }
+
+    int getCount() const // Number of keys stored.
+    {
+        return myCount;
+    }
+
+private:
+    struct Entry // Slot of the table. A key of -1 marks an empty slot.
+    {
+        long long key;
+        int value;
+    };
+
+    std::size_t hash(long long key) const // Fibonacci hashing: the top bits of the product select the slot.
+    {
+        return ((unsigned long long)key * 0x9E3779B97F4A7C15ULL) >> myShift;
+    }
+
+    void resize(std::size_t size); // Moves the entries into a table of the given power of two size.
+
+    int myCount;
+    int myShift; // 64 minus the number of bits of a slot.
+    std::vector<Entry> myEntries;
+};
+
+#endif
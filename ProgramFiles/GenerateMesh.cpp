@@ -0,0 +1,88 @@
+#include "MeshGenerator.h"
+#include <iostream> // Messages and output to stdout.
+#include <fstream> // Output file.
+#include <string> // Command line.
+#include <cstdlib> // Number parsing.
+
+/*
+    Command line front end of MeshGenerator. Usage:
+
+        triangulation_generate --cells n [--distribution uniform|clustered|grid|cocircular] [--attributes k]
+                               [--seed s] [--output file]
+
+    Writes the mesh to the file, or to stdout without --output. The actual numbers of points and cells, which are
+    rounded up to whole rows, are reported on std::cerr.
+*/
+int main(int argc, char **argv)
+{
+    long long numberOfCells(0);
+    int numberOfAttributesPerCell(0);
+    unsigned int seed(1);
+    MeshGenerator::Distribution distribution(MeshGenerator::UNIFORM);
+    std::string outputName;
+    std::ios::sync_with_stdio(false); // Large writes to std::cout without going through stdio.
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument(argv[i]);
+        if (i + 1 == argc)
+        {
+            std::cerr << "Missing value for " << argument << ".\n";
+            return -1;
+        }
+        const char *value(argv[++i]);
+        if (argument == "--cells")
+        {
+            numberOfCells = std::atof(value); // Also accepts 1e8.
+        }
+        else if (argument == "--distribution")
+        {
+            if (!MeshGenerator::parseDistribution(value, distribution))
+            {
+                std::cerr << "Unknown distribution " << value << ".\n";
+                return -1;
+            }
+        }
+        else if (argument == "--attributes")
+        {
+            numberOfAttributesPerCell = std::atoi(value);
+        }
+        else if (argument == "--seed")
+        {
+            seed = (unsigned int)std::strtoul(value, NULL, 10);
+        }
+        else if (argument == "--output")
+        {
+            outputName = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << ".\n";
+            return -1;
+        }
+    }
+    if (numberOfCells < 1 || numberOfCells > MeshGenerator::MAXIMUM_CELLS || numberOfAttributesPerCell < 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " --cells n (1 to " << MeshGenerator::MAXIMUM_CELLS << ") [--distribution uniform|clustered|grid|cocircular] [--attributes k] [--seed s] [--output file]\n";
+        return -1;
+    }
+
+    MeshGenerator generator(distribution, (int)numberOfCells, numberOfAttributesPerCell, seed);
+    std::cerr << MeshGenerator::getName(distribution) << ": " << generator.getNumberOfPoints() << " points, " << generator.getNumberOfCells() << " cells\n";
+    bool isWritten;
+    if (outputName.empty())
+    {
+        isWritten = generator.write(std::cout);
+    }
+    else
+    {
+        std::ofstream myFile(outputName.c_str(), std::ios::binary);
+        isWritten = myFile.is_open() && generator.write(myFile);
+    }
+    if (!isWritten)
+    {
+        std::cerr << "Unable to write the mesh.\n";
+        return -2;
+    }
+    return 0;
+}
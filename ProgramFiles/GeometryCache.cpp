@@ -0,0 +1,129 @@
+#include "GeometryCache.h"
+#include "Triangle.h" // Formulas for the area and the circumcentre.
+#include "Parallel.h" // The full recomputation is split over several threads.
+#include "Metrics.h" // Counts the recomputations.
+
+/*
+    The following method removes all entries. The next update() computes everything.
+*/
+void GeometryCache::clear()
+{
+    area.clear();
+    centreX.clear();
+    centreY.clear();
+    radiusSquared.clear();
+    isDirty.clear();
+    dirtySlots.clear();
+    isAllDirty = true;
+}
+
+/*
+    The following method marks the triangle at the given position for recomputation. Positions beyond the current
+    size of the cache are new triangles and are picked up by update() anyway.
+*/
+void GeometryCache::markDirty(int slot)
+{
+    if (isAllDirty || slot >= (int)isDirty.size() || isDirty[slot]) // Already going to be recomputed.
+    {
+        return;
+    }
+    isDirty[slot] = 1;
+    dirtySlots.push_back(slot);
+}
+
+/*
+    The following method marks every triangle for recomputation.
+*/
+void GeometryCache::markAllDirty()
+{
+    isAllDirty = true;
+    dirtySlots.clear();
+}
+
+/*
+    The following method follows the mesh when a triangle is removed by moving the last triangle into its
+    position. If the cache covers the whole mesh the entry of the last triangle moves along with it and nothing
+    is recomputed; otherwise the position is simply marked dirty.
+*/
+void GeometryCache::remove(int slot, int last)
+{
+    if (last + 1 != (int)area.size())
+    {
+        markDirty(slot);
+        return;
+    }
+    if (slot != last)
+    {
+        area[slot] = area[last];
+        centreX[slot] = centreX[last];
+        centreY[slot] = centreY[last];
+        radiusSquared[slot] = radiusSquared[last];
+        if (isDirty[last])
+        {
+            markDirty(slot);
+        }
+    }
+    area.pop_back();
+    centreX.pop_back();
+    centreY.pop_back();
+    radiusSquared.pop_back();
+    isDirty.pop_back(); // A queued entry for the old last position is skipped by update().
+}
+
+/*
+    The following method brings the cache up to date with the mesh. New triangles at the end of the mesh and the
+    triangles marked dirty are recomputed. If everything is dirty the whole mesh is recomputed in parallel using
+    numberOfThreads threads (0 uses every core).
+*/
+void GeometryCache::update(PackedMesh &mesh, int numberOfThreads)
+{
+    int numberOfCells(mesh.getNumberOfCells()), oldSize(area.size());
+    if (numberOfCells < oldSize) // The mesh shrank, so positions have been reused.
+    {
+        isAllDirty = true;
+    }
+    area.resize(numberOfCells);
+    centreX.resize(numberOfCells);
+    centreY.resize(numberOfCells);
+    radiusSquared.resize(numberOfCells);
+    isDirty.assign(numberOfCells, 0);
+
+    Metrics::add(Metrics::CIRCUMCENTRE_RECOMPUTATIONS, isAllDirty ? numberOfCells : dirtySlots.size() + std::max(numberOfCells - oldSize, 0));
+    if (isAllDirty)
+    {
+        parallelFor(0, numberOfCells, numberOfThreads, [&](int begin, int end, int)
+        {
+            for (int j = begin; j < end; ++j)
+            {
+                compute(mesh, j);
+            }
+        });
+    }
+    else
+    {
+        for (std::vector<int>::iterator it = dirtySlots.begin(); it != dirtySlots.end(); ++it) // Changed triangles.
+        {
+            if (*it < numberOfCells) // Positions past the end were removed since they were queued.
+            {
+                compute(mesh, *it);
+            }
+        }
+        for (int j = oldSize; j < numberOfCells; ++j) // Triangles added since the last update.
+        {
+            compute(mesh, j);
+        }
+    }
+    dirtySlots.clear();
+    isAllDirty = false;
+}
+
+/*
+    The following method calculates the cached values of one triangle with the same formulas Triangle uses.
+*/
+void GeometryCache::compute(PackedMesh &mesh, int slot)
+{
+    float *x(mesh.getX()), *y(mesh.getY());
+    int *cell(mesh.getCell(slot));
+    area[slot] = Triangle::calculateArea(x[cell[0]], y[cell[0]], x[cell[1]], y[cell[1]], x[cell[2]], y[cell[2]]);
+    Triangle::calculateCircumcentre(x[cell[0]], y[cell[0]], x[cell[1]], y[cell[1]], x[cell[2]], y[cell[2]], centreX[slot], centreY[slot], radiusSquared[slot]);
+}
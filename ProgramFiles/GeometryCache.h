@@ -0,0 +1,58 @@
+#ifndef GEOMETRYCACHE_H
+#define GEOMETRYCACHE_H
+
+#include <vector> // Needed for using the vector container.
+#include "PackedMesh.h" // The geometry is calculated from the flat arrays.
+
+/*
+    The following GeometryCache class holds the values derived from the shape of each triangle: its area, its
+    circumcentre and the square of its circumradius. They are stored in flat arrays indexed by the position of
+    the triangle. Every entry has a dirty flag; changing a triangle only marks it dirty and update() recomputes
+    all dirty entries in one go, so a mesh which does not change pays for its geometry only once.
+*/
+class GeometryCache
+{
+public:
+    GeometryCache() : isAllDirty(true) {;} // Constructor creates an empty cache.
+
+    void clear(); // Removes all entries.
+    void markDirty(int slot); // The triangle at this position changed.
+    void markAllDirty(); // Every triangle changed, for example after loading.
+    void remove(int slot, int last); // The triangle at slot was removed and the last one, at position last, moved there.
+    void update(PackedMesh &mesh, int numberOfThreads = 0); // Recomputes the dirty entries and grows the cache to the size of the mesh.
+
+    bool isClean() // True if nothing needs recomputing.
+    {
+        return !isAllDirty && dirtySlots.empty();
+    }
+
+    float *getArea() // Area of each triangle.
+    {
+        return area.data();
+    }
+
+    float *getCentreX() // x coordinate of the circumcentre of each triangle.
+    {
+        return centreX.data();
+    }
+
+    float *getCentreY() // y coordinate of the circumcentre of each triangle.
+    {
+        return centreY.data();
+    }
+
+    float *getRadiusSquared() // Square of the circumradius of each triangle.
+    {
+        return radiusSquared.data();
+    }
+
+private:
+    void compute(PackedMesh &mesh, int slot); // Calculates the entries of one triangle.
+
+    std::vector<float> area, centreX, centreY, radiusSquared; // The cached values.
+    std::vector<unsigned char> isDirty; // Flag per triangle so that no triangle is queued twice.
+    std::vector<int> dirtySlots; // Triangles waiting to be recomputed.
+    bool isAllDirty; // Set when every entry has to be recomputed, which is then done in parallel.
+};
+
+#endif
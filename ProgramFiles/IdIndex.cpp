@@ -0,0 +1,204 @@
+#include "IdIndex.h"
+
+/*
+    The following method adds one ID at the end of a container. IDs following on from the positions keep the
+    identity layout, IDs falling into or just past the direct table extend it, and anything else moves the index
+    into the layout which suits the new range.
+*/
+bool IdIndex::insert(long long id, int position)
+{
+    if (id < 0 || find(id) != -1)
+    {
+        return false;
+    }
+    long long minimum(myCount == 0 ? id : std::min(myMinimum, id)), maximum(std::max(myMaximum, id));
+    if (myMode == IDENTITY)
+    {
+        if (id == myCount && position == myCount)
+        {
+            ++myCount;
+            myMaximum = id;
+            return true;
+        }
+        rebuild(minimum, maximum, 2 * (myCount + 1));
+    }
+    else if (myMode == DENSE)
+    {
+        unsigned long long offset(id - myBase);
+        if (id < myBase || offset > 2ULL * (myCount + 1) + 16) // Outside what the table may cover.
+        {
+            rebuild(minimum, maximum, 2 * (myCount + 1));
+        }
+        else if (offset >= myTable.size()) // Just past the end: grow the table, which doubles its capacity as needed.
+        {
+            myTable.resize(offset + 1, -1);
+        }
+    }
+    else if (2 * (std::size_t)(myCount + 1) > myEntries.size()) // Keep the hash table at most half full.
+    {
+        rebuild(minimum, maximum, 2 * (myCount + 1));
+    }
+    return place(id, position);
+}
+
+/*
+    The following method removes one ID. Removing the last ID of the identity layout keeps it; any other ID moves
+    the index into a table first. In the hash table the entries after the removed one are shifted back into the
+    gap where their probe sequence allows it, so no tombstones are left behind and lookups stay short.
+*/
+bool IdIndex::erase(long long id)
+{
+    if (find(id) == -1)
+    {
+        return false;
+    }
+    if (myMode == IDENTITY)
+    {
+        if (id == myCount - 1)
+        {
+            --myCount;
+            return true;
+        }
+        rebuild(0, myMaximum, myCount);
+    }
+    if (myMode == DENSE)
+    {
+        myTable[id - myBase] = -1;
+    }
+    else
+    {
+        std::size_t mask(myEntries.size() - 1), gap(hash(id));
+        while (myEntries[gap].id != id)
+        {
+            gap = (gap + 1) & mask;
+        }
+        for (std::size_t k = (gap + 1) & mask; myEntries[k].id != -1; k = (k + 1) & mask)
+        {
+            std::size_t home(hash(myEntries[k].id)); // Where the probe for this entry starts.
+            if (((k - home) & mask) >= ((k - gap) & mask)) // The gap lies on its probe sequence, so it may move there.
+            {
+                myEntries[gap] = myEntries[k];
+                gap = k;
+            }
+        }
+        myEntries[gap].id = -1;
+    }
+    --myCount;
+    return true;
+}
+
+void IdIndex::clear()
+{
+    myMode = IDENTITY;
+    myCount = 0;
+    myMinimum = 0;
+    myMaximum = -1;
+    myTable.clear();
+    myEntries.clear();
+}
+
+/*
+    The following method sets up an empty table for capacity IDs between minimum and maximum: the direct table if
+    the range is at most about twice the capacity, otherwise a hash table of at least twice the capacity.
+*/
+void IdIndex::layout(long long minimum, long long maximum, int capacity)
+{
+    myCount = 0;
+    myMinimum = 0;
+    myMaximum = -1;
+    unsigned long long range(maximum >= minimum ? maximum - minimum + 1 : 0);
+    if (range <= 2ULL * capacity + 16)
+    {
+        myMode = DENSE;
+        myBase = minimum;
+        myTable.assign(range, -1);
+        std::vector<Entry>().swap(myEntries);
+        return;
+    }
+    myMode = SPARSE;
+    std::size_t size(16);
+    int bits(4);
+    while (size < 2 * (std::size_t)capacity)
+    {
+        size *= 2;
+        ++bits;
+    }
+    myShift = 64 - bits;
+    Entry empty = {-1, -1};
+    myEntries.assign(size, empty);
+    std::vector<int>().swap(myTable);
+}
+
+bool IdIndex::place(long long id, int position)
+{
+    if (id < 0)
+    {
+        return false;
+    }
+    if (myMode == DENSE)
+    {
+        int &slot = myTable[id - myBase];
+        if (slot != -1)
+        {
+            return false;
+        }
+        slot = position;
+    }
+    else
+    {
+        std::size_t k(hash(id));
+        for (; myEntries[k].id != -1; k = (k + 1) & (myEntries.size() - 1))
+        {
+            if (myEntries[k].id == id)
+            {
+                return false;
+            }
+        }
+        myEntries[k].id = id;
+        myEntries[k].position = position;
+    }
+    myMinimum = myCount == 0 ? id : std::min(myMinimum, id);
+    myMaximum = std::max(myMaximum, id);
+    ++myCount;
+    return true;
+}
+
+void IdIndex::rebuild(long long minimum, long long maximum, int capacity)
+{
+    std::vector<Entry> entries;
+    entries.reserve(myCount);
+    if (myMode == IDENTITY)
+    {
+        for (int p = 0; p < myCount; ++p)
+        {
+            Entry entry = {p, p};
+            entries.push_back(entry);
+        }
+    }
+    else if (myMode == DENSE)
+    {
+        for (std::size_t k = 0; k < myTable.size(); ++k)
+        {
+            if (myTable[k] != -1)
+            {
+                Entry entry = {myBase + (long long)k, myTable[k]};
+                entries.push_back(entry);
+            }
+        }
+    }
+    else
+    {
+        for (std::size_t k = 0; k < myEntries.size(); ++k)
+        {
+            if (myEntries[k].id != -1)
+            {
+                entries.push_back(myEntries[k]);
+            }
+        }
+    }
+    layout(minimum, maximum, capacity);
+    for (std::size_t k = 0; k < entries.size(); ++k)
+    {
+        place(entries[k].id, entries[k].position);
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef IDINDEX_H
+#define IDINDEX_H
+
+#include <vector> // Tables of the index.
+#include <algorithm> // std::min and std::max.
+
+/*
+    The following IdIndex class maps the IDs of points or cells, as they appear in a file, to the positions of
+    the objects in the containers. IDs are 64 bit, must not be negative and need not start at 0 or follow each
+    other. The layout depends on the IDs: when every ID equals its position, which is the usual 0 to count - 1
+    in order, nothing is stored at all; when the IDs fill a range at most about twice the count, a table covers
+    the range directly; otherwise an open addressing hash table with linear probing holds them. A lookup is
+    therefore one comparison, one load, or a hash and a short probe.
+*/
+class IdIndex
+{
+public:
+    IdIndex() : myMode(IDENTITY), myCount(0), myMinimum(0), myMaximum(-1), myBase(0), myShift(64) {;}
+
+    template<typename T>
+    bool build(int count, T getId, long long *conflict = NULL); // Indexes the positions 0 to count - 1 by the IDs getId(position). Returns false if an ID is repeated or negative and puts it in conflict; the first position keeps a repeated ID.
+    bool insert(long long id, int position); // Adds one ID. Returns false if it is negative or already indexed.
+    bool erase(long long id); // Removes one ID. Returns false if it is not indexed.
+    void clear(); // Forgets every ID.
+
+    int find(long long id) const // Position of the ID or -1 if there is none.
+    {
+        if (myMode == IDENTITY)
+        {
+            return id >= 0 && id < myCount ? (int)id : -1;
+        }
+        if (myMode == DENSE)
+        {
+            unsigned long long offset(id - myBase); // Wraps around below the base.
+            return offset < myTable.size() ? myTable[offset] : -1;
+        }
+        for (unsigned long long k = hash(id); ; k = (k + 1) & (myEntries.size() - 1))
+        {
+            if (myEntries[k].id == id)
+            {
+                return myEntries[k].position;
+            }
+            if (myEntries[k].id == -1)
+            {
+                return -1;
+            }
+        }
+    }
+
+    bool isIdentity() const // True if every ID equals its position.
+    {
+        return myMode == IDENTITY;
+    }
+
+    long long getNextId() const // Smallest ID above all IDs indexed so far, used for new objects. IDs which were erased are not handed out again.
+    {
+        return myMaximum + 1;
+    }
+
+    int getCount() const // Number of IDs indexed.
+    {
+        return myCount;
+    }
+
+private:
+    enum Mode {IDENTITY, DENSE, SPARSE};
+
+    struct Entry // Slot of the hash table. An id of -1 marks an empty slot.
+    {
+        long long id;
+        int position;
+    };
+
+    unsigned long long hash(long long id) const // Fibonacci hashing: the top bits of the product select the slot.
+    {
+        return ((unsigned long long)id * 0x9E3779B97F4A7C15ULL) >> myShift;
+    }
+
+    void layout(long long minimum, long long maximum, int capacity); // Chooses and allocates the table for capacity IDs in [minimum, maximum].
+    bool place(long long id, int position); // Stores an ID in the current table, which must have room for it.
+    void rebuild(long long minimum, long long maximum, int capacity); // Moves the indexed IDs into a new layout.
+
+    Mode myMode;
+    int myCount;
+    long long myMinimum, myMaximum; // Range of the IDs indexed, not narrowed by erase(). myMaximum is -1 if there are none.
+    long long myBase; // ID of the first entry of myTable.
+    int myShift; // 64 minus the number of bits of a hash table slot.
+    std::vector<int> myTable; // Position of the ID myBase + k at k, -1 for a gap. Used in the DENSE layout.
+    std::vector<Entry> myEntries; // Hash table with a power of two size. Used in the SPARSE layout.
+};
+
+/*
+    The following method indexes a whole container at once. A first pass finds the range of the IDs and whether
+    they are simply the positions, which decides the layout; a second pass fills the table.
+*/
+template<typename T>
+bool IdIndex::build(int count, T getId, long long *conflict)
+{
+    clear();
+    long long minimum(0), maximum(-1);
+    bool isPosition(true);
+    for (int p = 0; p < count; ++p)
+    {
+        long long id(getId(p));
+        isPosition = isPosition && id == p;
+        if (id >= 0)
+        {
+            minimum = maximum < 0 ? id : std::min(minimum, id);
+            maximum = std::max(maximum, id);
+        }
+    }
+    if (isPosition)
+    {
+        myCount = count;
+        myMaximum = count - 1;
+        return true;
+    }
+
+    layout(minimum, maximum, count);
+    bool isValid(true);
+    for (int p = 0; p < count; ++p)
+    {
+        long long id(getId(p));
+        if (!place(id, p) && isValid)
+        {
+            isValid = false;
+            if (conflict != NULL)
+            {
+                *conflict = id;
+            }
+        }
+    }
+    return isValid;
+}
+
+#endif
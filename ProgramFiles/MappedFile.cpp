@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+#include <fstream> // Reading the file when it cannot be mapped.
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPEDFILE_POSIX
+#include <sys/mman.h> // mmap and munmap.
+#include <sys/stat.h> // fstat for the size of the file.
+#include <fcntl.h> // open.
+#include <unistd.h> // close.
+#endif
+
+/*
+    The following method maps the file with the given name. Any file opened before is closed first. An empty
+    file opens fine and has size 0.
+*/
+bool MappedFile::open(const char *fileName, bool isCopyOnWrite)
+{
+    close();
+#ifdef MAPPEDFILE_POSIX
+    int descriptor(::open(fileName, O_RDONLY));
+    if (descriptor >= 0)
+    {
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void *mapping(mmap(NULL, status.st_size, isCopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, descriptor, 0));
+            if (mapping != MAP_FAILED)
+            {
+                if (!isCopyOnWrite)
+                {
+                    madvise(mapping, status.st_size, MADV_SEQUENTIAL); // The parsers read front to back.
+                }
+                ::close(descriptor); // The mapping stays valid without the descriptor.
+                data = (char *)mapping;
+                size = status.st_size;
+                isMapped = true;
+                isWritable = isCopyOnWrite;
+                return true;
+            }
+        }
+        ::close(descriptor);
+    }
+#endif
+    std::ifstream file(fileName, std::ios::binary); // Read the whole file instead.
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file.seekg(0, std::ios::end);
+    std::streamoff length(file.tellg());
+    file.seekg(0, std::ios::beg);
+    buffer.resize(length > 0 ? (std::size_t)length : 0);
+    if (!buffer.empty() && !file.read(buffer.data(), buffer.size()))
+    {
+        buffer.clear();
+        return false;
+    }
+    data = buffer.data();
+    size = buffer.size();
+    isWritable = isCopyOnWrite;
+    return true;
+}
+
+/*
+    The following method unmaps the file or frees the buffer.
+*/
+void MappedFile::close()
+{
+#ifdef MAPPEDFILE_POSIX
+    if (isMapped)
+    {
+        munmap((void *)data, size);
+    }
+#endif
+    std::vector<char>().swap(buffer);
+    data = NULL;
+    size = 0;
+    isMapped = false;
+    isWritable = false;
+}
+
+/*
+    The following method drops the pages which lie completely inside [begin, end) from the memory of the process.
+    They are read from the file again if they are used later. Pages which were written to lose the changes, so
+    this is meant for read-only passes over the file. Nothing happens if the file is not mapped.
+*/
+void MappedFile::release(std::size_t begin, std::size_t end)
+{
+#ifdef MAPPEDFILE_POSIX
+    if (!isMapped || end > size || begin >= end)
+    {
+        return;
+    }
+    std::size_t pageSize(sysconf(_SC_PAGESIZE));
+    std::size_t first((begin + pageSize - 1) / pageSize * pageSize), last(end / pageSize * pageSize); // Whole pages only.
+    if (first < last)
+    {
+        madvise(data + first, last - first, MADV_DONTNEED);
+    }
+#endif
+}
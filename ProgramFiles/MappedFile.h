@@ -0,0 +1,54 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef> // For std::size_t.
+#include <vector> // Fallback buffer when the file cannot be mapped.
+
+/*
+    The following MappedFile class gives read-only access to the whole content of a file as one block of memory.
+    On POSIX systems the file is memory mapped, so the operating system pages it in as it is read and nothing is
+    copied. Elsewhere, or if mapping fails, the file is read into a buffer instead. The memory stays valid until
+    close() is called or the object is destroyed. A file opened copy-on-write may be written to: the pages
+    written are copied for this process only, the others stay shared with every process mapping the file.
+*/
+class MappedFile
+{
+public:
+    MappedFile() : data(NULL), size(0), isMapped(false), isWritable(false) {;} // Constructor creates a closed file.
+
+    ~MappedFile() // Destructor unmaps the file.
+    {
+        close();
+    }
+
+    bool open(const char *fileName, bool isCopyOnWrite = false); // Maps the file. Returns false if it cannot be opened.
+    void close(); // Releases the memory.
+    void release(std::size_t begin, std::size_t end); // Tells the system the bytes [begin, end) are no longer needed, so they stop counting towards the memory used.
+
+    const char *getData() // Returns the first byte of the file.
+    {
+        return data;
+    }
+
+    char *getWritableData() // Returns the first byte of a file opened copy-on-write, NULL otherwise.
+    {
+        return isWritable ? data : NULL;
+    }
+
+    std::size_t getSize() // Returns the number of bytes in the file.
+    {
+        return size;
+    }
+
+private:
+    MappedFile(const MappedFile &); // Copying would unmap the memory twice.
+    MappedFile &operator=(const MappedFile &);
+
+    char *data; // Start of the content.
+    std::size_t size; // Length of the content.
+    bool isMapped; // True if data is a mapping, false if it points into buffer.
+    bool isWritable; // True if the content may be changed. Changes never reach the file.
+    std::vector<char> buffer; // Content of the file when it is not mapped.
+};
+
+#endif
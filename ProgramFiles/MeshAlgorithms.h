@@ -0,0 +1,249 @@
+#ifndef MESHALGORITHMS_H
+#define MESHALGORITHMS_H
+
+#include <vector> // Buffers of the integration and the violations found by each thread.
+#include <utility> // std::pair.
+#include <atomic> // Flag shared between the threads of findViolations().
+#include <cmath> // Absolute value of the areas.
+#include <algorithm> // std::min and std::max.
+#include "EdgeMap.h" // Edges waiting for a neighbouring cell.
+#include "Parallel.h" // Splitting loops over several threads.
+#include "Predicates.h" // Exact orientation and in-circle tests.
+#include "Quadrature.h" // Quadrature rules, compensated summation and IsBatchFunction.
+
+/*
+    The following MeshAlgorithms class has the algorithms which Triangulation and StaticMesh share, written once
+    against a view of the mesh instead of its storage. A view is a small object, passed by value, with the methods
+        int getVertex(int cell, int i) - position of vertex i of a cell,
+        int getNeighbour(int cell, int i) - position of the cell across the edge opposite vertex i, -1 on the boundary,
+        void setNeighbour(int cell, int i, int neighbour),
+        double getX(int point), double getY(int point) - coordinates of a point.
+    They are all inlined, so the loops below are as fast as if each mesh had its own copy.
+*/
+class MeshAlgorithms
+{
+public:
+    static long long edgeKey(int v0, int v1) // Key of an edge which does not depend on its direction: the smaller position goes into the upper half.
+    {
+        return v0 < v1 ? ((long long)v0 << 32) | (unsigned int)v1 : ((long long)v1 << 32) | (unsigned int)v0;
+    }
+
+    template<typename V>
+    static void linkCell(V view, EdgeMap &openEdges, int slot); // Connects a cell to the neighbours among the open edges and leaves its other edges open.
+
+    template<typename V>
+    static bool isLocallyDelaunay(V view, int slot, int edge); // Checks the empty circumcircle condition across one edge.
+
+    template<typename V>
+    static bool findViolations(V view, int count, std::vector<std::pair<int, int> > *violations, int numberOfThreads); // Checks every interior edge of the cells [0, count).
+
+    template<typename V, typename T>
+    static double integration(V view, int count, T t, Quadrature::Rule rule, int numberOfThreads); // Integral of t over the cells [0, count) with a quadrature rule.
+
+    template<typename T>
+    static void evaluate(T &t, const double *x, const double *y, int count, double *values); // Values of t at count points, in a single call if t takes batches.
+
+private:
+    template<typename V, typename T>
+    static double integrateCells(V view, T &t, Quadrature::Rule rule, int begin, int end); // Integral of t over the cells [begin, end).
+};
+
+/*
+    The following method matches the edges of the cell at position slot with the open edges of the cells seen
+    before it. A matched edge gets the neighbours on both sides and is closed; an unmatched one is left open for
+    a later cell. The neighbours of the edges left open are not touched.
+*/
+template<typename V>
+void MeshAlgorithms::linkCell(V view, EdgeMap &openEdges, int slot)
+{
+    for (int i = 0; i < 3; ++i) // Edge i is the one opposite vertex i.
+    {
+        int a(view.getVertex(slot, (i + 1) % 3)), b(view.getVertex(slot, (i + 2) % 3));
+        long long key(edgeKey(a, b));
+        int found(openEdges.find(key));
+        if (found == -1) // First cell on this edge.
+        {
+            openEdges.set(key, slot);
+            continue;
+        }
+        for (int k = 0; k < 3; ++k) // Find which edge of the other cell it is: the one opposite the vertex not on this edge.
+        {
+            int vertex(view.getVertex(found, k));
+            if (vertex != a && vertex != b)
+            {
+                view.setNeighbour(found, k, slot);
+                break;
+            }
+        }
+        view.setNeighbour(slot, i, found);
+        openEdges.erase(key); // The edge is now shared by two cells.
+    }
+}
+
+/*
+    The following method tests the Delaunay condition on one edge: the vertex of the neighbour across the given
+    edge of the cell at position slot has to be outside or on the circumcircle of the cell, for either
+    orientation of the cell. Boundary edges are always Delaunay.
+*/
+template<typename V>
+bool MeshAlgorithms::isLocallyDelaunay(V view, int slot, int edge)
+{
+    int neighbour(view.getNeighbour(slot, edge));
+    if (neighbour == -1)
+    {
+        return true;
+    }
+    int a(view.getVertex(slot, 0)), b(view.getVertex(slot, 1)), c(view.getVertex(slot, 2));
+    int first(view.getVertex(slot, (edge + 1) % 3)), second(view.getVertex(slot, (edge + 2) % 3));
+    int opposite(-1); // Vertex of the neighbour which is not on the shared edge.
+    for (int k = 0; k < 3; ++k)
+    {
+        int vertex(view.getVertex(neighbour, k));
+        if (vertex != first && vertex != second)
+        {
+            opposite = vertex;
+            break;
+        }
+    }
+    if (opposite == -1) // Two cells with the same vertices, nothing sensible to test.
+    {
+        return true;
+    }
+    double side(Predicates::orientation(view.getX(a), view.getY(a), view.getX(b), view.getY(b), view.getX(c), view.getY(c)));
+    double inside(Predicates::inCircle(view.getX(a), view.getY(a), view.getX(b), view.getY(b), view.getX(c), view.getY(c), view.getX(opposite), view.getY(opposite)));
+    return !((side > 0 && inside > 0) || (side < 0 && inside < 0)); // Strictly inside for either orientation is a violation.
+}
+
+/*
+    The following method checks isLocallyDelaunay() on every interior edge once, from the cell with the smaller
+    position. The cells are split between numberOfThreads threads (0 uses every core). If violations is NULL the
+    check stops as soon as any thread finds a violation, otherwise all violating edges are reported as (cell
+    position, edge index) pairs ordered by cell. The output is true if there is no violation.
+*/
+template<typename V>
+bool MeshAlgorithms::findViolations(V view, int count, std::vector<std::pair<int, int> > *violations, int numberOfThreads)
+{
+    numberOfThreads = getNumberOfThreads(numberOfThreads);
+    std::vector<std::vector<std::pair<int, int> > > found(numberOfThreads); // Violations found by each thread, merged in order below.
+    std::atomic<bool> isViolated(false); // Lets the other threads stop early when no report is wanted.
+
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int thread)
+    {
+        for (int j = begin; j < end; ++j)
+        {
+            if (violations == NULL && (j & 255) == 0 && isViolated.load(std::memory_order_relaxed)) // Another thread already has the answer.
+            {
+                return;
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                if (view.getNeighbour(j, i) < j) // Boundary edge, or the edge was already checked from the other side.
+                {
+                    continue;
+                }
+                if (!isLocallyDelaunay(view, j, i))
+                {
+                    isViolated.store(true, std::memory_order_relaxed);
+                    if (violations == NULL)
+                    {
+                        return;
+                    }
+                    found[thread].push_back(std::make_pair(j, i));
+                }
+            }
+        }
+    });
+
+    if (violations != NULL)
+    {
+        for (int t = 0; t < numberOfThreads; ++t) // Chunks are in cell order, so are the results.
+        {
+            violations->insert(violations->end(), found[t].begin(), found[t].end());
+        }
+    }
+    return !isViolated.load();
+}
+
+/*
+    The following method integrates t with the given quadrature rule. The cells are split into one contiguous
+    chunk per thread, each chunk is summed with compensation and the partial sums are added in chunk order, so the
+    same number of threads always gives the same result. Every thread works on its own copy of t.
+    t is either called as t(x, y) for every point, or, if it provides t(const double *x, const double *y, int count,
+    double *values), once for the quadrature points of a whole block of cells (see IsBatchFunction).
+*/
+template<typename V, typename T>
+double MeshAlgorithms::integration(V view, int count, T t, Quadrature::Rule rule, int numberOfThreads)
+{
+    numberOfThreads = std::max(std::min(getNumberOfThreads(numberOfThreads), count), 1);
+    std::vector<double> partialSums(numberOfThreads, 0.0);
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int thread)
+    {
+        T function(t);
+        partialSums[thread] = integrateCells(view, function, rule, begin, end);
+    });
+    CompensatedSum sum;
+    for (int k = 0; k < numberOfThreads; ++k)
+    {
+        sum.add(partialSums[k]);
+    }
+    return sum.getSum();
+}
+
+/*
+    The following method integrates t over the cells [begin, end) a block at a time: the quadrature points of
+    the block are calculated first, then t is evaluated on all of them and the weighted values are summed.
+*/
+template<typename V, typename T>
+double MeshAlgorithms::integrateCells(V view, T &t, Quadrature::Rule rule, int begin, int end)
+{
+    const int block(256); // Cells per block.
+    int numberOfRulePoints(Quadrature::getNumberOfPoints(rule));
+    const QuadraturePoint *rulePoints(Quadrature::getPoints(rule));
+    std::vector<double> pointX(block * numberOfRulePoints), pointY(block * numberOfRulePoints), values(block * numberOfRulePoints), area(block);
+    CompensatedSum sum;
+    for (int first = begin; first < end; first += block)
+    {
+        int count(std::min(block, end - first));
+        for (int k = 0; k < count; ++k)
+        {
+            int a(view.getVertex(first + k, 0)), b(view.getVertex(first + k, 1)), c(view.getVertex(first + k, 2));
+            double x0(view.getX(a)), y0(view.getY(a)), x1(view.getX(b)), y1(view.getY(b)), x2(view.getX(c)), y2(view.getY(c));
+            area[k] = std::abs((x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0)) / 2;
+            for (int q = 0; q < numberOfRulePoints; ++q)
+            {
+                const QuadraturePoint &point = rulePoints[q];
+                pointX[k * numberOfRulePoints + q] = point.a * x0 + point.b * x1 + point.c * x2;
+                pointY[k * numberOfRulePoints + q] = point.a * y0 + point.b * y1 + point.c * y2;
+            }
+        }
+        evaluate(t, pointX.data(), pointY.data(), count * numberOfRulePoints, values.data());
+        for (int k = 0; k < count; ++k)
+        {
+            double weighted(0.0); // Weighted mean of t over the cell.
+            for (int q = 0; q < numberOfRulePoints; ++q)
+            {
+                weighted += rulePoints[q].weight * values[k * numberOfRulePoints + q];
+            }
+            sum.add(area[k] * weighted);
+        }
+    }
+    return sum.getSum();
+}
+
+template<typename T>
+void MeshAlgorithms::evaluate(T &t, const double *x, const double *y, int count, double *values)
+{
+    if constexpr (IsBatchFunction<T>::value)
+    {
+        t(x, y, count, values);
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            values[i] = t(x[i], y[i]);
+        }
+    }
+}
+
+#endif
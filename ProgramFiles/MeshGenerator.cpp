@@ -0,0 +1,267 @@
+#include "MeshGenerator.h"
+#include "Predicates.h" // Choice of the diagonal of each quadrilateral.
+#include <vector> // Output buffer and the coordinates of two rows.
+#include <charconv> // Number formatting.
+#include <cmath> // Square root, sine and exponential.
+#include <cstring> // Comparison of distribution names.
+#include <cstdio> // Formatting of the header lines.
+#include <algorithm> // std::max and std::swap.
+
+static const double PI(3.14159265358979323846);
+static const double JITTER(0.3); // UNIFORM points move up to half of this from their lattice position.
+static const int CLUSTERS(3); // Clusters along each axis in CLUSTERED.
+static const double CLUSTERING(0.9); // Lattice lines near a cluster centre are 1 - CLUSTERING times the average spacing apart.
+static const std::size_t FLUSH_SIZE(1 << 20); // The buffer is written out when it holds this many bytes.
+
+/*
+    The following constructor works out the shape of the lattice. The lattice modes use columns x rows squares,
+    made as close to square as possible. COCIRCULAR uses rings of m points: the fan around the centre has m cells
+    and every further ring adds 2m, with about m / 4 rings so that the outer radius is e^(pi / 2) times the inner one.
+*/
+MeshGenerator::MeshGenerator(Distribution distribution, int numberOfCells, int numberOfAttributesPerCell, unsigned int seed)
+    : myDistribution(distribution), numberOfAttributesPerCell(std::max(numberOfAttributesPerCell, 0)), mySeed(seed)
+{
+    long long target(std::max(numberOfCells, 2));
+    if (target > MAXIMUM_CELLS)
+    {
+        target = MAXIMUM_CELLS;
+    }
+    isRing = distribution == COCIRCULAR;
+    if (isRing)
+    {
+        long long spokes(std::max(8LL, (long long)std::ceil(std::sqrt(2.0 * target))));
+        long long rings(((target + spokes - 1) / spokes + 2) / 2);
+        rowLength = (int)spokes;
+        numberOfRows = (int)rings;
+        this->numberOfPoints = 1 + numberOfRows * rowLength;
+        this->numberOfCells = rowLength * (2 * numberOfRows - 1);
+    }
+    else
+    {
+        long long columns((long long)std::ceil(std::sqrt(target / 2.0)));
+        long long rows((target + 2 * columns - 1) / (2 * columns));
+        rowLength = (int)columns + 1;
+        numberOfRows = (int)rows + 1;
+        this->numberOfPoints = numberOfRows * rowLength;
+        this->numberOfCells = (int)(2 * columns * rows);
+    }
+}
+
+int MeshGenerator::getPointId(int row, int i) const
+{
+    return (isRing ? 1 : 0) + row * rowLength + i; // The centre of the rings is point 0.
+}
+
+/*
+    The following method gives the coordinates of every point of a row. Rows are computed again when the cells are
+    written, so they depend only on the seed and the position, never on what was generated before.
+*/
+void MeshGenerator::calculateRow(int row, float *x, float *y) const
+{
+    switch (myDistribution)
+    {
+    case UNIFORM:
+        for (int i = 0; i < rowLength; ++i)
+        {
+            unsigned long long id(getPointId(row, i));
+            x[i] = (float)(i + JITTER * (random(id, 0) - 0.5));
+            y[i] = (float)(row + JITTER * (random(id, 1) - 0.5));
+        }
+        break;
+    case CLUSTERED:
+    {
+        // Each lattice line moves along its own axis only, so every quadrilateral is an exact rectangle.
+        float rowY((float)((numberOfRows - 1) * warp((double)row / (numberOfRows - 1), 1)));
+        for (int i = 0; i < rowLength; ++i)
+        {
+            x[i] = (float)((rowLength - 1) * warp((double)i / (rowLength - 1), 0));
+            y[i] = rowY;
+        }
+        break;
+    }
+    case GRID:
+        for (int i = 0; i < rowLength; ++i)
+        {
+            x[i] = (float)i;
+            y[i] = (float)row;
+        }
+        break;
+    case COCIRCULAR:
+    {
+        // Logarithmic spacing of the rings keeps the quadrilaterals close to squares, about 1 wide on the inner ring.
+        double radius(rowLength / (2.0 * PI) * std::exp(2.0 * PI * row / rowLength));
+        for (int i = 0; i < rowLength; ++i)
+        {
+            double angle(2.0 * PI * i / rowLength);
+            x[i] = (float)(radius * std::cos(angle));
+            y[i] = (float)(radius * std::sin(angle));
+        }
+        break;
+    }
+    }
+}
+
+/*
+    Monotone map of [0, 1] onto itself whose slope is smallest, 1 - CLUSTERING, at CLUSTERS centres. The centres
+    are shifted by a random phase along each axis.
+*/
+double MeshGenerator::warp(double u, int axis) const
+{
+    double phase(random(axis, 2)), frequency(2.0 * PI * CLUSTERS);
+    return u - CLUSTERING / frequency * (std::sin(frequency * (u - phase)) + std::sin(frequency * phase));
+}
+
+/*
+    Hashes the seed, key and stream with the SplitMix64 finaliser and keeps the top 24 bits, which a float holds
+    exactly.
+*/
+float MeshGenerator::random(unsigned long long key, int stream) const
+{
+    unsigned long long z(((unsigned long long)mySeed << 32) ^ (key * 0x9E3779B97F4A7C15ULL) ^ ((unsigned long long)stream * 0xD1B54A32D192ED03ULL));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (float)(z >> 40) * (1.0f / 16777216.0f);
+}
+
+/*
+    The following method streams the mesh: the points row by row, then the cells from two rows of coordinates at a
+    time. Each quadrilateral is split along the diagonal which leaves its fourth corner outside the circumcircle of
+    the other three, decided with the exact predicate on the written float coordinates, so every quadrilateral is
+    Delaunay. Its corners are far enough from the other quadrilaterals for that to make the whole mesh Delaunay.
+*/
+bool MeshGenerator::write(std::ostream &myFile)
+{
+    std::vector<char> buffer(FLUSH_SIZE + 64 + 16 * numberOfAttributesPerCell);
+    char *p(buffer.data()), *last(buffer.data() + buffer.size());
+    std::vector<float> x0(rowLength), y0(rowLength), x1(rowLength), y1(rowLength);
+
+    p += std::sprintf(p, "%d 3 0\n", numberOfPoints);
+    if (isRing)
+    {
+        p += std::sprintf(p, "0 0 0 0\n");
+    }
+    for (int row = 0; row < numberOfRows; ++row)
+    {
+        calculateRow(row, x0.data(), y0.data());
+        for (int i = 0; i < rowLength; ++i)
+        {
+            p = std::to_chars(p, last, getPointId(row, i)).ptr;
+            *p++ = ' ';
+            p = std::to_chars(p, last, x0[i]).ptr; // Shortest text which reads back to the same float.
+            *p++ = ' ';
+            p = std::to_chars(p, last, y0[i]).ptr;
+            *p++ = ' ';
+            *p++ = '0';
+            *p++ = '\n';
+            if (p - buffer.data() >= (std::ptrdiff_t)FLUSH_SIZE)
+            {
+                myFile.write(buffer.data(), p - buffer.data());
+                p = buffer.data();
+            }
+        }
+    }
+
+    p += std::sprintf(p, "%d 3 %d\n", numberOfCells, numberOfAttributesPerCell);
+    int id(0);
+    int cell[3];
+    auto writeCell = [&]() { // Appends the line of the cell with the next ID.
+        p = std::to_chars(p, last, id).ptr;
+        for (int k = 0; k < 3; ++k)
+        {
+            *p++ = ' ';
+            p = std::to_chars(p, last, cell[k]).ptr;
+        }
+        for (int k = 0; k < numberOfAttributesPerCell; ++k)
+        {
+            *p++ = ' ';
+            p = std::to_chars(p, last, random(id, 3 + k)).ptr;
+        }
+        *p++ = '\n';
+        ++id;
+        if (p - buffer.data() >= (std::ptrdiff_t)FLUSH_SIZE)
+        {
+            myFile.write(buffer.data(), p - buffer.data());
+            p = buffer.data();
+        }
+    };
+
+    if (isRing) // Fan from the centre to the first ring.
+    {
+        for (int i = 0; i < rowLength; ++i)
+        {
+            cell[0] = 0;
+            cell[1] = getPointId(0, i);
+            cell[2] = getPointId(0, (i + 1) % rowLength);
+            writeCell();
+        }
+    }
+
+    int quadsPerRow(isRing ? rowLength : rowLength - 1);
+    calculateRow(0, x1.data(), y1.data());
+    for (int row = 0; row + 1 < numberOfRows; ++row)
+    {
+        x0.swap(x1);
+        y0.swap(y1);
+        calculateRow(row + 1, x1.data(), y1.data());
+        for (int i = 0; i < quadsPerRow; ++i)
+        {
+            int next((i + 1) % rowLength);
+            // Corners in counter-clockwise order. Along a ring the points turn the other way than along a lattice row.
+            int id0(getPointId(row, i)), id1(getPointId(row, next)), id2(getPointId(row + 1, next)), id3(getPointId(row + 1, i));
+            float qx[4] = {x0[i], x0[next], x1[next], x1[i]}, qy[4] = {y0[i], y0[next], y1[next], y1[i]};
+            int ids[4] = {id0, id1, id2, id3};
+            if (isRing)
+            {
+                std::swap(ids[1], ids[3]);
+                std::swap(qx[1], qx[3]);
+                std::swap(qy[1], qy[3]);
+            }
+
+            if (Predicates::inCircle(qx[0], qy[0], qx[1], qy[1], qx[2], qy[2], qx[3], qy[3]) > 0.0) // Corner 3 is inside: use the other diagonal.
+            {
+                cell[0] = ids[0]; cell[1] = ids[1]; cell[2] = ids[3];
+                writeCell();
+                cell[0] = ids[1]; cell[1] = ids[2]; cell[2] = ids[3];
+                writeCell();
+            }
+            else
+            {
+                cell[0] = ids[0]; cell[1] = ids[1]; cell[2] = ids[2];
+                writeCell();
+                cell[0] = ids[0]; cell[1] = ids[2]; cell[2] = ids[3];
+                writeCell();
+            }
+        }
+    }
+
+    myFile.write(buffer.data(), p - buffer.data());
+    myFile.flush();
+    return !myFile.fail();
+}
+
+const char *MeshGenerator::getName(Distribution distribution)
+{
+    switch (distribution)
+    {
+    case UNIFORM: return "uniform";
+    case CLUSTERED: return "clustered";
+    case GRID: return "grid";
+    case COCIRCULAR: return "cocircular";
+    }
+    return "unknown";
+}
+
+bool MeshGenerator::parseDistribution(const char *name, Distribution &distribution)
+{
+    Distribution all[4] = {UNIFORM, CLUSTERED, GRID, COCIRCULAR};
+    for (int k = 0; k < 4; ++k)
+    {
+        if (std::strcmp(name, getName(all[k])) == 0)
+        {
+            distribution = all[k];
+            return true;
+        }
+    }
+    return false;
+}
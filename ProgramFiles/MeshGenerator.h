@@ -0,0 +1,60 @@
+#ifndef MESHGENERATOR_H
+#define MESHGENERATOR_H
+
+#include <ostream> // Output of the generated mesh.
+
+/*
+    The following MeshGenerator class writes synthetic .tri meshes of a chosen size for scale and stress tests. The
+    points form a lattice of rows, each quadrilateral between two rows being split into two triangles, so the mesh is
+    always a valid triangulation (no overlaps, no gaps, every triangle counter-clockwise) and is Delaunay. The mesh is
+    never held in memory: the points are written row by row and the cells are written afterwards from two rows of
+    recomputed coordinates, so memory is proportional to the length of a row (about the square root of the number of
+    cells) and time is linear in the size of the file. Everything is derived from the seed, so the same settings
+    always give the same file. The distributions are:
+        UNIFORM - a lattice with every point moved randomly within its cell, uniform density in general position.
+        CLUSTERED - lattice lines drawn together around a few centres on each axis, dense clusters where they cross.
+        GRID - the plain integer lattice: rows of collinear points and every quadrilateral a cocircular square.
+        COCIRCULAR - rings of points around a centre, each quadrilateral having its corners on one circle up to the
+            rounding of the coordinates, which is the hardest case for the in-circle filter.
+*/
+class MeshGenerator
+{
+public:
+    enum Distribution { UNIFORM, CLUSTERED, GRID, COCIRCULAR };
+
+    // Sets up a mesh with at least numberOfCells cells (rounded up to whole rows) and the given number of
+    // attributes per cell, which are filled with random values in [0, 1).
+    MeshGenerator(Distribution distribution, int numberOfCells, int numberOfAttributesPerCell = 0, unsigned int seed = 1);
+
+    int getNumberOfPoints() const // Points of the generated mesh.
+    {
+        return numberOfPoints;
+    }
+
+    int getNumberOfCells() const // Cells of the generated mesh.
+    {
+        return numberOfCells;
+    }
+
+    bool write(std::ostream &myFile); // Streams the mesh in .tri format. Returns false if writing failed.
+
+    static const char *getName(Distribution distribution); // Name of a distribution, as accepted by parseDistribution().
+    static bool parseDistribution(const char *name, Distribution &distribution); // Returns false for an unknown name.
+
+    static const int MAXIMUM_CELLS = 1000000000; // Larger meshes would overflow the int IDs.
+
+private:
+    Distribution myDistribution;
+    int numberOfAttributesPerCell;
+    unsigned int mySeed;
+    int numberOfRows, rowLength; // Rows of points and points per row.
+    bool isRing; // Rows are closed rings around a centre point (COCIRCULAR) instead of open lines.
+    int numberOfPoints, numberOfCells;
+
+    int getPointId(int row, int i) const; // ID of point i of the given row.
+    void calculateRow(int row, float *x, float *y) const; // Coordinates of the points of a row.
+    double warp(double u, int axis) const; // Position of lattice line u (0 to 1) along an axis in CLUSTERED.
+    float random(unsigned long long key, int stream) const; // Uniform value in [0, 1) determined by the seed, key and stream.
+};
+
+#endif
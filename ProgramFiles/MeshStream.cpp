@@ -0,0 +1,346 @@
+#include "MeshStream.h"
+#include "TriFormat.h" // Parsing routines for text files.
+#include <cstring> // Copying the header of a binary file.
+#include <algorithm> // std::max.
+
+/*
+    Constructor. Nothing is opened yet.
+*/
+MeshStream::MeshStream(std::size_t memoryLimit) : memoryLimit(memoryLimit), isBinary(false), pointIds(NULL), cellIds(NULL), numberOfPoints(0), numberOfCells(0), numberOfAttributesPerCell(0), cellsBegin(NULL), position(NULL), nextCell(0), points(NULL), xOffset(0), yOffset(0), zOffset(0), pageSize(1024), numberOfPages(0), chunkCapacity(0)
+{
+}
+
+MeshStream::~MeshStream()
+{
+    close();
+}
+
+/*
+    The following method opens the mesh file with the given name. A binary mesh file is recognised by its
+    header; anything else is read as .tri text, whose points are copied into a temporary file here. The memory
+    limit is then divided: half for the chunk of cells, half for the pages of points.
+*/
+bool MeshStream::open(const char *fileName)
+{
+    close();
+    if (!file.open(fileName))
+    {
+        error = std::string("unable to open ") + fileName;
+        return false;
+    }
+
+    isBinary = file.getSize() >= sizeof(header) && std::memcmp(file.getData(), "TRIMESH", 8) == 0;
+    if (isBinary)
+    {
+        std::memcpy(&header, file.getData(), sizeof(header));
+        if (!TriBinary::check(header, file.getSize(), error))
+        {
+            close();
+            return false;
+        }
+        numberOfPoints = header.numberOfPoints;
+        numberOfCells = header.numberOfCells;
+        numberOfAttributesPerCell = header.numberOfAttributesPerCell;
+        if (header.pointIdsOffset != 0) // Version 2 files may carry the IDs; the connectivity holds positions either way.
+        {
+            pointIds = (const std::int64_t *)(file.getData() + header.pointIdsOffset);
+            cellIds = (const std::int64_t *)(file.getData() + header.cellIdsOffset);
+        }
+        points = std::fopen(fileName, "rb"); // The coordinates are read from the file itself.
+        xOffset = header.xOffset;
+        yOffset = header.yOffset;
+        zOffset = header.zOffset;
+    }
+    else
+    {
+        const char *begin(file.getData()), *end(begin + file.getSize());
+        position = begin;
+        TriHeader cells;
+        if (!copyPoints(position, end))
+        {
+            error = "line " + std::to_string(TriFormat::lineNumber(begin, position)) + ": " + error;
+            close();
+            return false;
+        }
+        if (!TriFormat::parseHeader(position, end, cells) || cells.valuesPerEntry != 3)
+        {
+            error = "line " + std::to_string(TriFormat::lineNumber(begin, position)) + ": malformed cells header";
+            close();
+            return false;
+        }
+        numberOfCells = cells.count;
+        numberOfAttributesPerCell = cells.attributesPerEntry;
+        cellsBegin = position;
+    }
+    if (points == NULL)
+    {
+        error = "unable to open the points store";
+        close();
+        return false;
+    }
+
+    std::size_t cellBytes(sizeof(StreamedCell) + sizeof(float) * numberOfAttributesPerCell);
+    chunkCapacity = std::max<std::size_t>(std::min<std::size_t>(memoryLimit / 2 / cellBytes, numberOfCells), 1); // No bigger than needed for a small mesh.
+    chunk.resize(chunkCapacity);
+    chunkAttributes.resize((std::size_t)chunkCapacity * numberOfAttributesPerCell);
+    numberOfPages = std::max<std::size_t>(std::min<std::size_t>(memoryLimit / 2 / (3 * sizeof(float) * pageSize), (numberOfPoints + pageSize - 1) / pageSize), 1);
+    pageOfSlot.assign(numberOfPages, -1);
+    pageData.resize((std::size_t)numberOfPages * pageSize * 3);
+    return rewind();
+}
+
+/*
+    The following method closes the file, deletes the temporary points file and frees the buffers.
+*/
+void MeshStream::close()
+{
+    if (points != NULL)
+    {
+        std::fclose(points); // A temporary file is deleted on closing.
+        points = NULL;
+    }
+    file.close();
+    pointIds = cellIds = NULL;
+    pointIndex.clear();
+    std::vector<int>().swap(pageOfSlot);
+    std::vector<float>().swap(pageData);
+    std::vector<StreamedCell>().swap(chunk);
+    std::vector<float>().swap(chunkAttributes);
+    numberOfPoints = numberOfCells = numberOfAttributesPerCell = 0;
+    isBinary = false;
+    cellsBegin = position = NULL;
+    nextCell = 0;
+}
+
+/*
+    The following method starts the cells again from the first one.
+*/
+bool MeshStream::rewind()
+{
+    if (points == NULL)
+    {
+        error = "no mesh is open";
+        return false;
+    }
+    position = cellsBegin;
+    nextCell = 0;
+    return true;
+}
+
+/*
+    The following method parses the points section of a text file and writes the coordinates into a temporary
+    file as three blocks of floats in file order, the same layout as a binary mesh file, and indexes the IDs of
+    the points by their positions there. The IDs need not be dense, as in Triangulation::load(), but must not
+    repeat. The part of the mapped file already parsed is released as it goes.
+*/
+bool MeshStream::copyPoints(const char *&position, const char *end)
+{
+    TriHeader header;
+    if (!TriFormat::parseHeader(position, end, header) || header.valuesPerEntry < 1 || header.valuesPerEntry > 3)
+    {
+        error = "malformed points header";
+        return false;
+    }
+    numberOfPoints = header.count;
+    points = std::tmpfile();
+    if (points == NULL)
+    {
+        error = "unable to create the temporary points file";
+        return false;
+    }
+    xOffset = 0;
+    yOffset = 4LL * numberOfPoints;
+    zOffset = 8LL * numberOfPoints;
+
+    const int batch(4096); // Points parsed before writing them out.
+    std::vector<float> coordinates(3 * batch);
+    for (int j = 0; j < numberOfPoints; j += batch)
+    {
+        int count(std::min(batch, numberOfPoints - j));
+        for (int k = 0; k < count; ++k)
+        {
+            long long id;
+            float attribute;
+            coordinates[k] = coordinates[batch + k] = coordinates[2 * batch + k] = 0.0f;
+            TriFormat::skipWhitespace(position, end);
+            if (position == end)
+            {
+                error = "expected " + std::to_string(numberOfPoints) + " points, found " + std::to_string(j + k);
+                return false;
+            }
+            if (!TriFormat::parseId(position, end, id))
+            {
+                error = "malformed point ID";
+                return false;
+            }
+            if (!pointIndex.insert(id, j + k))
+            {
+                error = "point ID " + std::to_string(id) + " is repeated";
+                return false;
+            }
+            for (int i = 0; i < header.valuesPerEntry + header.attributesPerEntry; ++i)
+            {
+                if (!TriFormat::parseFloat(position, end, i < header.valuesPerEntry ? coordinates[i * batch + k] : attribute))
+                {
+                    error = "point " + std::to_string(id) + " has fewer values than the header announces";
+                    return false;
+                }
+            }
+            if (!TriFormat::endOfLine(position, end))
+            {
+                error = "point " + std::to_string(id) + " has more values than the header announces";
+                return false;
+            }
+        }
+        long long offsets[3] = {xOffset, yOffset, zOffset};
+        for (int i = 0; i < 3; ++i) // Append the batch to each coordinate block.
+        {
+            if (std::fseek(points, offsets[i] + 4LL * j, SEEK_SET) != 0 || (int)std::fwrite(&coordinates[i * batch], sizeof(float), count, points) != count)
+            {
+                error = "unable to write the temporary points file";
+                return false;
+            }
+        }
+        file.release(0, position - file.getData());
+    }
+    if (std::fflush(points) != 0)
+    {
+        error = "unable to write the temporary points file";
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method returns the coordinates of the point at the given position. Pages of pageSize points
+    are kept in a direct mapped cache: page p lives in slot p % numberOfPages and replaces whatever was there.
+*/
+bool MeshStream::lookupPoint(int point, float &x, float &y, float &z)
+{
+    int page(point / pageSize), slot(page % numberOfPages);
+    float *data(&pageData[(std::size_t)slot * pageSize * 3]);
+    if (pageOfSlot[slot] != page) // Load the page from the points store.
+    {
+        int first(page * pageSize), count(std::min(pageSize, numberOfPoints - first));
+        long long offsets[3] = {xOffset, yOffset, zOffset};
+        for (int i = 0; i < 3; ++i)
+        {
+            if (std::fseek(points, offsets[i] + 4LL * first, SEEK_SET) != 0 || (int)std::fread(data + i * pageSize, sizeof(float), count, points) != count)
+            {
+                pageOfSlot[slot] = -1;
+                return false;
+            }
+        }
+        pageOfSlot[slot] = page;
+    }
+    int k(point - page * pageSize);
+    x = data[k];
+    y = data[pageSize + k];
+    z = data[2 * pageSize + k];
+    return true;
+}
+
+/*
+    The following method parses the next cell line of a text file into cell and attributes. The vertices are
+    left as IDs; readChunk() looks them up.
+*/
+bool MeshStream::readTextCell(StreamedCell &cell, float *attributes)
+{
+    const char *end(file.getData() + file.getSize());
+    TriFormat::skipWhitespace(position, end);
+    if (position == end)
+    {
+        error = "expected " + std::to_string(numberOfCells) + " cells, found " + std::to_string(nextCell);
+        return false;
+    }
+    if (!TriFormat::parseId(position, end, cell.id))
+    {
+        error = "malformed cell ID";
+        return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!TriFormat::parseId(position, end, cell.vertices[i]))
+        {
+            error = "cell " + std::to_string(cell.id) + " has fewer than 3 vertices";
+            return false;
+        }
+    }
+    for (int i = 0; i < numberOfAttributesPerCell; ++i)
+    {
+        if (!TriFormat::parseFloat(position, end, attributes[i]))
+        {
+            error = "cell " + std::to_string(cell.id) + " has fewer attributes than the header announces";
+            return false;
+        }
+    }
+    if (!TriFormat::endOfLine(position, end))
+    {
+        error = "cell " + std::to_string(cell.id) + " has more values than the header announces";
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method fills the chunk with the next cells and looks up the coordinates of their vertices.
+    The vertices of a text file are found by ID; those of a binary file are stored as positions and are given
+    the IDs of the points.
+*/
+int MeshStream::readChunk()
+{
+    if (points == NULL)
+    {
+        error = "no mesh is open";
+        return -1;
+    }
+    int count(std::min(chunkCapacity, numberOfCells - nextCell));
+    for (int k = 0; k < count; ++k)
+    {
+        StreamedCell &cell = chunk[k];
+        int vertices[3]; // Positions of the vertices in a binary file.
+        float *attributes(chunkAttributes.data() + (std::size_t)k * numberOfAttributesPerCell);
+        if (isBinary)
+        {
+            std::size_t j(nextCell + k);
+            std::memcpy(vertices, file.getData() + header.connectivityOffset + 3 * sizeof(int) * j, 3 * sizeof(int));
+            std::memcpy(attributes, file.getData() + header.attributesOffset + sizeof(float) * numberOfAttributesPerCell * j, sizeof(float) * numberOfAttributesPerCell);
+            cell.id = cellIds != NULL ? cellIds[j] : (long long)j;
+        }
+        else if (!readTextCell(cell, attributes))
+        {
+            error = "line " + std::to_string(TriFormat::lineNumber(file.getData(), position)) + ": " + error;
+            return -1;
+        }
+        cell.attributes = attributes;
+        for (int i = 0; i < 3; ++i)
+        {
+            int point(isBinary ? vertices[i] : pointIndex.find(cell.vertices[i]));
+            if (point < 0 || point >= numberOfPoints || !lookupPoint(point, cell.x[i], cell.y[i], cell.z[i]))
+            {
+                error = "cell " + std::to_string(cell.id) + " refers to a point which does not exist";
+                return -1;
+            }
+            if (isBinary)
+            {
+                cell.vertices[i] = pointIds != NULL ? pointIds[point] : (long long)point;
+            }
+        }
+    }
+    nextCell += count;
+
+    if (isBinary) // Hand back the part of the file read so far.
+    {
+        file.release(header.connectivityOffset, header.connectivityOffset + 3 * sizeof(int) * (std::size_t)nextCell);
+        file.release(header.attributesOffset, header.attributesOffset + sizeof(float) * numberOfAttributesPerCell * (std::size_t)nextCell);
+        if (cellIds != NULL)
+        {
+            file.release(header.cellIdsOffset, header.cellIdsOffset + sizeof(std::int64_t) * (std::size_t)nextCell);
+        }
+    }
+    else
+    {
+        file.release(0, position - file.getData());
+    }
+    return count;
+}
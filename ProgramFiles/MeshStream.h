@@ -0,0 +1,160 @@
+#ifndef MESHSTREAM_H
+#define MESHSTREAM_H
+
+#include <cstdio> // Temporary file and paged reads of the points.
+#include <cstddef> // For std::size_t.
+#include <string> // Error messages.
+#include <vector> // Chunk and page buffers.
+#include <cstdint> // 64 bit IDs of binary files.
+#include "MappedFile.h" // The mesh file is mapped and read front to back.
+#include "TriBinary.h" // Binary mesh files are streamed as well.
+#include "IdIndex.h" // Positions of the points of a text file by ID.
+#include "Triangle.h" // Area and circumcentre formulas for the integration.
+
+/*
+    The following StreamedCell struct is one triangle handed to a visitor by MeshStream: its ID, the IDs and
+    coordinates of its vertices and its attributes, with the IDs as in the file, the same as Triangulation keeps
+    them. It is only valid during the call of the visitor.
+*/
+struct StreamedCell
+{
+    long long id;
+    long long vertices[3];
+    float x[3], y[3], z[3];
+    const float *attributes;
+};
+
+/*
+    The following MeshStream class reads a mesh from a .tri file or a binary mesh file (see TriBinary.h) cell by
+    cell without loading it, for meshes too big for the memory of the machine. The cells are parsed a chunk at a
+    time and the coordinates of their vertices are looked up in a points store: the points of a text file are
+    copied once into a temporary binary file in file order, with an IdIndex from their IDs to their positions,
+    those of a binary file are read from it directly, in both cases through a fixed number of cached pages. The
+    IDs of a binary file come from its ID blocks, if it has them. The parts of the mesh file already read are handed back to the
+    system. The memory used is therefore set by memoryLimit and not by the size of the mesh, apart from the
+    index of the point IDs of a text file, which is empty when the IDs are 0 to numberOfPoints - 1 in order.
+    The cells must be ordered so that the points they use are close together in the file for the page cache to
+    be effective, which is the case for meshes written by mesh generators.
+*/
+class MeshStream
+{
+public:
+    MeshStream(std::size_t memoryLimit = 64 << 20); // Constructor; memoryLimit is split between the cell chunk and the point pages.
+    ~MeshStream();
+
+    bool open(const char *fileName); // Opens a mesh file and prepares the points store. Returns false with getError() set on failure.
+    void close(); // Releases the file and the buffers.
+
+    bool rewind(); // Goes back to the first cell.
+    int readChunk(); // Parses the next chunk of cells. Returns the number of cells in it, 0 at the end and -1 on an error.
+
+    StreamedCell *getChunk() // The cells of the last chunk read.
+    {
+        return chunk.data();
+    }
+
+    const std::string &getError() // Reason of the last failure.
+    {
+        return error;
+    }
+
+    int getNumberOfPoints() // Counts from the headers of the file.
+    {
+        return numberOfPoints;
+    }
+
+    int getNumberOfCells()
+    {
+        return numberOfCells;
+    }
+
+    int getNumberOfAttributesPerCell()
+    {
+        return numberOfAttributesPerCell;
+    }
+
+    template<typename V>
+    bool forEachCell(V visitor); // Calls visitor(StreamedCell &) for every cell in file order. Returns false on an error.
+
+    template<typename T>
+    float integration(T t, bool method); // Same as Triangulation::integration() on the loaded mesh, with the same result.
+
+private:
+    MeshStream(const MeshStream &); // Owns a file.
+    MeshStream &operator=(const MeshStream &);
+
+    bool copyPoints(const char *&position, const char *end); // Parses the points of a text file into the temporary points file.
+    bool lookupPoint(int point, float &x, float &y, float &z); // Coordinates of the point at the given position through the page cache.
+    bool readTextCell(StreamedCell &cell, float *attributes); // Parses the next cell line of a text file.
+
+    std::size_t memoryLimit; // Bytes for the chunk and the pages together.
+    MappedFile file; // The mesh file.
+    bool isBinary; // Binary mesh file rather than text.
+    TriBinaryHeader header; // Header of a binary file.
+    const std::int64_t *pointIds, *cellIds; // ID blocks of a binary file in the mapping, NULL if the IDs are the positions.
+    IdIndex pointIndex; // Positions of the points of a text file by ID.
+    std::string error;
+
+    int numberOfPoints, numberOfCells, numberOfAttributesPerCell;
+    const char *cellsBegin, *position; // Text files: start of the first cell line and the next line to parse.
+    int nextCell; // Index of the next cell to read.
+
+    std::FILE *points; // Temporary file holding the x, y and z blocks of a text file, or the binary file itself.
+    long long xOffset, yOffset, zOffset; // Offsets of the coordinate blocks in points.
+    int pageSize, numberOfPages; // Points per page and pages in the cache.
+    std::vector<int> pageOfSlot; // Page held by each cache slot, -1 if none.
+    std::vector<float> pageData; // x, y and z of pageSize points per slot.
+
+    std::vector<StreamedCell> chunk; // Cells of the current chunk.
+    std::vector<float> chunkAttributes; // Their attributes.
+    int chunkCapacity; // Cells per chunk.
+};
+
+/*
+    The following method runs visitor over every cell of the file from the first one on.
+*/
+template<typename V>
+bool MeshStream::forEachCell(V visitor)
+{
+    if (!rewind())
+    {
+        return false;
+    }
+    int count;
+    while ((count = readChunk()) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            visitor(chunk[i]);
+        }
+    }
+    return count == 0;
+}
+
+/*
+    The following method integrates t over the mesh with the Constant Value Approximation (method true) or the
+    Linear Interpolation Approximation (method false), with the same formulas and summation order as
+    Triangulation::integration(), so a mesh gives the same result streamed or loaded. Returns 0 on an error.
+*/
+template<typename T>
+float MeshStream::integration(T t, bool method)
+{
+    float sum = 0;
+    bool isRead(forEachCell([&](StreamedCell &cell)
+    {
+        float area(Triangle::calculateArea(cell.x[0], cell.y[0], cell.x[1], cell.y[1], cell.x[2], cell.y[2]));
+        if (method)
+        {
+            float centreX, centreY, radiusSquared;
+            Triangle::calculateCircumcentre(cell.x[0], cell.y[0], cell.x[1], cell.y[1], cell.x[2], cell.y[2], centreX, centreY, radiusSquared);
+            sum += (area * t(centreX, centreY));
+        }
+        else
+        {
+            sum += ((area / 3) * (t(cell.x[0], cell.y[0]) + t(cell.x[1], cell.y[1]) + t(cell.x[2], cell.y[2])));
+        }
+    }));
+    return isRead ? sum : 0;
+}
+
+#endif
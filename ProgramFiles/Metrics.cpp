@@ -0,0 +1,237 @@
+#include "Metrics.h"
+#include <mutex> // Guards the list of blocks.
+#include <vector> // Blocks of the running threads.
+#include <string> // Names in the exports.
+
+#if TRIANGULATION_METRICS
+/*
+    The blocks of the running threads and the totals of the finished ones. They are created on first use so that
+    they exist before the first block registers itself.
+*/
+struct MetricsRegistry
+{
+    std::mutex lock;
+    std::vector<MetricsBlock*> blocks;
+    MetricsSnapshot finished;
+};
+
+static MetricsRegistry &getRegistry()
+{
+    static MetricsRegistry *registry(new MetricsRegistry()); // Never destroyed: threads may finish after the static destructors have run.
+    return *registry;
+}
+
+thread_local MetricsBlock threadMetrics;
+
+MetricsBlock::MetricsBlock() : counters(), counts(), sums(), buckets(), sampleTick(0)
+{
+    MetricsRegistry &registry(getRegistry());
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.blocks.push_back(this);
+}
+
+MetricsBlock::~MetricsBlock()
+{
+    MetricsRegistry &registry(getRegistry());
+    std::lock_guard<std::mutex> guard(registry.lock);
+    MetricsSnapshot &finished(registry.finished);
+    for (int c = 0; c < Metrics::NUMBER_OF_COUNTERS; ++c)
+    {
+        finished.counters[c] += counters[c].load(std::memory_order_relaxed);
+    }
+    for (int h = 0; h < Metrics::NUMBER_OF_HISTOGRAMS; ++h)
+    {
+        finished.counts[h] += counts[h].load(std::memory_order_relaxed);
+        finished.sums[h] += sums[h].load(std::memory_order_relaxed);
+        for (int b = 0; b < Metrics::NUMBER_OF_BUCKETS; ++b)
+        {
+            finished.buckets[h][b] += buckets[h][b].load(std::memory_order_relaxed);
+        }
+    }
+    for (std::size_t k = 0; k < registry.blocks.size(); ++k)
+    {
+        if (registry.blocks[k] == this)
+        {
+            registry.blocks[k] = registry.blocks.back();
+            registry.blocks.pop_back();
+            break;
+        }
+    }
+}
+#endif
+
+/*
+    The following method adds up the blocks of the running threads and the totals of the finished ones. The
+    counts of a thread which is busy may be a moment old, but every value is one the thread has written.
+*/
+MetricsSnapshot Metrics::getSnapshot()
+{
+    MetricsSnapshot snapshot;
+#if TRIANGULATION_METRICS
+    MetricsRegistry &registry(getRegistry());
+    std::lock_guard<std::mutex> guard(registry.lock);
+    snapshot = registry.finished;
+    for (std::size_t k = 0; k < registry.blocks.size(); ++k)
+    {
+        MetricsBlock &block(*registry.blocks[k]);
+        for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+        {
+            snapshot.counters[c] += block.counters[c].load(std::memory_order_relaxed);
+        }
+        for (int h = 0; h < NUMBER_OF_HISTOGRAMS; ++h)
+        {
+            snapshot.counts[h] += block.counts[h].load(std::memory_order_relaxed);
+            snapshot.sums[h] += block.sums[h].load(std::memory_order_relaxed);
+            for (int b = 0; b < NUMBER_OF_BUCKETS; ++b)
+            {
+                snapshot.buckets[h][b] += block.buckets[h][b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+#endif
+    return snapshot;
+}
+
+void Metrics::reset()
+{
+#if TRIANGULATION_METRICS
+    MetricsRegistry &registry(getRegistry());
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.finished = MetricsSnapshot();
+    for (std::size_t k = 0; k < registry.blocks.size(); ++k)
+    {
+        MetricsBlock &block(*registry.blocks[k]);
+        for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+        {
+            block.counters[c].store(0, std::memory_order_relaxed);
+        }
+        for (int h = 0; h < NUMBER_OF_HISTOGRAMS; ++h)
+        {
+            block.counts[h].store(0, std::memory_order_relaxed);
+            block.sums[h].store(0, std::memory_order_relaxed);
+            for (int b = 0; b < NUMBER_OF_BUCKETS; ++b)
+            {
+                block.buckets[h][b].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+#endif
+}
+
+void Metrics::reset(Counter counter)
+{
+#if TRIANGULATION_METRICS
+    MetricsRegistry &registry(getRegistry());
+    std::lock_guard<std::mutex> guard(registry.lock);
+    registry.finished.counters[counter] = 0;
+    for (std::size_t k = 0; k < registry.blocks.size(); ++k)
+    {
+        registry.blocks[k]->counters[counter].store(0, std::memory_order_relaxed);
+    }
+#else
+    (void)counter;
+#endif
+}
+
+const char *Metrics::getName(Counter counter)
+{
+    static const char *names[NUMBER_OF_COUNTERS] = {"orientation_tests", "orientation_exact", "in_circle_tests", "in_circle_exact",
+        "locate_calls", "locate_fallbacks", "grid_candidates", "circumcircle_queries", "circumcircle_hits",
+        "circumcentre_recomputations", "parsed_bytes", "mesh_allocations", "mesh_allocated_bytes"};
+    return names[counter];
+}
+
+const char *Metrics::getName(Histogram histogram)
+{
+    static const char *names[NUMBER_OF_HISTOGRAMS] = {"locate_latency", "locate_visited_triangles", "point_in_triangle_latency",
+        "circumcircle_latency", "delaunay_check_latency", "insert_latency", "parse_latency"};
+    return names[histogram];
+}
+
+bool Metrics::isLatency(Histogram histogram)
+{
+    return histogram != LOCATE_VISITED;
+}
+
+/*
+    The following method writes a snapshot as JSON. Each histogram lists its non-empty buckets by their largest
+    value ("le", as in Prometheus); the last bucket has no limit.
+*/
+void Metrics::writeJson(std::ostream &myFile)
+{
+    MetricsSnapshot snapshot(getSnapshot());
+    myFile << "{\n  \"enabled\": " << (isEnabled() ? "true" : "false") << ",\n  \"counters\": {";
+    for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+    {
+        myFile << (c > 0 ? ",\n" : "\n") << "    \"" << getName((Counter)c) << "\": " << snapshot.counters[c];
+    }
+    myFile << "\n  },\n  \"parse_bytes_per_second\": " << snapshot.getParseBytesPerSecond() << ",\n  \"histograms\": {";
+    for (int h = 0; h < NUMBER_OF_HISTOGRAMS; ++h)
+    {
+        myFile << (h > 0 ? ",\n" : "\n") << "    \"" << getName((Histogram)h) << "\": {\"unit\": \"" << (isLatency((Histogram)h) ? "ns" : "triangles") << "\"";
+        myFile << ", \"count\": " << snapshot.counts[h] << ", \"sum\": " << snapshot.sums[h] << ", \"buckets\": [";
+        bool isFirst(true);
+        for (int b = 0; b < NUMBER_OF_BUCKETS; ++b)
+        {
+            if (snapshot.buckets[h][b] == 0)
+            {
+                continue;
+            }
+            myFile << (isFirst ? "" : ", ") << "{\"le\": ";
+            if (b == NUMBER_OF_BUCKETS - 1)
+            {
+                myFile << "\"+Inf\"";
+            }
+            else
+            {
+                myFile << ((1ULL << b) - 1);
+            }
+            myFile << ", \"count\": " << snapshot.buckets[h][b] << "}";
+            isFirst = false;
+        }
+        myFile << "]}";
+    }
+    myFile << "\n  }\n}\n";
+}
+
+/*
+    The following method writes a snapshot in the Prometheus text exposition format. Counters get the _total
+    suffix and latencies are converted to seconds. Histogram buckets are cumulative and only written up to the
+    largest value recorded.
+*/
+void Metrics::writePrometheus(std::ostream &myFile)
+{
+    MetricsSnapshot snapshot(getSnapshot());
+    std::streamsize oldPrecision(myFile.precision(9));
+    for (int c = 0; c < NUMBER_OF_COUNTERS; ++c)
+    {
+        std::string name(std::string("triangulation_") + getName((Counter)c) + "_total");
+        myFile << "# TYPE " << name << " counter\n" << name << " " << snapshot.counters[c] << "\n";
+    }
+    myFile << "# TYPE triangulation_parse_bytes_per_second gauge\ntriangulation_parse_bytes_per_second " << snapshot.getParseBytesPerSecond() << "\n";
+    for (int h = 0; h < NUMBER_OF_HISTOGRAMS; ++h)
+    {
+        bool isTime(isLatency((Histogram)h));
+        double scale(isTime ? 1e-9 : 1.0);
+        std::string name(std::string("triangulation_") + getName((Histogram)h) + (isTime ? "_seconds" : ""));
+        int last(-1);
+        for (int b = 0; b < NUMBER_OF_BUCKETS - 1; ++b)
+        {
+            if (snapshot.buckets[h][b] != 0)
+            {
+                last = b;
+            }
+        }
+        myFile << "# TYPE " << name << " histogram\n";
+        unsigned long long cumulative(0);
+        for (int b = 0; b <= last; ++b)
+        {
+            cumulative += snapshot.buckets[h][b];
+            myFile << name << "_bucket{le=\"" << ((1ULL << b) - 1) * scale << "\"} " << cumulative << "\n";
+        }
+        myFile << name << "_bucket{le=\"+Inf\"} " << snapshot.counts[h] << "\n";
+        myFile << name << "_sum " << snapshot.sums[h] * scale << "\n";
+        myFile << name << "_count " << snapshot.counts[h] << "\n";
+    }
+    myFile.precision(oldPrecision);
+}
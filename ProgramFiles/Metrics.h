@@ -0,0 +1,197 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic> // Counts which other threads may read while they are updated.
+#include <chrono> // Latency measurements.
+#include <ostream> // Export.
+
+// Instrumentation is compiled in unless TRIANGULATION_METRICS is defined as 0, in which case every call below is an
+// empty inline function and costs nothing.
+#ifndef TRIANGULATION_METRICS
+#define TRIANGULATION_METRICS 1
+#endif
+
+struct MetricsSnapshot;
+
+/*
+    The following Metrics class counts what the hot paths of the library do: counters of events and histograms of
+    latencies (in nanoseconds) or sizes. Each thread updates its own block of counts, without any synchronisation
+    beyond a plain add, and the blocks are only added up when a snapshot or an export is asked for. Blocks of
+    threads which have finished are kept in the totals. The histograms have power of two buckets: bucket b holds
+    the values from 2^(b - 1) to 2^b - 1 and bucket 0 holds zero.
+*/
+class Metrics
+{
+public:
+    enum Counter
+    {
+        ORIENTATION_TESTS, // Orientation predicates evaluated, by the filter or exactly.
+        ORIENTATION_EXACT, // Orientation predicates which needed the exact calculation.
+        IN_CIRCLE_TESTS, // In-circle predicates evaluated.
+        IN_CIRCLE_EXACT, // In-circle predicates which needed the exact calculation.
+        LOCATE_CALLS, // Calls of locate() for one point.
+        LOCATE_FALLBACKS, // Walks of locate() which failed and were replaced by the grid.
+        GRID_CANDIDATES, // Triangles tested against a point taken from the point location grid.
+        CIRCUMCIRCLE_QUERIES, // Points tested against every circumcircle of the mesh.
+        CIRCUMCIRCLE_HITS, // Triangles found with the point inside their circumcircle.
+        CIRCUMCENTRE_RECOMPUTATIONS, // Areas and circumcircles calculated for the geometry cache or a Triangle.
+        PARSED_BYTES, // Bytes of .tri text parsed by load().
+        MESH_ALLOCATIONS, // Heap allocations of vertices and triangles by the mesh.
+        MESH_ALLOCATED_BYTES, // Their size in bytes.
+        NUMBER_OF_COUNTERS
+    };
+
+    enum Histogram
+    {
+        LOCATE_LATENCY, // Time of locate() for one point, sampled.
+        LOCATE_VISITED, // Triangles visited by one walk of locate().
+        POINT_IN_TRIANGLE_LATENCY, // Time of isPointInAnyTriangle(), sampled.
+        CIRCUMCIRCLE_LATENCY, // Time of isPointInCircumcircle() and isOldPointInCircumcircle().
+        DELAUNAY_CHECK_LATENCY, // Time of checkDelaunay() and isDelaunay().
+        INSERT_LATENCY, // Time of insertVertex().
+        PARSE_LATENCY, // Time of load(), which with PARSED_BYTES gives the parse rate.
+        NUMBER_OF_HISTOGRAMS
+    };
+
+    static const int NUMBER_OF_BUCKETS = 48; // The last bucket also takes every larger value.
+    static const unsigned int SAMPLE_PERIOD = 16; // Operations too short to read the clock twice per call are timed once in this many calls.
+
+    static bool isEnabled() // Whether the instrumentation is compiled in.
+    {
+        return TRIANGULATION_METRICS != 0;
+    }
+
+    static void add(Counter counter, unsigned long long amount = 1); // Adds to a counter of the calling thread.
+    static void record(Histogram histogram, unsigned long long value); // Adds a value to a histogram of the calling thread.
+    static void countAllocation(unsigned long long bytes); // Counts one allocation by the mesh.
+
+    static MetricsSnapshot getSnapshot(); // Totals of every thread, running or finished.
+    static void reset(); // Sets every counter and histogram to zero. Other threads should not be counting meanwhile.
+    static void reset(Counter counter); // Sets one counter to zero.
+
+    static void writeJson(std::ostream &myFile); // Exports a snapshot as one JSON object.
+    static void writePrometheus(std::ostream &myFile); // Exports a snapshot in the Prometheus text format.
+
+    static const char *getName(Counter counter); // Name used in the exports.
+    static const char *getName(Histogram histogram);
+    static bool isLatency(Histogram histogram); // Whether the values are nanoseconds.
+
+    static int getBucket(unsigned long long value) // Bucket of a value: the number of bits it needs.
+    {
+#if defined(__GNUC__)
+        int bucket(value == 0 ? 0 : 64 - __builtin_clzll(value));
+#else
+        int bucket(0);
+        for (unsigned long long rest = value; rest != 0; rest >>= 1)
+        {
+            ++bucket;
+        }
+#endif
+        return bucket < NUMBER_OF_BUCKETS ? bucket : NUMBER_OF_BUCKETS - 1;
+    }
+};
+
+/*
+    The following MetricsSnapshot struct holds the totals of all threads at one moment.
+*/
+struct MetricsSnapshot
+{
+    MetricsSnapshot() : counters(), counts(), sums(), buckets() {;}
+
+    double getParseBytesPerSecond() const // Bytes parsed by load() per second spent in it.
+    {
+        return sums[Metrics::PARSE_LATENCY] > 0 ? counters[Metrics::PARSED_BYTES] * 1e9 / sums[Metrics::PARSE_LATENCY] : 0.0;
+    }
+
+    unsigned long long counters[Metrics::NUMBER_OF_COUNTERS];
+    unsigned long long counts[Metrics::NUMBER_OF_HISTOGRAMS]; // Values recorded in each histogram.
+    unsigned long long sums[Metrics::NUMBER_OF_HISTOGRAMS]; // Their sum.
+    unsigned long long buckets[Metrics::NUMBER_OF_HISTOGRAMS][Metrics::NUMBER_OF_BUCKETS];
+};
+
+#if TRIANGULATION_METRICS
+/*
+    The counts of one thread. Only the owning thread writes them, so a relaxed load and store is enough for an add;
+    the atomics only make it safe for a snapshot to read them at the same time. The block registers itself on
+    construction and adds its counts to the totals of the finished threads on destruction.
+*/
+struct MetricsBlock
+{
+    MetricsBlock();
+    ~MetricsBlock();
+
+    static void increase(std::atomic<unsigned long long> &count, unsigned long long amount)
+    {
+        count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<unsigned long long> counters[Metrics::NUMBER_OF_COUNTERS];
+    std::atomic<unsigned long long> counts[Metrics::NUMBER_OF_HISTOGRAMS];
+    std::atomic<unsigned long long> sums[Metrics::NUMBER_OF_HISTOGRAMS];
+    std::atomic<unsigned long long> buckets[Metrics::NUMBER_OF_HISTOGRAMS][Metrics::NUMBER_OF_BUCKETS];
+    unsigned int sampleTick; // Calls seen by sampled timers, only used by the owning thread.
+};
+
+extern thread_local MetricsBlock threadMetrics;
+
+inline void Metrics::add(Counter counter, unsigned long long amount)
+{
+    MetricsBlock::increase(threadMetrics.counters[counter], amount);
+}
+
+inline void Metrics::record(Histogram histogram, unsigned long long value)
+{
+    MetricsBlock &block(threadMetrics);
+    MetricsBlock::increase(block.counts[histogram], 1);
+    MetricsBlock::increase(block.sums[histogram], value);
+    MetricsBlock::increase(block.buckets[histogram][getBucket(value)], 1);
+}
+
+inline void Metrics::countAllocation(unsigned long long bytes)
+{
+    MetricsBlock &block(threadMetrics);
+    MetricsBlock::increase(block.counters[MESH_ALLOCATIONS], 1);
+    MetricsBlock::increase(block.counters[MESH_ALLOCATED_BYTES], bytes);
+}
+#else
+inline void Metrics::add(Counter, unsigned long long) {;}
+inline void Metrics::record(Histogram, unsigned long long) {;}
+inline void Metrics::countAllocation(unsigned long long) {;}
+#endif
+
+/*
+    The following MetricsTimer class records the time from its construction to its destruction in a latency
+    histogram. With a period above 1 (a power of two) only one call in period is timed, since reading the clock
+    costs tens of nanoseconds. Without the instrumentation it does not read the clock.
+*/
+class MetricsTimer
+{
+public:
+#if TRIANGULATION_METRICS
+    explicit MetricsTimer(Metrics::Histogram histogram, unsigned int period = 1) : myHistogram(histogram)
+    {
+        isTimed = period <= 1 || (++threadMetrics.sampleTick & (period - 1)) == 0;
+        if (isTimed)
+        {
+            startTime = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~MetricsTimer()
+    {
+        if (isTimed)
+        {
+            Metrics::record(myHistogram, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count());
+        }
+    }
+
+private:
+    Metrics::Histogram myHistogram;
+    bool isTimed;
+    std::chrono::steady_clock::time_point startTime;
+#else
+    explicit MetricsTimer(Metrics::Histogram, unsigned int = 1) {;}
+#endif
+};
+
+#endif
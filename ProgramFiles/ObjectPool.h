@@ -0,0 +1,89 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <vector> // Chunks and the free list.
+#include <memory> // Ownership of the chunks.
+#include <new> // Placement new for resetting released objects.
+#include <algorithm> // std::min.
+#include "Metrics.h" // Counts the chunk allocations.
+
+/*
+    The following ObjectPool class hands out objects of type T from large chunks instead of allocating each one
+    on the heap. Chunks are never moved or freed while the pool lives, so a pointer to an object stays valid for
+    as long as the object is in use, however much the pool grows. Released objects are reset and put on a free
+    list, from which the next objects are taken, so a mesh which is edited all the time keeps reusing the same
+    memory. Single objects come from chunks which double in size up to MAXIMUM_CHUNK; a loader asking for
+    many objects at once gets one chunk of exactly that size. Only the chunk allocations go to the heap.
+*/
+template<typename T>
+class ObjectPool
+{
+public:
+    static const int FIRST_CHUNK = 64; // Objects in the first chunk for single objects.
+    static const int MAXIMUM_CHUNK = 1 << 16; // Largest chunk for single objects.
+
+    ObjectPool() : myNext(NULL), myRemaining(0), myChunkSize(FIRST_CHUNK) {;}
+
+    ObjectPool(const ObjectPool&) = delete; // The objects belong to exactly one pool.
+    ObjectPool &operator=(const ObjectPool&) = delete;
+
+    T *acquire() // Returns one default constructed object, reusing a released one if there is any.
+    {
+        if (!myFree.empty())
+        {
+            T *object(myFree.back());
+            myFree.pop_back();
+            return object;
+        }
+        if (myRemaining == 0)
+        {
+            myNext = allocate(myChunkSize);
+            myRemaining = myChunkSize;
+            myChunkSize = std::min(2 * myChunkSize, (int)MAXIMUM_CHUNK);
+        }
+        --myRemaining;
+        return myNext++;
+    }
+
+    T *acquireArray(int count) // Returns count consecutive default constructed objects in a chunk of their own, NULL for none.
+    {
+        return count > 0 ? allocate(count) : NULL;
+    }
+
+    void release(T *object) // Takes back an object. It is reset to a default constructed one and reused by acquire().
+    {
+        object->~T();
+        new (object) T();
+        myFree.push_back(object);
+    }
+
+    void clear() // Frees every chunk. All objects handed out become invalid.
+    {
+        myChunks.clear();
+        myFree.clear();
+        myNext = NULL;
+        myRemaining = 0;
+        myChunkSize = FIRST_CHUNK;
+    }
+
+    int getNumberOfFree() // Released objects waiting to be reused.
+    {
+        return myFree.size();
+    }
+
+private:
+    T *allocate(int count) // Adds a chunk of count objects.
+    {
+        myChunks.push_back(std::unique_ptr<T[]>(new T[count]));
+        Metrics::countAllocation(sizeof(T) * (unsigned long long)count);
+        return myChunks.back().get();
+    }
+
+    std::vector<std::unique_ptr<T[]> > myChunks; // Every chunk allocated, in order.
+    std::vector<T*> myFree; // Released objects.
+    T *myNext; // Next unused object of the current chunk for single objects.
+    int myRemaining; // Objects left after myNext in that chunk.
+    int myChunkSize; // Size of the next chunk for single objects.
+};
+
+#endif
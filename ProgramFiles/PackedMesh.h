@@ -0,0 +1,343 @@
+#ifndef PACKEDMESH_H
+#define PACKEDMESH_H
+
+#include <vector> // Needed for using the vector container.
+#include <cstddef> // For std::size_t.
+#include <cstdint> // IDs stored in a mapped file.
+#include <algorithm> // Copying a cell over a removed one.
+#include <memory> // Shared ownership of a mapped file.
+#include "MappedFile.h" // The arrays may live in a mapped file.
+
+/*
+    The following PackedMesh class is the storage of the mesh, in flat arrays instead of separate objects: one
+    array per coordinate of the points, their IDs and incident triangles, and for the cells three vertex
+    positions, three neighbours, an ID and a fixed number of attribute floats each. Neighbouring elements are
+    next to each other in memory which is what the loops running over the whole mesh want. The Vertex and
+    Triangle objects of a Triangulation only refer to a position in here and read and write these arrays.
+    The arrays can also be a view of blocks in a memory mapped file (see view()). Values can be changed in
+    place, which only copies the touched pages for this process. Adding or resizing first copies the points
+    or the cells involved into the vectors of this object. A file without ID blocks has the positions as IDs,
+    and one without neighbours gets them in a vector of this object.
+*/
+class PackedMesh
+{
+public:
+    PackedMesh() : attributeStride(0), mappedX(NULL), mappedY(NULL), mappedZ(NULL), mappedAttributes(NULL), mappedConnectivity(NULL), mappedNeighbours(NULL), mappedPointIds(NULL), mappedCellIds(NULL), mappedPoints(0), mappedCells(0), isPointsMapped(false), isCellsMapped(false) {;} // Constructor creates an empty storage.
+
+    PackedMesh(const PackedMesh&) = delete; // The Vertex and Triangle objects refer to exactly one storage.
+    PackedMesh &operator=(const PackedMesh&) = delete;
+
+    void clear() // Removes all points and cells.
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+        pointIds.clear();
+        incidentCells.clear();
+        connectivity.clear();
+        neighbours.clear();
+        cellIds.clear();
+        attributes.clear();
+        isPointsMapped = false;
+        isCellsMapped = false;
+        mapping.reset();
+    }
+
+    void setAttributeStride(int stride) // Sets the number of attributes per cell. Must be done before adding cells.
+    {
+        attributeStride = stride;
+    }
+
+    void resize(int numberOfPoints, int numberOfCells) // Makes room for the given number of points and cells. New entries are zero, without neighbours or incident triangles.
+    {
+        detachPoints();
+        detachCells();
+        x.resize(numberOfPoints);
+        y.resize(numberOfPoints);
+        z.resize(numberOfPoints);
+        pointIds.resize(numberOfPoints);
+        incidentCells.resize(numberOfPoints, -1);
+        connectivity.resize(3 * (std::size_t)numberOfCells);
+        neighbours.resize(3 * (std::size_t)numberOfCells, -1);
+        cellIds.resize(numberOfCells);
+        attributes.resize((std::size_t)attributeStride * numberOfCells);
+    }
+
+    // Makes the arrays a view of blocks inside file, which is kept open as long as the view is used. The ID and
+    // neighbour blocks may be NULL.
+    void view(std::shared_ptr<MappedFile> file, float *px, float *py, float *pz, std::int64_t *pIds, int numberOfPoints, int *cells, int *cellNeighbours, std::int64_t *cIds, float *cellAttributes, int numberOfCells, int stride)
+    {
+        clear();
+        mapping = file;
+        mappedX = px;
+        mappedY = py;
+        mappedZ = pz;
+        mappedPointIds = pIds;
+        mappedPoints = numberOfPoints;
+        mappedConnectivity = cells;
+        mappedNeighbours = cellNeighbours;
+        mappedCellIds = cIds;
+        mappedAttributes = cellAttributes;
+        mappedCells = numberOfCells;
+        attributeStride = stride;
+        isPointsMapped = true;
+        isCellsMapped = true;
+        incidentCells.assign(numberOfPoints, -1);
+        if (cellNeighbours == NULL)
+        {
+            neighbours.assign(3 * (std::size_t)numberOfCells, -1);
+        }
+    }
+
+    bool isMapped() // True if any of the arrays is still a view of a file.
+    {
+        return isPointsMapped || isCellsMapped;
+    }
+
+    int appendPoint(float px, float py, float pz, long long id) // Adds a point without incident triangle at the end and returns its position.
+    {
+        detachPoints();
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+        pointIds.push_back(id);
+        incidentCells.push_back(-1);
+        return x.size() - 1;
+    }
+
+    void setPoint(int slot, float px, float py, float pz) // Overwrites the coordinates of a point.
+    {
+        getX()[slot] = px;
+        getY()[slot] = py;
+        getZ()[slot] = pz;
+    }
+
+    int appendCell(int v0, int v1, int v2, long long id) // Adds a cell without neighbours and with zeroed attributes at the end and returns its position.
+    {
+        detachCells();
+        connectivity.push_back(v0);
+        connectivity.push_back(v1);
+        connectivity.push_back(v2);
+        neighbours.resize(neighbours.size() + 3, -1);
+        cellIds.push_back(id);
+        attributes.resize(attributes.size() + attributeStride, 0.0f);
+        return connectivity.size() / 3 - 1;
+    }
+
+    void setCell(int slot, int v0, int v1, int v2) // Overwrites the vertices of a cell.
+    {
+        int *cell(getCell(slot));
+        cell[0] = v0;
+        cell[1] = v1;
+        cell[2] = v2;
+    }
+
+    void removePoint(int slot) // Moves the last point into this position and drops the last position.
+    {
+        detachPoints();
+        x[slot] = x.back();
+        y[slot] = y.back();
+        z[slot] = z.back();
+        pointIds[slot] = pointIds.back();
+        incidentCells[slot] = incidentCells.back();
+        x.pop_back();
+        y.pop_back();
+        z.pop_back();
+        pointIds.pop_back();
+        incidentCells.pop_back();
+    }
+
+    void removeCell(int slot) // Moves the last cell with its neighbours and attributes into this position and drops the last position.
+    {
+        detachCells();
+        std::size_t last(connectivity.size() / 3 - 1);
+        std::copy(connectivity.begin() + 3 * last, connectivity.end(), connectivity.begin() + 3 * (std::size_t)slot);
+        std::copy(neighbours.begin() + 3 * last, neighbours.end(), neighbours.begin() + 3 * (std::size_t)slot);
+        std::copy(attributes.begin() + attributeStride * last, attributes.end(), attributes.begin() + (std::size_t)attributeStride * slot);
+        cellIds[slot] = cellIds.back();
+        connectivity.resize(3 * last);
+        neighbours.resize(3 * last);
+        cellIds.pop_back();
+        attributes.resize(attributeStride * last);
+    }
+
+    float *getX() // Returns the array of x coordinates.
+    {
+        return isPointsMapped ? mappedX : x.data();
+    }
+
+    float *getY() // Returns the array of y coordinates.
+    {
+        return isPointsMapped ? mappedY : y.data();
+    }
+
+    float *getZ() // Returns the array of z coordinates.
+    {
+        return isPointsMapped ? mappedZ : z.data();
+    }
+
+    long long getPointId(int slot) // ID of a point.
+    {
+        if (isPointsMapped)
+        {
+            return mappedPointIds != NULL ? mappedPointIds[slot] : slot;
+        }
+        return pointIds[slot];
+    }
+
+    void setPointId(int slot, long long id)
+    {
+        if (isPointsMapped && mappedPointIds == NULL) // The IDs are implied by the positions, they need an array now.
+        {
+            detachPoints();
+        }
+        if (isPointsMapped)
+        {
+            mappedPointIds[slot] = id;
+        }
+        else
+        {
+            pointIds[slot] = id;
+        }
+    }
+
+    int getIncidentCell(int slot) // One cell using a point, -1 if none does.
+    {
+        return incidentCells[slot];
+    }
+
+    void setIncidentCell(int slot, int cell)
+    {
+        incidentCells[slot] = cell;
+    }
+
+    int *getConnectivity() // Returns the array holding three vertex positions per cell.
+    {
+        return isCellsMapped ? mappedConnectivity : connectivity.data();
+    }
+
+    int *getCell(int slot) // Returns the three vertex positions of a cell.
+    {
+        return getConnectivity() + 3 * (std::size_t)slot;
+    }
+
+    int *getNeighbours(int slot) // Returns the cells across the three edges of a cell, -1 on the boundary. Neighbour i is across the edge opposite vertex i.
+    {
+        return (isCellsMapped && mappedNeighbours != NULL ? mappedNeighbours : neighbours.data()) + 3 * (std::size_t)slot;
+    }
+
+    long long getCellId(int slot) // ID of a cell.
+    {
+        if (isCellsMapped)
+        {
+            return mappedCellIds != NULL ? mappedCellIds[slot] : slot;
+        }
+        return cellIds[slot];
+    }
+
+    void setCellId(int slot, long long id)
+    {
+        if (isCellsMapped && mappedCellIds == NULL)
+        {
+            detachCells();
+        }
+        if (isCellsMapped)
+        {
+            mappedCellIds[slot] = id;
+        }
+        else
+        {
+            cellIds[slot] = id;
+        }
+    }
+
+    float *getAttributeBuffer() // Returns the start of the attribute buffer.
+    {
+        return isCellsMapped ? mappedAttributes : attributes.data();
+    }
+
+    float *getAttributes(int slot) // Returns the attributes of a cell.
+    {
+        return getAttributeBuffer() + (std::size_t)attributeStride * slot;
+    }
+
+    int getAttributeStride() // Number of attributes per cell.
+    {
+        return attributeStride;
+    }
+
+    int getNumberOfPoints() // Number of points stored.
+    {
+        return isPointsMapped ? mappedPoints : x.size();
+    }
+
+    int getNumberOfCells() // Number of cells stored.
+    {
+        return isCellsMapped ? mappedCells : connectivity.size() / 3;
+    }
+
+private:
+    void detachPoints() // Copies mapped points into the vectors so they can grow.
+    {
+        if (!isPointsMapped)
+        {
+            return;
+        }
+        x.assign(mappedX, mappedX + mappedPoints);
+        y.assign(mappedY, mappedY + mappedPoints);
+        z.assign(mappedZ, mappedZ + mappedPoints);
+        pointIds.resize(mappedPoints);
+        for (int j = 0; j < mappedPoints; ++j)
+        {
+            pointIds[j] = mappedPointIds != NULL ? mappedPointIds[j] : j;
+        }
+        isPointsMapped = false;
+        if (!isCellsMapped)
+        {
+            mapping.reset();
+        }
+    }
+
+    void detachCells() // Copies mapped cells into the vectors so they can grow.
+    {
+        if (!isCellsMapped)
+        {
+            return;
+        }
+        connectivity.assign(mappedConnectivity, mappedConnectivity + 3 * (std::size_t)mappedCells);
+        if (mappedNeighbours != NULL) // Otherwise they are in the vector already.
+        {
+            neighbours.assign(mappedNeighbours, mappedNeighbours + 3 * (std::size_t)mappedCells);
+        }
+        cellIds.resize(mappedCells);
+        for (int j = 0; j < mappedCells; ++j)
+        {
+            cellIds[j] = mappedCellIds != NULL ? mappedCellIds[j] : j;
+        }
+        attributes.assign(mappedAttributes, mappedAttributes + (std::size_t)attributeStride * mappedCells);
+        isCellsMapped = false;
+        if (!isPointsMapped)
+        {
+            mapping.reset();
+        }
+    }
+
+    std::vector<float> x, y, z; // Coordinates of the points.
+    std::vector<long long> pointIds; // IDs of the points.
+    std::vector<int> incidentCells; // One cell using each point, -1 for none. Never mapped.
+    std::vector<int> connectivity; // Vertex positions of the cells, three per cell.
+    std::vector<int> neighbours; // Neighbouring cells, three per cell.
+    std::vector<long long> cellIds; // IDs of the cells.
+    std::vector<float> attributes; // Attributes of the cells, attributeStride per cell.
+    int attributeStride; // Number of attributes per cell.
+
+    // Arrays inside a mapped file, used instead of the vectors above while the corresponding flag is set.
+    std::shared_ptr<MappedFile> mapping;
+    float *mappedX, *mappedY, *mappedZ, *mappedAttributes;
+    int *mappedConnectivity, *mappedNeighbours;
+    std::int64_t *mappedPointIds, *mappedCellIds;
+    int mappedPoints, mappedCells;
+    bool isPointsMapped, isCellsMapped;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "Parallel.h"
+
+static thread_local int currentWorker(-1); // Index of the worker running on this thread, -1 for other threads.
+
+ThreadPool &ThreadPool::getInstance()
+{
+    static ThreadPool *pool(new ThreadPool(getNumberOfThreads(0) - 1)); // Never destroyed: the workers sleep until the program ends.
+    return *pool;
+}
+
+ThreadPool::ThreadPool(int numberOfWorkers) : numberOfQueued(0)
+{
+    for (int w = 0; w < numberOfWorkers; ++w)
+    {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    workers.reserve(numberOfWorkers);
+    for (int w = 0; w < numberOfWorkers; ++w)
+    {
+        workers.push_back(std::thread(&ThreadPool::work, this, w));
+    }
+}
+
+/*
+    The following method queues the tasks [1, numberOfTasks) and runs task 0 on the calling thread. A worker
+    puts the tasks on its own queue, from where idle workers steal them; any other thread deals them out over
+    the queues of the workers. The caller then runs whatever task it can take, its own or any other, and only
+    sleeps once every task of the call is running elsewhere.
+*/
+void ThreadPool::runTasks(void (*function)(void*, int), void *context, int numberOfTasks)
+{
+    int numberOfWorkers(workers.size());
+    if (numberOfWorkers == 0) // A single core: nothing to share the tasks with.
+    {
+        for (int t = 0; t < numberOfTasks; ++t)
+        {
+            function(context, t);
+        }
+        return;
+    }
+
+    std::atomic<int> remaining(numberOfTasks);
+    int self(currentWorker);
+    for (int t = 1; t < numberOfTasks; ++t)
+    {
+        Queue &queue(*queues[self != -1 ? self : (t - 1) % numberOfWorkers]);
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(Task{function, context, t, &remaining});
+    }
+    numberOfQueued.fetch_add(numberOfTasks - 1);
+    {
+        std::lock_guard<std::mutex> guard(lock); // Taken so that a worker about to sleep sees the new tasks.
+    }
+    isWorkQueued.notify_all();
+
+    finish(Task{function, context, 0, &remaining});
+    Task task;
+    while (remaining.load() > 0 && takeTask(self, task))
+    {
+        finish(task);
+    }
+    std::unique_lock<std::mutex> guard(lock);
+    isCallFinished.wait(guard, [&]() { return remaining.load() == 0; });
+}
+
+void ThreadPool::work(int worker)
+{
+    currentWorker = worker;
+    Task task;
+    while (true)
+    {
+        while (takeTask(worker, task))
+        {
+            finish(task);
+        }
+        std::unique_lock<std::mutex> guard(lock);
+        isWorkQueued.wait(guard, [&]() { return numberOfQueued.load() > 0; });
+    }
+}
+
+bool ThreadPool::takeTask(int worker, Task &task)
+{
+    int numberOfWorkers(queues.size());
+    if (worker != -1) // Newest task of the own queue first, its data is the most likely to be in the cache.
+    {
+        Queue &queue(*queues[worker]);
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            numberOfQueued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (int k = 1; k <= numberOfWorkers; ++k) // Then the oldest task of any other queue.
+    {
+        int victim((worker + k + numberOfWorkers) % numberOfWorkers);
+        if (victim == worker)
+        {
+            continue;
+        }
+        Queue &queue(*queues[victim]);
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            numberOfQueued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::finish(const Task &task)
+{
+    task.function(task.context, task.index);
+    if (task.remaining->fetch_sub(1) == 1) // The last task of its call: wake the caller if it sleeps.
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        isCallFinished.notify_all();
+    }
+}
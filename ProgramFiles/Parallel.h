@@ -0,0 +1,161 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread> // Worker threads.
+#include <vector> // Workers and their queues.
+#include <deque> // Tasks waiting in one queue.
+#include <mutex> // Guards the queues.
+#include <condition_variable> // Idle workers and callers waiting for their tasks.
+#include <atomic> // Counters shared between the threads.
+#include <memory> // Owns the queues and the array of block counters.
+#include <algorithm> // std::min.
+
+/*
+    The following ThreadPool class runs the tasks of parallelFor() and parallelForDynamic() on worker threads
+    which are started once, on first use, and then kept for the rest of the program, so a call costs a few queue
+    operations instead of starting and joining threads. Each worker has its own queue: it takes its own tasks
+    from the back and, once the queue is empty, steals from the front of the other queues. The thread which
+    submits the tasks runs the first one itself and then helps with the others until all are done, so a task
+    may submit tasks of its own without blocking a worker. There is one worker less than there are cores, the
+    submitting thread being the last one. Asking for more tasks than that gives more, smaller tasks rather than
+    more threads.
+*/
+class ThreadPool
+{
+public:
+    static ThreadPool &getInstance(); // The pool shared by every loop of the library.
+
+    template<typename F>
+    void run(int numberOfTasks, F &f) // Calls f(task) for every task in [0, numberOfTasks) and returns when they have all finished.
+    {
+        runTasks(&invoke<F>, &f, numberOfTasks);
+    }
+
+    int getNumberOfWorkers() // Threads of the pool, not counting the submitting thread.
+    {
+        return workers.size();
+    }
+
+private:
+    struct Task
+    {
+        void (*function)(void *context, int task); // f of the call, with its type erased.
+        void *context;
+        int index;
+        std::atomic<int> *remaining; // Tasks of the call which have not finished yet.
+    };
+
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    ThreadPool(int numberOfWorkers); // Constructor starts the workers.
+
+    template<typename F>
+    static void invoke(void *context, int task)
+    {
+        (*static_cast<F*>(context))(task);
+    }
+
+    void runTasks(void (*function)(void*, int), void *context, int numberOfTasks);
+    void work(int worker); // Loop of a worker thread.
+    bool takeTask(int worker, Task &task); // Takes a task from the queue of the worker or steals one. worker is -1 for other threads.
+    void finish(const Task &task); // Runs a task and counts it as finished.
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue> > queues; // One per worker.
+    std::atomic<int> numberOfQueued; // Tasks in all queues, so idle workers know when to look again.
+    std::mutex lock; // Guards the sleeping of the workers and the callers.
+    std::condition_variable isWorkQueued; // Wakes the workers.
+    std::condition_variable isCallFinished; // Wakes the callers whose tasks are all running elsewhere.
+};
+
+/*
+    The following helpers split a loop over [begin, end) into one contiguous chunk per thread. The chunks are
+    always the same for a given number of threads, which keeps results that are merged chunk by chunk
+    deterministic. The function f is called as f(chunkBegin, chunkEnd, threadIndex), threadIndex being the
+    number of the chunk. The chunks run on the ThreadPool, the calling thread taking the first one.
+*/
+inline int getNumberOfThreads(int requested) // Resolves a requested thread count, 0 meaning one per core.
+{
+    if (requested > 0)
+    {
+        return requested;
+    }
+    int cores(std::thread::hardware_concurrency());
+    return cores > 0 ? cores : 1; // hardware_concurrency() may return 0 if it cannot tell.
+}
+
+template<typename F>
+void parallelFor(int begin, int end, int numberOfThreads, F f)
+{
+    int count(end - begin);
+    if (count <= 0)
+    {
+        return;
+    }
+    numberOfThreads = std::min(getNumberOfThreads(numberOfThreads), count); // No point in threads without work.
+    if (numberOfThreads == 1)
+    {
+        f(begin, end, 0);
+        return;
+    }
+
+    auto chunk = [&](int t) // Chunk t covers [begin + count * t / n, begin + count * (t + 1) / n).
+    {
+        f(begin + (int)((long long)count * t / numberOfThreads), begin + (int)((long long)count * (t + 1) / numberOfThreads), t);
+    };
+    ThreadPool::getInstance().run(numberOfThreads, chunk);
+}
+
+/*
+    The following helper is for loops whose iterations take different amounts of time. The range is cut into
+    blocks of grainSize iterations and every thread starts on its own contiguous share of the blocks, so it
+    works on neighbouring data. A thread which runs out of blocks steals the remaining blocks of the other
+    threads one at a time, so no thread sits idle while work is left. f is called as
+    f(blockBegin, blockEnd, threadIndex) once per block.
+*/
+template<typename F>
+void parallelForDynamic(int begin, int end, int numberOfThreads, int grainSize, F f)
+{
+    int count(end - begin);
+    if (count <= 0)
+    {
+        return;
+    }
+    grainSize = std::max(grainSize, 1);
+    int numberOfBlocks((int)(((long long)count + grainSize - 1) / grainSize));
+    numberOfThreads = std::min(getNumberOfThreads(numberOfThreads), numberOfBlocks);
+
+    // Thread t owns blocks [next[t], last[t]). Both the owner and thieves take blocks from the front.
+    std::unique_ptr<std::atomic<int>[]> next(new std::atomic<int>[numberOfThreads]);
+    std::vector<int> last(numberOfThreads);
+    for (int t = 0; t < numberOfThreads; ++t)
+    {
+        next[t] = (int)((long long)numberOfBlocks * t / numberOfThreads);
+        last[t] = (int)((long long)numberOfBlocks * (t + 1) / numberOfThreads);
+    }
+
+    auto worker = [&](int thread)
+    {
+        for (int k = 0; k < numberOfThreads; ++k) // Own blocks first, then those of the following threads.
+        {
+            int victim((thread + k) % numberOfThreads);
+            for (int block = next[victim].fetch_add(1); block < last[victim]; block = next[victim].fetch_add(1))
+            {
+                int blockBegin(begin + (int)((long long)block * grainSize));
+                f(blockBegin, std::min(blockBegin + grainSize, end), thread);
+            }
+        }
+    };
+    if (numberOfThreads == 1)
+    {
+        worker(0);
+        return;
+    }
+    ThreadPool::getInstance().run(numberOfThreads, worker);
+}
+
+#endif
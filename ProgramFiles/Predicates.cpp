@@ -0,0 +1,259 @@
+#include "Predicates.h"
+#include "Metrics.h" // Counts of the evaluations.
+#include <vector> // Components of the expansions.
+#include <cmath> // std::fabs.
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off") // A fused multiply-add would invalidate both the error bounds and the exact sums below.
+#endif
+
+static const double EPSILON(1.1102230246251565e-16); // Half the distance from 1 to the next double, 2^-53.
+static const double SPLITTER(134217729.0); // 2^27 + 1, splits a double into two halves of 26 bits.
+
+const double Predicates::ORIENTATION_BOUND((3.0 + 16.0 * EPSILON) * EPSILON);
+const double Predicates::IN_CIRCLE_BOUND((10.0 + 96.0 * EPSILON) * EPSILON);
+
+/*
+    Error-free transformations: the result of the floating point operation in x and its rounding error in y, so
+    that x + y is exactly the true result.
+*/
+static inline void twoSum(double a, double b, double &x, double &y)
+{
+    x = a + b;
+    double bVirtual(x - a), aVirtual(x - bVirtual);
+    y = (a - aVirtual) + (b - bVirtual);
+}
+
+static inline void twoDifference(double a, double b, double &x, double &y)
+{
+    x = a - b;
+    double bVirtual(a - x), aVirtual(x + bVirtual);
+    y = (a - aVirtual) + (bVirtual - b);
+}
+
+static inline void split(double a, double &high, double &low)
+{
+    double c(SPLITTER * a), big(c - a);
+    high = c - big;
+    low = a - high;
+}
+
+static inline void twoProduct(double a, double b, double &x, double &y)
+{
+    x = a * b;
+    double aHigh, aLow, bHigh, bLow;
+    split(a, aHigh, aLow);
+    split(b, bHigh, bLow);
+    double error1(x - (aHigh * bHigh)), error2(error1 - (aLow * bHigh)), error3(error2 - (aHigh * bLow));
+    y = (aLow * bLow) - error3;
+}
+
+/*
+    The following Expansion class represents a number exactly as a sum of doubles which do not overlap, ordered by
+    increasing magnitude. Its sign is the sign of the last (largest) component. Only the operations needed by the
+    determinants are provided. It is only used on the rare exact path, so it favours simplicity over speed.
+*/
+class Expansion
+{
+public:
+    static Expansion difference(double a, double b) // a - b.
+    {
+        double x, y;
+        twoDifference(a, b, x, y);
+        return Expansion(y, x);
+    }
+
+    Expansion operator+(const Expansion &other) const // Merges the components by magnitude and sums them up with twoSum.
+    {
+        const std::vector<double> &e(components), &f(other.components);
+        std::vector<double> merged;
+        merged.reserve(e.size() + f.size());
+        std::size_t i(0), j(0);
+        while (i < e.size() || j < f.size())
+        {
+            if (j == f.size() || (i < e.size() && std::fabs(e[i]) <= std::fabs(f[j])))
+            {
+                merged.push_back(e[i++]);
+            }
+            else
+            {
+                merged.push_back(f[j++]);
+            }
+        }
+
+        Expansion sum;
+        double q(merged[0]);
+        for (std::size_t k = 1; k < merged.size(); ++k)
+        {
+            double error;
+            twoSum(q, merged[k], q, error);
+            if (error != 0.0) // Zero components are dropped.
+            {
+                sum.components.push_back(error);
+            }
+        }
+        if (q != 0.0 || sum.components.empty())
+        {
+            sum.components.push_back(q);
+        }
+        return sum;
+    }
+
+    Expansion operator-(const Expansion &other) const
+    {
+        Expansion negated(other);
+        for (std::size_t k = 0; k < negated.components.size(); ++k)
+        {
+            negated.components[k] = -negated.components[k];
+        }
+        return *this + negated;
+    }
+
+    Expansion operator*(const Expansion &other) const // Sum of this expansion scaled by every component of other.
+    {
+        Expansion product(scale(other.components[0]));
+        for (std::size_t k = 1; k < other.components.size(); ++k)
+        {
+            product = product + scale(other.components[k]);
+        }
+        return product;
+    }
+
+    double getEstimate() const // The largest component, which has the sign of the whole sum.
+    {
+        return components.back();
+    }
+
+private:
+    Expansion() {;}
+
+    Expansion(double low, double high) : components(1, low)
+    {
+        components.push_back(high);
+    }
+
+    Expansion scale(double b) const // This expansion times b.
+    {
+        Expansion product;
+        double q, error;
+        twoProduct(components[0], b, q, error);
+        if (error != 0.0)
+        {
+            product.components.push_back(error);
+        }
+        for (std::size_t k = 1; k < components.size(); ++k)
+        {
+            double high, low, sum;
+            twoProduct(components[k], b, high, low);
+            twoSum(q, low, sum, error);
+            if (error != 0.0)
+            {
+                product.components.push_back(error);
+            }
+            twoSum(high, sum, q, error);
+            if (error != 0.0)
+            {
+                product.components.push_back(error);
+            }
+        }
+        if (q != 0.0 || product.components.empty())
+        {
+            product.components.push_back(q);
+        }
+        return product;
+    }
+
+    std::vector<double> components;
+};
+
+/*
+    The following method evaluates the orientation determinant (ax - cx)(by - cy) - (ay - cy)(bx - cx). The rounding
+    error of the double precision value is at most ORIENTATION_BOUND times the sum of the magnitudes of the two
+    products, so the sign can only be wrong when the value is smaller than that.
+*/
+double Predicates::orientation(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    Metrics::add(Metrics::ORIENTATION_TESTS);
+    double left((ax - cx) * (by - cy)), right((ay - cy) * (bx - cx)), determinant(left - right);
+    double bound(ORIENTATION_BOUND * (std::fabs(left) + std::fabs(right)));
+    if (determinant >= bound || -determinant >= bound)
+    {
+        return determinant;
+    }
+    Metrics::add(Metrics::ORIENTATION_EXACT);
+    return orientationExact(ax, ay, bx, by, cx, cy);
+}
+
+/*
+    The following method evaluates the in-circle determinant with d moved to the origin, expanded along the lifted
+    column. The filter works as for orientation() with the sum of the magnitudes of all the terms.
+*/
+double Predicates::inCircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+    Metrics::add(Metrics::IN_CIRCLE_TESTS);
+    double adx(ax - dx), ady(ay - dy), bdx(bx - dx), bdy(by - dy), cdx(cx - dx), cdy(cy - dy);
+    double bdxcdy(bdx * cdy), cdxbdy(cdx * bdy), aLift((adx * adx) + (ady * ady));
+    double cdxady(cdx * ady), adxcdy(adx * cdy), bLift((bdx * bdx) + (bdy * bdy));
+    double adxbdy(adx * bdy), bdxady(bdx * ady), cLift((cdx * cdx) + (cdy * cdy));
+    double determinant((aLift * (bdxcdy - cdxbdy)) + (bLift * (cdxady - adxcdy)) + (cLift * (adxbdy - bdxady)));
+    double permanent(((std::fabs(bdxcdy) + std::fabs(cdxbdy)) * aLift) + ((std::fabs(cdxady) + std::fabs(adxcdy)) * bLift) + ((std::fabs(adxbdy) + std::fabs(bdxady)) * cLift));
+    double bound(IN_CIRCLE_BOUND * permanent);
+    if (determinant > bound || -determinant > bound)
+    {
+        return determinant;
+    }
+    Metrics::add(Metrics::IN_CIRCLE_EXACT);
+    return inCircleExact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+/*
+    Exact versions of the two determinants. The differences of the coordinates are kept as two-component expansions
+    so that nothing is rounded.
+*/
+double Predicates::orientationExact(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    Expansion acx(Expansion::difference(ax, cx)), acy(Expansion::difference(ay, cy));
+    Expansion bcx(Expansion::difference(bx, cx)), bcy(Expansion::difference(by, cy));
+    return ((acx * bcy) - (acy * bcx)).getEstimate();
+}
+
+double Predicates::inCircleExact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+    Expansion adx(Expansion::difference(ax, dx)), ady(Expansion::difference(ay, dy));
+    Expansion bdx(Expansion::difference(bx, dx)), bdy(Expansion::difference(by, dy));
+    Expansion cdx(Expansion::difference(cx, dx)), cdy(Expansion::difference(cy, dy));
+    Expansion aLift((adx * adx) + (ady * ady)), bLift((bdx * bdx) + (bdy * bdy)), cLift((cdx * cdx) + (cdy * cdy));
+    Expansion determinant((aLift * ((bdx * cdy) - (cdx * bdy))) + (bLift * ((cdx * ady) - (adx * cdy))) + (cLift * ((adx * bdy) - (bdx * ady))));
+    return determinant.getEstimate();
+}
+
+void Predicates::countFilteredTests(unsigned long long orientations, unsigned long long inCircles)
+{
+    Metrics::add(Metrics::ORIENTATION_TESTS, orientations);
+    Metrics::add(Metrics::IN_CIRCLE_TESTS, inCircles);
+}
+
+/*
+    The counts are kept by Metrics, so they include every thread and are zero if the instrumentation is compiled
+    out.
+*/
+PredicateStatistics Predicates::getStatistics()
+{
+    MetricsSnapshot snapshot(Metrics::getSnapshot());
+    PredicateStatistics statistics;
+    statistics.orientationTests = snapshot.counters[Metrics::ORIENTATION_TESTS];
+    statistics.orientationExact = snapshot.counters[Metrics::ORIENTATION_EXACT];
+    statistics.inCircleTests = snapshot.counters[Metrics::IN_CIRCLE_TESTS];
+    statistics.inCircleExact = snapshot.counters[Metrics::IN_CIRCLE_EXACT];
+    return statistics;
+}
+
+void Predicates::resetStatistics()
+{
+    Metrics::reset(Metrics::ORIENTATION_TESTS);
+    Metrics::reset(Metrics::ORIENTATION_EXACT);
+    Metrics::reset(Metrics::IN_CIRCLE_TESTS);
+    Metrics::reset(Metrics::IN_CIRCLE_EXACT);
+}
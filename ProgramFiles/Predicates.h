@@ -0,0 +1,56 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+/*
+    The following PredicateStatistics struct counts the predicate evaluations and how many of them could not be
+    decided by the floating point filter and needed the exact calculation.
+*/
+struct PredicateStatistics
+{
+    PredicateStatistics() : orientationTests(0), orientationExact(0), inCircleTests(0), inCircleExact(0) {;}
+
+    double getExactFraction() const // Share of all evaluations which needed the exact calculation.
+    {
+        unsigned long long tests(orientationTests + inCircleTests);
+        return tests > 0 ? (double)(orientationExact + inCircleExact) / tests : 0.0;
+    }
+
+    unsigned long long orientationTests, orientationExact;
+    unsigned long long inCircleTests, inCircleExact;
+};
+
+/*
+    The following Predicates class provides the orientation and in-circle tests in the adaptive style of Shewchuk
+    ("Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates", 1997). The determinant is
+    first evaluated in double precision together with a bound on its rounding error. If the bound shows the sign
+    is right, which is almost always the case, that value is returned. Otherwise the determinant is recalculated
+    exactly with floating point expansions. The sign of the result is therefore always correct, which is what
+    point location, insertion and edge flips need to be consistent with each other.
+    The result is exact for any double inputs whose products do not overflow or underflow, which always holds for
+    coordinates stored as floats.
+*/
+class Predicates
+{
+public:
+    // Positive if a, b and c are in counter-clockwise order, negative if clockwise and zero if they are on a line.
+    // The magnitude is close to twice the area of the triangle.
+    static double orientation(double ax, double ay, double bx, double by, double cx, double cy);
+
+    // Positive if d is inside the circumcircle of a, b and c when they are counter-clockwise (the sign flips when
+    // they are clockwise) and zero if the four points are on one circle.
+    static double inCircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy);
+
+    // Relative error bounds of the two filters (Shewchuk's ccwerrboundA and iccerrboundA). Vectorised code which
+    // evaluates the filters itself uses them to find the elements which need the exact calculation.
+    static const double ORIENTATION_BOUND, IN_CIRCLE_BOUND;
+
+    static void countFilteredTests(unsigned long long orientations, unsigned long long inCircles); // Adds evaluations done by vectorised filters.
+    static PredicateStatistics getStatistics(); // Counts of all threads, kept by Metrics (zero if it is compiled out).
+    static void resetStatistics(); // Sets the counts to zero.
+
+private:
+    static double orientationExact(double ax, double ay, double bx, double by, double cx, double cy);
+    static double inCircleExact(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy);
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "Quadrature.h"
+
+/*
+    Tables of the rules. The coordinates and weights of Dunavant's rules are those of his paper, given to 15
+    decimal places, which integrates the monomials up to the degree of each rule to within 1e-15.
+*/
+static const QuadraturePoint CENTROID_POINTS[] =
+{
+    {1.0 / 3, 1.0 / 3, 1.0 / 3, 1.0}
+};
+
+static const QuadraturePoint VERTICES_POINTS[] =
+{
+    {1.0, 0.0, 0.0, 1.0 / 3},
+    {0.0, 1.0, 0.0, 1.0 / 3},
+    {0.0, 0.0, 1.0, 1.0 / 3}
+};
+
+static const QuadraturePoint DUNAVANT_2_POINTS[] =
+{
+    {2.0 / 3, 1.0 / 6, 1.0 / 6, 1.0 / 3},
+    {1.0 / 6, 2.0 / 3, 1.0 / 6, 1.0 / 3},
+    {1.0 / 6, 1.0 / 6, 2.0 / 3, 1.0 / 3}
+};
+
+static const QuadraturePoint DUNAVANT_3_POINTS[] =
+{
+    {1.0 / 3, 1.0 / 3, 1.0 / 3, -27.0 / 48},
+    {0.6, 0.2, 0.2, 25.0 / 48},
+    {0.2, 0.6, 0.2, 25.0 / 48},
+    {0.2, 0.2, 0.6, 25.0 / 48}
+};
+
+static const QuadraturePoint DUNAVANT_4_POINTS[] =
+{
+    {0.108103018168070, 0.445948490915965, 0.445948490915965, 0.223381589678011},
+    {0.445948490915965, 0.108103018168070, 0.445948490915965, 0.223381589678011},
+    {0.445948490915965, 0.445948490915965, 0.108103018168070, 0.223381589678011},
+    {0.816847572980459, 0.091576213509771, 0.091576213509771, 0.109951743655322},
+    {0.091576213509771, 0.816847572980459, 0.091576213509771, 0.109951743655322},
+    {0.091576213509771, 0.091576213509771, 0.816847572980459, 0.109951743655322}
+};
+
+static const QuadraturePoint DUNAVANT_5_POINTS[] =
+{
+    {1.0 / 3, 1.0 / 3, 1.0 / 3, 0.225},
+    {0.059715871789770, 0.470142064105115, 0.470142064105115, 0.132394152788506},
+    {0.470142064105115, 0.059715871789770, 0.470142064105115, 0.132394152788506},
+    {0.470142064105115, 0.470142064105115, 0.059715871789770, 0.132394152788506},
+    {0.797426985353087, 0.101286507323456, 0.101286507323456, 0.125939180544827},
+    {0.101286507323456, 0.797426985353087, 0.101286507323456, 0.125939180544827},
+    {0.101286507323456, 0.101286507323456, 0.797426985353087, 0.125939180544827}
+};
+
+static const QuadraturePoint DUNAVANT_6_POINTS[] =
+{
+    {0.501426509658179, 0.249286745170910, 0.249286745170910, 0.116786275726379},
+    {0.249286745170910, 0.501426509658179, 0.249286745170910, 0.116786275726379},
+    {0.249286745170910, 0.249286745170910, 0.501426509658179, 0.116786275726379},
+    {0.873821971016996, 0.063089014491502, 0.063089014491502, 0.050844906370207},
+    {0.063089014491502, 0.873821971016996, 0.063089014491502, 0.050844906370207},
+    {0.063089014491502, 0.063089014491502, 0.873821971016996, 0.050844906370207},
+    {0.053145049844817, 0.310352451033784, 0.636502499121399, 0.082851075618374},
+    {0.053145049844817, 0.636502499121399, 0.310352451033784, 0.082851075618374},
+    {0.310352451033784, 0.053145049844817, 0.636502499121399, 0.082851075618374},
+    {0.310352451033784, 0.636502499121399, 0.053145049844817, 0.082851075618374},
+    {0.636502499121399, 0.053145049844817, 0.310352451033784, 0.082851075618374},
+    {0.636502499121399, 0.310352451033784, 0.053145049844817, 0.082851075618374}
+};
+
+static const QuadraturePoint DUNAVANT_7_POINTS[] =
+{
+    {1.0 / 3, 1.0 / 3, 1.0 / 3, -0.149570044467682},
+    {0.479308067841920, 0.260345966079040, 0.260345966079040, 0.175615257433208},
+    {0.260345966079040, 0.479308067841920, 0.260345966079040, 0.175615257433208},
+    {0.260345966079040, 0.260345966079040, 0.479308067841920, 0.175615257433208},
+    {0.869739794195568, 0.065130102902216, 0.065130102902216, 0.053347235608838},
+    {0.065130102902216, 0.869739794195568, 0.065130102902216, 0.053347235608838},
+    {0.065130102902216, 0.065130102902216, 0.869739794195568, 0.053347235608838},
+    {0.048690315425316, 0.312865496004874, 0.638444188569810, 0.077113760890257},
+    {0.048690315425316, 0.638444188569810, 0.312865496004874, 0.077113760890257},
+    {0.312865496004874, 0.048690315425316, 0.638444188569810, 0.077113760890257},
+    {0.312865496004874, 0.638444188569810, 0.048690315425316, 0.077113760890257},
+    {0.638444188569810, 0.048690315425316, 0.312865496004874, 0.077113760890257},
+    {0.638444188569810, 0.312865496004874, 0.048690315425316, 0.077113760890257}
+};
+
+/*
+    The following method returns the number of points of a rule.
+*/
+int Quadrature::getNumberOfPoints(Rule rule)
+{
+    switch (rule)
+    {
+        case CENTROID: return 1;
+        case VERTICES: return 3;
+        case DUNAVANT_2: return 3;
+        case DUNAVANT_3: return 4;
+        case DUNAVANT_4: return 6;
+        case DUNAVANT_5: return 7;
+        case DUNAVANT_6: return 12;
+        case DUNAVANT_7: return 13;
+    }
+    return 0;
+}
+
+/*
+    The following method returns the points of a rule, getNumberOfPoints(rule) of them.
+*/
+const QuadraturePoint *Quadrature::getPoints(Rule rule)
+{
+    switch (rule)
+    {
+        case CENTROID: return CENTROID_POINTS;
+        case VERTICES: return VERTICES_POINTS;
+        case DUNAVANT_2: return DUNAVANT_2_POINTS;
+        case DUNAVANT_3: return DUNAVANT_3_POINTS;
+        case DUNAVANT_4: return DUNAVANT_4_POINTS;
+        case DUNAVANT_5: return DUNAVANT_5_POINTS;
+        case DUNAVANT_6: return DUNAVANT_6_POINTS;
+        case DUNAVANT_7: return DUNAVANT_7_POINTS;
+    }
+    return CENTROID_POINTS;
+}
+
+/*
+    The following method returns the highest degree of polynomial a rule integrates exactly.
+*/
+int Quadrature::getDegree(Rule rule)
+{
+    switch (rule)
+    {
+        case CENTROID: return 1;
+        case VERTICES: return 1;
+        case DUNAVANT_2: return 2;
+        case DUNAVANT_3: return 3;
+        case DUNAVANT_4: return 4;
+        case DUNAVANT_5: return 5;
+        case DUNAVANT_6: return 6;
+        case DUNAVANT_7: return 7;
+    }
+    return 0;
+}
+
+const char *Quadrature::getName(Rule rule)
+{
+    switch (rule)
+    {
+        case CENTROID: return "centroid";
+        case VERTICES: return "vertices";
+        case DUNAVANT_2: return "Dunavant 2";
+        case DUNAVANT_3: return "Dunavant 3";
+        case DUNAVANT_4: return "Dunavant 4";
+        case DUNAVANT_5: return "Dunavant 5";
+        case DUNAVANT_6: return "Dunavant 6";
+        case DUNAVANT_7: return "Dunavant 7";
+    }
+    return "unknown";
+}
@@ -0,0 +1,98 @@
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <type_traits> // Detection of functions which evaluate whole batches.
+#include <utility> // std::declval.
+
+/*
+    The following QuadraturePoint struct is one point of a quadrature rule on a triangle: its barycentric
+    coordinates with respect to the three vertices and its weight. The weights of a rule add up to 1, so the
+    integral over a triangle is its area times the weighted sum of the function values.
+*/
+struct QuadraturePoint
+{
+    double a, b, c; // Barycentric coordinates, the point is a * V0 + b * V1 + c * V2.
+    double weight;
+};
+
+/*
+    The following Quadrature class provides the symmetric quadrature rules of Dunavant (1985) for triangles. A
+    rule of degree d integrates every polynomial of degree d or less exactly. The tables are stored with every
+    permutation of the barycentric coordinates written out, so a rule is a plain list of points.
+*/
+class Quadrature
+{
+public:
+    enum Rule
+    {
+        CENTROID, // Degree 1, the value at the centroid (1 point).
+        VERTICES, // Degree 1, the mean of the values at the vertices (3 points), as Linear Interpolation Approximation.
+        DUNAVANT_2, // Degree 2, 3 points.
+        DUNAVANT_3, // Degree 3, 4 points, one with a negative weight.
+        DUNAVANT_4, // Degree 4, 6 points.
+        DUNAVANT_5, // Degree 5, 7 points.
+        DUNAVANT_6, // Degree 6, 12 points.
+        DUNAVANT_7 // Degree 7, 13 points, one with a negative weight.
+    };
+
+    static const int MAXIMUM_POINTS = 13; // Largest number of points of any rule.
+
+    static int getNumberOfPoints(Rule rule);
+    static const QuadraturePoint *getPoints(Rule rule);
+    static int getDegree(Rule rule); // Highest degree of polynomial integrated exactly.
+    static const char *getName(Rule rule); // Name of the rule, for reports.
+};
+
+/*
+    The following CompensatedSum class adds up doubles with the compensated summation of Kahan and Babuska
+    (Neumaier's variant): the rounding error of every addition is collected separately and added back at the end,
+    so the result does not drift with the number of terms or their order of magnitude. It must not be compiled with
+    -ffast-math, which would remove the compensation.
+*/
+class CompensatedSum
+{
+public:
+    CompensatedSum() : sum(0.0), compensation(0.0) {;}
+
+    void add(double value)
+    {
+        double total(sum + value);
+        if ((sum >= 0 ? sum : -sum) >= (value >= 0 ? value : -value)) // Low order digits of value were lost.
+        {
+            compensation += (sum - total) + value;
+        }
+        else // Low order digits of sum were lost.
+        {
+            compensation += (value - total) + sum;
+        }
+        sum = total;
+    }
+
+    double getSum() const
+    {
+        return sum + compensation;
+    }
+
+private:
+    double sum, compensation;
+};
+
+/*
+    The following trait tells whether a function object can evaluate a whole batch of points in one call, as
+    t(const double *x, const double *y, int count, double *values). Integration hands such functions all the
+    quadrature points of a block of triangles at once instead of calling t(x, y) for each point.
+*/
+template<typename T>
+class IsBatchFunction
+{
+    template<typename U>
+    static auto test(int) -> decltype(std::declval<U &>()((const double *)0, (const double *)0, 0, (double *)0), std::true_type());
+
+    template<typename U>
+    static std::false_type test(...);
+
+public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
+#endif
@@ -0,0 +1,420 @@
+#ifndef STATICMESH_H
+#define STATICMESH_H
+
+#include <vector> // Containers of the points and cells.
+#include <array> // Attributes stored inside the points and cells.
+#include <string> // Error messages.
+#include <type_traits> // Checks of the template parameters.
+#include <cmath> // Absolute value of the areas.
+#include <chrono> // Timing the loader.
+#include "Triangulation.h" // The mesh with the layout chosen at run time, which can be copied into this one.
+#include "MeshAlgorithms.h" // Adjacency, Delaunay check and integration shared with Triangulation.
+
+/*
+    The following StaticMesh class template is a triangle mesh whose layout is fixed at compile time: the type of
+    the coordinates and attributes (float or double), the number of dimensions of the points and the number of
+    attributes of each cell and each point. Cells always have three vertices. The attributes are stored inside
+    the Point and Cell structs instead of behind a pointer, every loop over the dimensions, vertices or attributes
+    has a constant trip count the compiler can unroll, and nothing is virtual.
+    Triangulation stays the mesh for files whose layout is only known when they are read; this one is for code
+    which knows it. With double it also keeps the full precision of the coordinates in the file, for data such as
+    surveys with large coordinates where float loses the differences the predicates depend on.
+    The points and cells are kept in file order and found by ID through IdIndex like in Triangulation. The
+    parsing of the lines, the adjacency, the Delaunay check and the integration are the code of Triangulation,
+    shared through TriFormat and MeshAlgorithms.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes = 0>
+class StaticMesh
+{
+public:
+    static_assert(std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value, "the coordinates must be float or double");
+    static_assert(Dimensions >= 2 && Dimensions <= 3, "the points must have 2 or 3 dimensions");
+    static_assert(CellAttributes >= 0 && PointAttributes >= 0, "the number of attributes cannot be negative");
+
+    static const int NUMBER_OF_VERTICES_PER_CELL = 3;
+
+    struct Point
+    {
+        Scalar coordinate[Dimensions];
+        std::array<Scalar, PointAttributes> attributes;
+    };
+
+    struct Cell
+    {
+        int vertices[3]; // Positions of the points.
+        int neighbours[3]; // Position of the cell across the edge opposite each vertex, -1 on the boundary.
+        std::array<Scalar, CellAttributes> attributes;
+    };
+
+    bool load(const char *fileName, LoadStatistics *statistics = NULL); // Reads a .tri file whose layout matches the template parameters. Returns false on a malformed or different file.
+    bool assign(Triangulation &mesh); // Copies a loaded Triangulation with CellAttributes attributes per triangle. Returns false if it has another number.
+    void clear(); // Removes all points and cells.
+    void buildAdjacency(); // Finds the neighbours of every cell.
+
+    int findPoint(long long id) // Position of the point with the given ID, or -1 if there is none.
+    {
+        return myPointIndex.find(id);
+    }
+
+    int findCell(long long id) // Position of the cell with the given ID, or -1 if there is none.
+    {
+        return myCellIndex.find(id);
+    }
+
+    long long getPointId(int slot) // ID of the point at the given position.
+    {
+        return myPointIds[slot];
+    }
+
+    long long getCellId(int slot) // ID of the cell at the given position.
+    {
+        return myCellIds[slot];
+    }
+
+    Point &getPoint(int slot) // The point at the given position.
+    {
+        return myPoints[slot];
+    }
+
+    Cell &getCell(int slot) // The cell at the given position.
+    {
+        return myCells[slot];
+    }
+
+    int getNumberOfPoints()
+    {
+        return myPoints.size();
+    }
+
+    int getNumberOfCells()
+    {
+        return myCells.size();
+    }
+
+    Scalar calculateArea(int slot); // Area of a cell.
+    void calculateCircumcentre(int slot, Scalar &x, Scalar &y, Scalar &radiusSquared); // Circumcentre of a cell and the square of its radius.
+    bool isDelaunay(int numberOfThreads = 0); // Checks the empty circumcircle condition on every edge with the exact predicates.
+
+    // Integrates t over the mesh like Triangulation::integration() with a quadrature rule, with the corners in Scalar.
+    template<typename T>
+    double integration(T t, Quadrature::Rule rule, int numberOfThreads = 0);
+
+private:
+    struct View // View of the cells and points for MeshAlgorithms.
+    {
+        StaticMesh *mesh;
+
+        int getVertex(int cell, int i)
+        {
+            return mesh->myCells[cell].vertices[i];
+        }
+
+        int getNeighbour(int cell, int i)
+        {
+            return mesh->myCells[cell].neighbours[i];
+        }
+
+        void setNeighbour(int cell, int i, int neighbour)
+        {
+            mesh->myCells[cell].neighbours[i] = neighbour;
+        }
+
+        double getX(int point)
+        {
+            return mesh->myPoints[point].coordinate[0];
+        }
+
+        double getY(int point)
+        {
+            return mesh->myPoints[point].coordinate[1];
+        }
+    };
+
+    View getView()
+    {
+        View view = {this};
+        return view;
+    }
+
+    bool parse(const char *&position, const char *end, std::string &error); // Parses both sections.
+    bool checkHeader(TriHeader &header, bool isPoints, std::string &error); // Compares the header of the points or the cells with the layout.
+
+    std::vector<Point> myPoints;
+    std::vector<Cell> myCells;
+    std::vector<long long> myPointIds, myCellIds; // IDs from the file, by position.
+    IdIndex myPointIndex, myCellIndex;
+};
+
+/*
+    The following method reads a .tri file like Triangulation::load() does with one thread. The headers must
+    match the template parameters: at most Dimensions coordinates per point (missing ones are zero), exactly
+    PointAttributes and CellAttributes attributes and 3 vertices per cell. The object must be empty; on failure
+    it is left empty and statistics, if not NULL, receives the reason.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+bool StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::load(const char *fileName, LoadStatistics *statistics)
+{
+    std::chrono::steady_clock::time_point startTime(std::chrono::steady_clock::now());
+    LoadStatistics local;
+    LoadStatistics &report(statistics != NULL ? *statistics : local);
+    report = LoadStatistics();
+
+    if (!myPoints.empty() || !myCells.empty())
+    {
+        report.error = "the mesh already holds points or cells";
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(fileName))
+    {
+        report.error = std::string("unable to open ") + fileName;
+        return false;
+    }
+    report.bytes = file.getSize();
+
+    const char *begin(file.getData()), *position(begin), *end(begin + file.getSize());
+    std::string error;
+    if (!parse(position, end, error))
+    {
+        report.error = "line " + std::to_string(TriFormat::lineNumber(begin, position)) + ": " + error;
+        clear();
+        return false;
+    }
+    long long conflict(0);
+    if (!myCellIndex.build(myCells.size(), [this](int t) { return myCellIds[t]; }, &conflict))
+    {
+        report.error = "cell ID " + std::to_string(conflict) + (conflict < 0 ? " is negative" : " is repeated");
+        clear();
+        return false;
+    }
+    buildAdjacency();
+
+    report.numberOfPoints = myPoints.size();
+    report.numberOfCells = myCells.size();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+/*
+    The following method parses the points, indexes them by ID and parses the cells, turning the IDs of their
+    vertices into positions. position is left where an error was found.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+bool StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::parse(const char *&position, const char *end, std::string &error)
+{
+    TriHeader header;
+    if (!TriFormat::parseHeader(position, end, header) || header.count < 0)
+    {
+        error = "malformed points header";
+        return false;
+    }
+    if (!checkHeader(header, true, error))
+    {
+        return false;
+    }
+    int dimensions(header.valuesPerEntry);
+    myPoints.resize(header.count);
+    myPointIds.resize(header.count);
+    for (int j = 0; j < header.count; ++j)
+    {
+        TriFormat::skipWhitespace(position, end);
+        if (position == end)
+        {
+            error = "expected " + std::to_string(header.count) + " points, found " + std::to_string(j);
+            return false;
+        }
+        Point &point = myPoints[j];
+        for (int i = dimensions; i < Dimensions; ++i)
+        {
+            point.coordinate[i] = 0;
+        }
+        if (!TriFormat::parsePointRecord(position, end, myPointIds[j], point.coordinate, dimensions, point.attributes.data(), PointAttributes, error))
+        {
+            return false;
+        }
+    }
+    long long conflict(0);
+    if (!myPointIndex.build(myPoints.size(), [this](int p) { return myPointIds[p]; }, &conflict))
+    {
+        error = "point ID " + std::to_string(conflict) + (conflict < 0 ? " is negative" : " is repeated");
+        return false;
+    }
+
+    if (!TriFormat::parseHeader(position, end, header) || header.count < 0)
+    {
+        error = "malformed cells header";
+        return false;
+    }
+    if (!checkHeader(header, false, error))
+    {
+        return false;
+    }
+    myCells.resize(header.count);
+    myCellIds.resize(header.count);
+    for (int j = 0; j < header.count; ++j)
+    {
+        TriFormat::skipWhitespace(position, end);
+        if (position == end)
+        {
+            error = "expected " + std::to_string(header.count) + " cells, found " + std::to_string(j);
+            return false;
+        }
+        if (!TriFormat::parseCellRecord(position, end, myCellIds[j], [this](long long id) { return myPointIndex.find(id); }, myCells[j].vertices, myCells[j].attributes.data(), CellAttributes, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    The following method checks that a section of the file has the layout of this mesh type. Points may have
+    fewer coordinates than Dimensions, all other counts must be equal.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+bool StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::checkHeader(TriHeader &header, bool isPoints, std::string &error)
+{
+    std::string section(isPoints ? "the points" : "the cells");
+    int attributes(isPoints ? PointAttributes : CellAttributes);
+    if (isPoints && (header.valuesPerEntry < 1 || header.valuesPerEntry > Dimensions))
+    {
+        error = section + " have " + std::to_string(header.valuesPerEntry) + " coordinates, but this mesh type takes between 1 and " + std::to_string(Dimensions);
+        return false;
+    }
+    if (!isPoints && header.valuesPerEntry != NUMBER_OF_VERTICES_PER_CELL)
+    {
+        error = section + " have " + std::to_string(header.valuesPerEntry) + " vertices, but this mesh type takes triangles only";
+        return false;
+    }
+    if (header.attributesPerEntry != attributes)
+    {
+        error = section + " have " + std::to_string(header.attributesPerEntry) + " attributes, but this mesh type takes " + std::to_string(attributes);
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method copies a Triangulation into this mesh: the coordinates (a third one is dropped for
+    2 dimensions), the attributes and the IDs. Points of a Triangulation have no attributes, so those of this
+    mesh are zero.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+bool StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::assign(Triangulation &mesh)
+{
+    if (mesh.getNumberOfAttributesPerCell() != CellAttributes && !(mesh.getMyTriangles().empty() && CellAttributes == 0))
+    {
+        return false;
+    }
+    clear();
+    std::vector<Vertex*> &points(mesh.getMyPoints());
+    std::vector<Triangle*> &triangles(mesh.getMyTriangles());
+    myPoints.resize(points.size());
+    myPointIds.resize(points.size());
+    for (int j = 0; j < (int)points.size(); ++j)
+    {
+        for (int i = 0; i < Dimensions; ++i)
+        {
+            myPoints[j].coordinate[i] = (*points[j])[i];
+        }
+        myPoints[j].attributes.fill(0);
+        myPointIds[j] = points[j]->getId();
+    }
+    myCells.resize(triangles.size());
+    myCellIds.resize(triangles.size());
+    for (int j = 0; j < (int)triangles.size(); ++j)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            myCells[j].vertices[i] = (*triangles[j])[i];
+        }
+        for (int i = 0; i < CellAttributes; ++i)
+        {
+            myCells[j].attributes[i] = triangles[j]->getAttributes()[i];
+        }
+        myCellIds[j] = triangles[j]->getId();
+    }
+    myPointIndex.build(myPoints.size(), [this](int p) { return myPointIds[p]; });
+    myCellIndex.build(myCells.size(), [this](int t) { return myCellIds[t]; });
+    buildAdjacency();
+    return true;
+}
+
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+void StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::clear()
+{
+    myPoints.clear();
+    myCells.clear();
+    myPointIds.clear();
+    myCellIds.clear();
+    myPointIndex.clear();
+    myCellIndex.clear();
+}
+
+/*
+    The following method finds the neighbours of every cell by matching their edges, in the same way as
+    Triangulation::buildAdjacency().
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+void StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::buildAdjacency()
+{
+    EdgeMap openEdges; // Edges seen on one cell so far.
+    for (int j = 0; j < (int)myCells.size(); ++j)
+    {
+        myCells[j].neighbours[0] = myCells[j].neighbours[1] = myCells[j].neighbours[2] = -1;
+        MeshAlgorithms::linkCell(getView(), openEdges, j);
+    }
+}
+
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+Scalar StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::calculateArea(int slot)
+{
+    Scalar *a(myPoints[myCells[slot].vertices[0]].coordinate), *b(myPoints[myCells[slot].vertices[1]].coordinate), *c(myPoints[myCells[slot].vertices[2]].coordinate);
+    return std::abs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) / 2;
+}
+
+/*
+    The following method calculates the circumcentre of a cell from the coordinates relative to its first vertex,
+    which keeps the precision for large coordinates. A degenerate cell gives an infinite radius.
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+void StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::calculateCircumcentre(int slot, Scalar &x, Scalar &y, Scalar &radiusSquared)
+{
+    Scalar *a(myPoints[myCells[slot].vertices[0]].coordinate), *b(myPoints[myCells[slot].vertices[1]].coordinate), *c(myPoints[myCells[slot].vertices[2]].coordinate);
+    Scalar bx(b[0] - a[0]), by(b[1] - a[1]), cx(c[0] - a[0]), cy(c[1] - a[1]);
+    Scalar d(2 * (bx * cy - by * cx)), b2(bx * bx + by * by), c2(cx * cx + cy * cy);
+    if (d == 0)
+    {
+        x = a[0];
+        y = a[1];
+        radiusSquared = INFINITY;
+        return;
+    }
+    Scalar ux((cy * b2 - by * c2) / d), uy((bx * c2 - cx * b2) / d);
+    x = a[0] + ux;
+    y = a[1] + uy;
+    radiusSquared = ux * ux + uy * uy;
+}
+
+/*
+    The following method checks every interior edge of the mesh with the exact predicates, splitting the cells
+    over numberOfThreads threads (0 uses every core), like Triangulation::isDelaunay().
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+bool StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::isDelaunay(int numberOfThreads)
+{
+    return MeshAlgorithms::findViolations(getView(), myCells.size(), NULL, numberOfThreads);
+}
+
+/*
+    The following method integrates t in the same way as Triangulation::integration() with a quadrature rule,
+    see MeshAlgorithms::integration().
+*/
+template<typename Scalar, int Dimensions, int CellAttributes, int PointAttributes>
+template<typename T>
+double StaticMesh<Scalar, Dimensions, CellAttributes, PointAttributes>::integration(T t, Quadrature::Rule rule, int numberOfThreads)
+{
+    return MeshAlgorithms::integration(getView(), myCells.size(), t, rule, numberOfThreads);
+}
+
+#endif
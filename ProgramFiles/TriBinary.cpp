@@ -0,0 +1,100 @@
+#include "TriBinary.h"
+#include <cstring> // Comparing and copying the magic bytes.
+
+/*
+    The following method fills in the header for a mesh of the given size and lays out the blocks one after the
+    other, each aligned.
+*/
+void TriBinary::initialise(TriBinaryHeader &header, int numberOfPoints, int numberOfDimensions, int numberOfAttributesPerPoint, int numberOfCells, int numberOfAttributesPerCell, bool hasNeighbours, bool hasIds)
+{
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "TRIMESH", 8);
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numberOfPoints = numberOfPoints;
+    header.numberOfDimensions = numberOfDimensions;
+    header.numberOfAttributesPerPoint = numberOfAttributesPerPoint;
+    header.numberOfCells = numberOfCells;
+    header.numberOfVerticesPerCell = 3;
+    header.numberOfAttributesPerCell = numberOfAttributesPerCell;
+
+    std::uint64_t pointBlock(sizeof(float) * (std::uint64_t)numberOfPoints), cellBlock(3 * sizeof(int) * (std::uint64_t)numberOfCells);
+    header.xOffset = align(sizeof(header));
+    header.yOffset = align(header.xOffset + pointBlock);
+    header.zOffset = align(header.yOffset + pointBlock);
+    header.connectivityOffset = align(header.zOffset + pointBlock);
+    header.attributesOffset = align(header.connectivityOffset + cellBlock);
+    std::uint64_t end(header.attributesOffset + sizeof(float) * (std::uint64_t)numberOfAttributesPerCell * numberOfCells);
+    if (hasNeighbours)
+    {
+        header.neighboursOffset = align(end);
+        end = header.neighboursOffset + cellBlock;
+    }
+    if (hasIds)
+    {
+        header.pointIdsOffset = align(end);
+        header.cellIdsOffset = align(header.pointIdsOffset + sizeof(std::int64_t) * (std::uint64_t)numberOfPoints);
+        end = header.cellIdsOffset + sizeof(std::int64_t) * (std::uint64_t)numberOfCells;
+    }
+    header.fileSize = end;
+}
+
+/*
+    The following method checks that a header belongs to a file this code can read and that every block lies
+    inside the file and is aligned. The header of a version 1 file is shorter; what was read past its end is
+    padding and is cleared.
+*/
+bool TriBinary::check(TriBinaryHeader &header, std::size_t fileSize, std::string &error)
+{
+    if (fileSize < sizeof(header) || std::memcmp(header.magic, "TRIMESH", 8) != 0)
+    {
+        error = "not a binary mesh file";
+        return false;
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK)
+    {
+        error = "the file was written on a machine of the other byte order";
+        return false;
+    }
+    if (header.version < 1 || header.version > VERSION)
+    {
+        error = "unsupported version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.version == 1)
+    {
+        header.pointIdsOffset = header.cellIdsOffset = 0;
+    }
+    if (header.numberOfPoints < 0 || header.numberOfCells < 0 || header.numberOfAttributesPerCell < 0 || header.numberOfVerticesPerCell != 3 || header.numberOfDimensions < 1 || header.numberOfDimensions > 3)
+    {
+        error = "invalid counts in the header";
+        return false;
+    }
+    if (header.fileSize != fileSize)
+    {
+        error = "the file is " + std::to_string(fileSize) + " bytes, the header says " + std::to_string(header.fileSize);
+        return false;
+    }
+
+    std::uint64_t pointBlock(sizeof(float) * (std::uint64_t)header.numberOfPoints), cellBlock(3 * sizeof(int) * (std::uint64_t)header.numberOfCells);
+    std::uint64_t offsets[8] = {header.xOffset, header.yOffset, header.zOffset, header.connectivityOffset, header.attributesOffset, header.neighboursOffset, header.pointIdsOffset, header.cellIdsOffset};
+    std::uint64_t sizes[8] = {pointBlock, pointBlock, pointBlock, cellBlock, sizeof(float) * (std::uint64_t)header.numberOfAttributesPerCell * header.numberOfCells, cellBlock, sizeof(std::int64_t) * (std::uint64_t)header.numberOfPoints, sizeof(std::int64_t) * (std::uint64_t)header.numberOfCells};
+    if ((header.pointIdsOffset == 0) != (header.cellIdsOffset == 0))
+    {
+        error = "the file has the IDs of only the points or only the cells";
+        return false;
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        if (i >= 5 && offsets[i] == 0) // The neighbours and the IDs are optional.
+        {
+            continue;
+        }
+        if (offsets[i] < sizeof(header) || offsets[i] % ALIGNMENT != 0 || offsets[i] > fileSize || sizes[i] > fileSize - offsets[i])
+        {
+            error = "block " + std::to_string(i) + " lies outside the file or is not aligned";
+            return false;
+        }
+    }
+    return true;
+}
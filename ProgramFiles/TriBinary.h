@@ -0,0 +1,52 @@
+#ifndef TRIBINARY_H
+#define TRIBINARY_H
+
+#include <cstdint> // Fixed width integers of the file header.
+#include <cstddef> // For std::size_t.
+#include <string> // Error messages.
+
+/*
+    The following TriBinaryHeader struct starts every binary mesh file. It is followed by blocks of raw arrays,
+    each starting at a multiple of TriBinary::ALIGNMENT bytes so they can be used in place once the file is
+    memory mapped: the x, y and z coordinates of the points (floats), the connectivity (three ints per cell),
+    the attributes (numberOfAttributesPerCell floats per cell), optionally the neighbours (three ints per
+    cell, as Triangle::getNeighbour()) and optionally the IDs of the points and of the cells (64 bit integers).
+    The connectivity and the neighbours hold positions, not IDs. A block offset of 0 means the block is absent;
+    without the ID blocks the IDs are the positions. Version 1 files end the header at fileSize and have no ID
+    blocks. Numbers are stored in the byte order of the machine which wrote the file; byteOrder tells a reader
+    whether that is its own.
+*/
+struct TriBinaryHeader
+{
+    char magic[8]; // "TRIMESH" followed by a zero byte.
+    std::uint32_t version; // Format version, TriBinary::VERSION.
+    std::uint32_t byteOrder; // 0x01020304 as written by the writer.
+    std::int32_t numberOfPoints, numberOfDimensions, numberOfAttributesPerPoint; // As in the .tri points header.
+    std::int32_t numberOfCells, numberOfVerticesPerCell, numberOfAttributesPerCell; // As in the .tri cells header.
+    std::uint64_t xOffset, yOffset, zOffset; // Byte offsets of the coordinate blocks.
+    std::uint64_t connectivityOffset, attributesOffset, neighboursOffset; // Byte offsets of the cell blocks.
+    std::uint64_t fileSize; // Total size, catches truncated files.
+    std::uint64_t pointIdsOffset, cellIdsOffset; // Byte offsets of the ID blocks. Since version 2.
+};
+
+/*
+    The following TriBinary class has the constants and checks of the binary format shared by the writer and
+    the reader.
+*/
+class TriBinary
+{
+public:
+    static const std::uint32_t VERSION = 2; // Bumped whenever the layout changes.
+    static const std::uint32_t BYTE_ORDER_MARK = 0x01020304; // Reads back differently on a machine of the other byte order.
+    static const std::uint64_t ALIGNMENT = 64; // Blocks start on cache line boundaries.
+
+    static void initialise(TriBinaryHeader &header, int numberOfPoints, int numberOfDimensions, int numberOfAttributesPerPoint, int numberOfCells, int numberOfAttributesPerCell, bool hasNeighbours, bool hasIds = false); // Fills in the header and the block layout.
+    static bool check(TriBinaryHeader &header, std::size_t fileSize, std::string &error); // Validates a header read from a file of the given size. Clears the fields a version 1 file does not have.
+
+    static std::uint64_t align(std::uint64_t offset) // Rounds up to the next block boundary.
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+};
+
+#endif
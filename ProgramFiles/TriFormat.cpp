@@ -0,0 +1,191 @@
+#include "TriFormat.h"
+#include <charconv> // std::from_chars.
+#include <algorithm> // std::count.
+#include <cstring> // std::memcpy.
+
+bool TriFormat::parseInt(const char *&position, const char *end, int &value)
+{
+    skipBlanks(position, end);
+    std::from_chars_result result(std::from_chars(position, end, value));
+    if (result.ec != std::errc())
+    {
+        return false;
+    }
+    position = result.ptr;
+    return true;
+}
+
+bool TriFormat::parseIdSlow(const char *&position, const char *end, long long &value)
+{
+    std::from_chars_result result(std::from_chars(position, end, value));
+    if (result.ec != std::errc() || value < 0)
+    {
+        return false;
+    }
+    position = result.ptr;
+    return true;
+}
+
+bool TriFormat::parseFloatSlow(const char *&position, const char *end, float &value)
+{
+    std::from_chars_result result(std::from_chars(position, end, value));
+    if (result.ec != std::errc())
+    {
+        return false;
+    }
+    position = result.ptr;
+    return true;
+}
+
+/*
+    The following method finishes parseFloatFast() when the digits are followed by an exponent, or by something
+    else which starts a letter: hexadecimal, inf and nan are left to std::from_chars. An 'e' which no digits
+    follow is not part of the number.
+*/
+bool TriFormat::parseFloatExponent(const char *&position, const char *p, const char *end, bool isNegative, unsigned long long significand, int digits, int exponent, float &value)
+{
+    if (*p == 'e' || *p == 'E')
+    {
+        const char *q(p + 1);
+        bool isExponentNegative(false);
+        if (q != end && (*q == '-' || *q == '+'))
+        {
+            isExponentNegative = *q == '-';
+            ++q;
+        }
+        if (q != end && isDigit(*q))
+        {
+            int written(0);
+            for (; q != end && isDigit(*q); ++q)
+            {
+                if (written < 10000)
+                {
+                    written = written * 10 + (*q - '0');
+                }
+            }
+            exponent += isExponentNegative ? -written : written;
+            p = q;
+        }
+    }
+    if (p != end && (*p == 'x' || *p == 'X' || *p == 'n' || *p == 'N' || *p == 'i' || *p == 'I'))
+    {
+        return false;
+    }
+    if (!convertDecimal(isNegative, significand, digits, exponent, value))
+    {
+        return false;
+    }
+    position = p;
+    return true;
+}
+
+/*
+    The following method is the double half of Clinger's fast path for a significand of up to 15 digits.
+*/
+bool TriFormat::convertDecimalDouble(bool isNegative, unsigned long long significand, int exponent, float &value)
+{
+    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (exponent < -22 || exponent > 22)
+    {
+        return false;
+    }
+    double result((double)significand);
+    result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+    if (result < 1.1754943508222875e-38 || result > 3.4028234663852886e+38) // Subnormal or out of range as a float.
+    {
+        return false;
+    }
+    unsigned long long bits;
+    std::memcpy(&bits, &result, sizeof(bits));
+    if ((bits & 0x1FFFFFFFull) == 0x10000000ull) // Exactly halfway between two floats.
+    {
+        return false;
+    }
+    value = (float)(isNegative ? -result : result);
+    return true;
+}
+
+bool TriFormat::parseDouble(const char *&position, const char *end, double &value)
+{
+    skipBlanks(position, end);
+    std::from_chars_result result(std::from_chars(position, end, value));
+    if (result.ec != std::errc())
+    {
+        return false;
+    }
+    position = result.ptr;
+    return true;
+}
+
+/*
+    The following method reads a header line made of three non-negative integers.
+*/
+bool TriFormat::parseHeader(const char *&position, const char *end, TriHeader &header)
+{
+    skipWhitespace(position, end);
+    if (!parseInt(position, end, header.count) || !parseInt(position, end, header.valuesPerEntry) || !parseInt(position, end, header.attributesPerEntry))
+    {
+        return false;
+    }
+    if (header.count < 0 || header.valuesPerEntry < 0 || header.attributesPerEntry < 0)
+    {
+        return false;
+    }
+    return endOfLine(position, end);
+}
+
+bool TriFormat::endOfLine(const char *&position, const char *end)
+{
+    while (position != end && isBlank(*position))
+    {
+        ++position;
+    }
+    if (position == end) // The last line does not need a line break.
+    {
+        return true;
+    }
+    if (*position != '\n') // Something else follows on this line.
+    {
+        return false;
+    }
+    ++position;
+    return true;
+}
+
+void TriFormat::skipWhitespace(const char *&position, const char *end)
+{
+    while (position != end && (isBlank(*position) || *position == '\n'))
+    {
+        ++position;
+    }
+}
+
+const char *TriFormat::nextLine(const char *position, const char *end)
+{
+    const char *lineBreak((const char *)std::memchr(position, '\n', end - position));
+    return lineBreak == NULL ? end : lineBreak + 1;
+}
+
+long long TriFormat::countRecords(const char *begin, const char *end)
+{
+    long long count(0);
+    bool isEmpty(true); // Nothing but blanks seen on the current line so far.
+    for (const char *p = begin; p != end; ++p)
+    {
+        if (*p == '\n')
+        {
+            count += !isEmpty;
+            isEmpty = true;
+        }
+        else if (!isBlank(*p))
+        {
+            isEmpty = false;
+        }
+    }
+    return count + !isEmpty; // The last line may have no line break.
+}
+
+int TriFormat::lineNumber(const char *begin, const char *position)
+{
+    return std::count(begin, position, '\n') + 1;
+}
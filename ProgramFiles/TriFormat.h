@@ -0,0 +1,277 @@
+#ifndef TRIFORMAT_H
+#define TRIFORMAT_H
+
+#include <cstddef> // For std::size_t.
+#include <string> // Error messages.
+
+/*
+    The following TriHeader struct holds one header line of a .tri file: the number of entries in the section,
+    the number of values per entry (dimensions for points, vertices for cells) and the number of attributes.
+*/
+struct TriHeader
+{
+    int count, valuesPerEntry, attributesPerEntry;
+};
+
+/*
+    The following LoadStatistics struct reports how a fast load went. error is empty on success and otherwise
+    says what was wrong and on which line.
+*/
+struct LoadStatistics
+{
+    LoadStatistics() : bytes(0), seconds(0.0), numberOfPoints(0), numberOfCells(0) {;}
+
+    double getMegabytesPerSecond() const // Parse throughput.
+    {
+        return seconds > 0.0 ? bytes / seconds / 1.0e6 : 0.0;
+    }
+
+    std::size_t bytes; // Size of the file.
+    double seconds; // Wall time of the whole load.
+    int numberOfPoints, numberOfCells; // Entries read.
+    std::string error; // Reason of a failure.
+};
+
+/*
+    The following TriFormat class has the low level routines for parsing .tri text held in memory. They work on
+    a position which is moved past what was read and never read at or beyond end. Short decimals are converted
+    exactly by hand and everything else with std::from_chars; neither depends on the locale and both give the
+    same correctly rounded values as the stream operators. IDs and floats, which make up nearly all of a file,
+    are parsed inline. Records must be one per line; blank lines between records are allowed.
+*/
+class TriFormat
+{
+public:
+    static bool parseInt(const char *&position, const char *end, int &value); // Reads an integer on the current line.
+    static bool parseDouble(const char *&position, const char *end, double &value); // Reads a double on the current line.
+    static bool parseHeader(const char *&position, const char *end, TriHeader &header); // Reads a whole header line.
+
+    template<typename S>
+    static bool parsePointRecord(const char *&position, const char *end, long long &id, S *coordinates, int numberOfCoordinates, S *attributes, int numberOfAttributes, std::string &error); // Reads a whole point line. attributes may be NULL to check them without storing them.
+
+    template<typename S, typename F>
+    static bool parseCellRecord(const char *&position, const char *end, long long &id, F findPoint, int *vertices, S *attributes, int numberOfAttributes, std::string &error); // Reads a whole cell line, turning the IDs of its vertices into positions with findPoint.
+
+    static bool endOfLine(const char *&position, const char *end); // Checks nothing but blanks is left on the line and moves past it.
+    static void skipWhitespace(const char *&position, const char *end); // Moves past blanks and line breaks.
+    static const char *nextLine(const char *position, const char *end); // Start of the line after the one position is on, or end.
+    static long long countRecords(const char *begin, const char *end); // Number of lines with anything but blanks on them.
+    static int lineNumber(const char *begin, const char *position); // Line of position, counted from 1, for error messages.
+
+    static bool isBlank(char c) // Space, tab or carriage return: separators within a line.
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static bool parseId(const char *&position, const char *end, long long &value) // Reads a non-negative 64 bit ID on the current line.
+    {
+        skipBlanks(position, end);
+        const char *p(position);
+        unsigned long long result(0);
+        for (; p != end && isDigit(*p) && p - position < 18; ++p) // Up to 18 digits cannot overflow.
+        {
+            result = result * 10 + (*p - '0');
+        }
+        if (p == position || (p != end && isDigit(*p))) // A sign or a longer number.
+        {
+            return parseIdSlow(position, end, value);
+        }
+        value = result;
+        position = p;
+        return true;
+    }
+
+    static bool parseFloat(const char *&position, const char *end, float &value) // Reads a float on the current line.
+    {
+        skipBlanks(position, end);
+        return parseFloatFast(position, end, value) || parseFloatSlow(position, end, value);
+    }
+
+    static bool parseValue(const char *&position, const char *end, float &value) // parseFloat() or parseDouble() by the type of value.
+    {
+        return parseFloat(position, end, value);
+    }
+
+    static bool parseValue(const char *&position, const char *end, double &value)
+    {
+        return parseDouble(position, end, value);
+    }
+
+private:
+    static bool isDigit(char c)
+    {
+        return (unsigned char)(c - '0') < 10;
+    }
+
+    /*
+        The following method moves position to the next token on the current line. A leading '+', which the
+        stream operators accept and std::from_chars does not, is skipped.
+    */
+    static void skipBlanks(const char *&position, const char *end)
+    {
+        while (position != end && isBlank(*position))
+        {
+            ++position;
+        }
+        if (position != end && *position == '+')
+        {
+            ++position;
+        }
+    }
+
+    /*
+        The following method converts a plain decimal number such as -5.39999 or 1.08516e-06 without a library
+        call when that can be done exactly (Clinger's fast path). A significand of at most 7 digits and a power of
+        ten up to 10^10 are both exact floats, so one float multiplication or division gives the correctly
+        rounded float. Up to 15 digits and 10^22 the same holds for doubles, and rounding that double to float
+        gives the correctly rounded float unless it lies exactly halfway between two floats or in the subnormal
+        range, which is rejected. Returns false if the number has to be left to std::from_chars. On success
+        position is moved past the number.
+    */
+    static bool parseFloatFast(const char *&position, const char *end, float &value)
+    {
+        const char *p(position);
+        bool isNegative(p != end && *p == '-');
+        p += isNegative;
+        unsigned long long significand(0);
+        int digits(0), exponent(0);
+        const char *digitsBegin(p);
+        for (; p != end && isDigit(*p); ++p) // Integer part.
+        {
+            significand = significand * 10 + (*p - '0');
+            digits += (significand != 0);
+        }
+        bool hasDigits(p != digitsBegin);
+        if (p != end && *p == '.') // Fraction.
+        {
+            const char *fractionBegin(++p);
+            for (; p != end && isDigit(*p); ++p)
+            {
+                significand = significand * 10 + (*p - '0');
+                digits += (significand != 0);
+            }
+            exponent = fractionBegin - p;
+            hasDigits = hasDigits || p != fractionBegin;
+        }
+        if (!hasDigits || digits > 15) // Not a number, or too many digits to be exact.
+        {
+            return false;
+        }
+        if (p != end && (*p == 'e' || *p == 'E' || *p == 'x' || *p == 'X' || *p == 'n' || *p == 'N' || *p == 'i' || *p == 'I'))
+        {
+            return parseFloatExponent(position, p, end, isNegative, significand, digits, exponent, value);
+        }
+        if (!convertDecimal(isNegative, significand, digits, exponent, value))
+        {
+            return false;
+        }
+        position = p;
+        return true;
+    }
+
+    static bool convertDecimal(bool isNegative, unsigned long long significand, int digits, int exponent, float &value) // Clinger's fast path for significand * 10^exponent.
+    {
+        static const float powersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        if (significand == 0)
+        {
+            value = isNegative ? -0.0f : 0.0f;
+            return true;
+        }
+        if (digits <= 7 && exponent >= -10 && exponent <= 10)
+        {
+            float result((float)significand);
+            result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+            value = isNegative ? -result : result;
+            return true;
+        }
+        return convertDecimalDouble(isNegative, significand, exponent, value);
+    }
+
+    static bool parseFloatExponent(const char *&position, const char *p, const char *end, bool isNegative, unsigned long long significand, int digits, int exponent, float &value); // parseFloatFast() for numbers with an exponent.
+    static bool convertDecimalDouble(bool isNegative, unsigned long long significand, int exponent, float &value); // convertDecimal() through a double.
+    static bool parseIdSlow(const char *&position, const char *end, long long &value); // parseId() with std::from_chars.
+    static bool parseFloatSlow(const char *&position, const char *end, float &value); // parseFloat() with std::from_chars.
+};
+
+/*
+    The following method parses a line of the points section, starting at its first token: the ID, then
+    numberOfCoordinates coordinates and numberOfAttributes attributes, and nothing else. On failure error says
+    what is wrong and position is left on the line.
+*/
+template<typename S>
+bool TriFormat::parsePointRecord(const char *&position, const char *end, long long &id, S *coordinates, int numberOfCoordinates, S *attributes, int numberOfAttributes, std::string &error)
+{
+    if (!parseId(position, end, id))
+    {
+        error = "malformed point ID";
+        return false;
+    }
+    for (int i = 0; i < numberOfCoordinates; ++i)
+    {
+        if (!parseValue(position, end, coordinates[i]))
+        {
+            error = "point " + std::to_string(id) + " has fewer than " + std::to_string(numberOfCoordinates) + " coordinates";
+            return false;
+        }
+    }
+    for (int i = 0; i < numberOfAttributes; ++i)
+    {
+        S attribute;
+        if (!parseValue(position, end, attributes != NULL ? attributes[i] : attribute))
+        {
+            error = "point " + std::to_string(id) + " has fewer than " + std::to_string(numberOfAttributes) + " attributes";
+            return false;
+        }
+    }
+    if (!endOfLine(position, end))
+    {
+        error = "point " + std::to_string(id) + " has more values than the header announces";
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method parses a line of the cells section, starting at its first token: the ID, three vertex
+    IDs, which findPoint(id) turns into positions (-1 for an unknown point), and numberOfAttributes attributes.
+*/
+template<typename S, typename F>
+bool TriFormat::parseCellRecord(const char *&position, const char *end, long long &id, F findPoint, int *vertices, S *attributes, int numberOfAttributes, std::string &error)
+{
+    if (!parseId(position, end, id))
+    {
+        error = "malformed cell ID";
+        return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+        long long vertexId;
+        if (!parseId(position, end, vertexId))
+        {
+            error = "cell " + std::to_string(id) + " has fewer than 3 vertices";
+            return false;
+        }
+        vertices[i] = findPoint(vertexId);
+        if (vertices[i] == -1)
+        {
+            error = "cell " + std::to_string(id) + " refers to a point which does not exist";
+            return false;
+        }
+    }
+    for (int i = 0; i < numberOfAttributes; ++i)
+    {
+        if (!parseValue(position, end, attributes[i]))
+        {
+            error = "cell " + std::to_string(id) + " has fewer than " + std::to_string(numberOfAttributes) + " attributes";
+            return false;
+        }
+    }
+    if (!endOfLine(position, end))
+    {
+        error = "cell " + std::to_string(id) + " has more values than the header announces";
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "Triangle.h"
+#include "Predicates.h" // Exact orientation and in-circle tests.
 
 /*
     The following method is used to evaluate whether the newPoint lies inside any triangle.
@@ -9,36 +10,41 @@
 */
 bool Triangle::isPointInTriangle(Vertex &newPoint, std::vector<Vertex*> &myPoints)
 {
-    float Ax((*myPoints.at(vertices[0]))[0]), Ay((*myPoints.at(vertices[0]))[1]); // Optimization: avoiding to read these values repeatedly.
-
-    // Setting vetrices[0] as the base, we create these objects to hold the subtraction between points and the base.
-    Vertex AB((*myPoints.at(vertices[1]))[0] - Ax, (*myPoints.at(vertices[1]))[1] - Ay); // AB(Bx - Ax, By - Ay)
-    Vertex AC((*myPoints.at(vertices[2]))[0] - Ax, (*myPoints.at(vertices[2]))[1] - Ay); // AC(Cx - Ax, Cy - Ay)
-    Vertex AP(newPoint[0] - Ax, newPoint[1] - Ay); // AP(Px - Ax, Py - Ay)
-
-    // Applying the formulas suggested for the Barycentric weights and scalar d.
-    float d(1.0 / ((AB[0] * AC[1]) - (AC[0] * AB[1]))); // Optimization: calculating 1/d to avoid multiple divisions below.
-    float wa(((AP[0] * (AB[1] - AC[1])) + (AP[1] * (AC[0] - AB[0])) + ((AB[0] * AC[1]) - (AC[0] * AB[1]))) * d);
-    float wb(((AP[0] * AC[1]) - (AP[1] * AC[0])) * d);
-    float wc(((AP[1] * AB[0]) - (AP[0] * AB[1])) * d);
+    int *vertices(getVertices());
+    Vertex &A = *myPoints.at(vertices[0]), &B = *myPoints.at(vertices[1]), &C = *myPoints.at(vertices[2]);
+    return isPointInTriangle(newPoint[0], newPoint[1], A[0], A[1], B[0], B[1], C[0], C[1]);
+}
 
-    // Evaluating the condition which determines the decision.
-    if ((wa >= 0 && wa <= 1) && (wb >= 0 && wb <= 1) && (wc >= 0 && wc <= 1))
+/*
+    The following static method holds the actual test of the method above. It works on plain coordinates so
+    that it can be used on the flat arrays of a PackedMesh without going through Vertex objects. The point is
+    (px, py) and the triangle is A, B, C. The point is inside (or on the boundary) if it is not strictly on the
+    outer side of any edge, which is decided with the exact orientation test. A degenerate triangle contains nothing.
+*/
+bool Triangle::isPointInTriangle(float px, float py, float Ax, float Ay, float Bx, float By, float Cx, float Cy)
+{
+    int side(sign(Predicates::orientation(Ax, Ay, Bx, By, Cx, Cy))); // Orientation of the triangle.
+    if (side == 0)
     {
-        return true;
+        return false;
     }
-
-    return false;
+    // Each edge with the point as the third corner must have the orientation of the triangle or be flat.
+    int sideA(sign(Predicates::orientation(Bx, By, Cx, Cy, px, py)));
+    int sideB(sign(Predicates::orientation(Cx, Cy, Ax, Ay, px, py)));
+    int sideC(sign(Predicates::orientation(Ax, Ay, Bx, By, px, py)));
+    return (sideA != -side) && (sideB != -side) && (sideC != -side);
 }
 
 /*
     The following method is used to check whether or not the given newPoint lies inside the circumcircle
-    of this triangle. Return value is boolean true or false. The function assumes that the circumcentre function was
-    called before invoking this.
+    of this triangle. Return value is boolean true or false. It compares with the circle calculated in floats,
+    so points very close to the circle may come out either way. It is deprecated and kept for existing callers;
+    the overload below taking the points is exact.
     Mathematics reference: https://math.stackexchange.com/questions/198764/how-to-know-if-a-point-is-inside-a-circle
 */
 bool Triangle::isPointInCircumcircle(Vertex &newPoint)
 {
+    Vertex circumcentrePoint(getCircumcentrePoint());
     float temp(newPoint[0] - circumcentrePoint[0]), temp2(newPoint[1] - circumcentrePoint[1]); // Difference between the point and the centre.
     float distance(sqrt((temp * temp) + ((temp2) * (temp2)))); // Calculating the distance. Optimization: not using pow(, 2).
 
@@ -47,36 +53,92 @@ bool Triangle::isPointInCircumcircle(Vertex &newPoint)
 }
 
 /*
-    The following method is used to find the circumcentre of the triangle.
-    The coordinates are stored in the Triangle's object itself. The mathematics applied here is
+    The following method checks whether newPoint lies inside or on the circumcircle of this triangle with the exact
+    in-circle test. It needs the container of all points, like isPointInTriangle(), but no circumcentre.
+*/
+bool Triangle::isPointInCircumcircle(Vertex &newPoint, std::vector<Vertex*> &myPoints)
+{
+    int *vertices(getVertices());
+    Vertex &A = *myPoints.at(vertices[0]), &B = *myPoints.at(vertices[1]), &C = *myPoints.at(vertices[2]);
+    return isPointInCircumcircle(newPoint[0], newPoint[1], A[0], A[1], B[0], B[1], C[0], C[1]);
+}
+
+/*
+    The following static method holds the test of the method above on plain coordinates. The sign of the in-circle
+    determinant is corrected by the orientation of the triangle, so the vertices may be in either order. A
+    degenerate triangle has no circumcircle and contains nothing.
+*/
+bool Triangle::isPointInCircumcircle(float px, float py, float Ax, float Ay, float Bx, float By, float Cx, float Cy)
+{
+    int side(sign(Predicates::orientation(Ax, Ay, Bx, By, Cx, Cy)));
+    if (side == 0)
+    {
+        return false;
+    }
+    return sign(Predicates::inCircle(Ax, Ay, Bx, By, Cx, Cy, px, py)) != -side; // Inside or on the circle.
+}
+
+/*
+    The following method is used to find the circumcentre of the triangle. The mathematics applied here is
     taken from the appendix of the specifications.
 */
-void Triangle::calculateCircumcentre(std::vector<Vertex*> &myPoints)
+Vertex Triangle::getCircumcentrePoint()
 {
+    float *x(mesh->getX()), *y(mesh->getY());
+    int *cell(mesh->getCell(slot));
     Vertex centre; // Placeholder for the calculated centre.
-    Vertex v0 = *myPoints.at(vertices[0]), v1 = *myPoints.at(vertices[1]), v2 = *myPoints.at(vertices[2]);
+    float radiusSquared; // Square of the radius as returned by the calculation.
+    calculateCircumcentre(x[cell[0]], y[cell[0]], x[cell[1]], y[cell[1]], x[cell[2]], y[cell[2]], centre[0], centre[1], radiusSquared);
+    return centre;
+}
 
+/*
+    The following method calculates the radius of the circumcircle the same way.
+*/
+float Triangle::getRadius()
+{
+    float *x(mesh->getX()), *y(mesh->getY());
+    int *cell(mesh->getCell(slot));
+    float centreX, centreY, radiusSquared;
+    calculateCircumcentre(x[cell[0]], y[cell[0]], x[cell[1]], y[cell[1]], x[cell[2]], y[cell[2]], centreX, centreY, radiusSquared);
+    return sqrt(radiusSquared); // Calculating the radius.
+}
+
+/*
+    The following static method holds the calculation of the circumcentre on plain coordinates so that it can be
+    used on the flat arrays as well. The inputs are the three vertices, the outputs are the centre and the square
+    of the radius.
+*/
+void Triangle::calculateCircumcentre(float ax, float ay, float bx, float by, float cx, float cy, float &centreX, float &centreY, float &radiusSquared)
+{
     // The following are calculations done to avoid repetition in the main formulas.
-    float temp1(v0[0]*v1[1]), temp3(v0[0]*v0[0]), temp4(v1[0]*v0[1]), temp5(v1[0]*v2[1]), temp6(v1[0]*v1[0]), temp7(v2[0]*v2[0]), temp8(v0[1]*v0[1]);
-    float temp2(1 / (2*(temp1 - temp4 - v0[0]*v2[1] + v2[0]*v0[1] + temp5 - v2[0]*v1[1])));
+    float temp1(ax*by), temp3(ax*ax), temp4(bx*ay), temp5(bx*cy), temp6(bx*bx), temp7(cx*cx), temp8(ay*ay);
+    float temp2(1 / (2*(temp1 - temp4 - ax*cy + cx*ay + temp5 - cx*by)));
 
     // Calculating the coordinates.
-    centre[0] = (v0[0]*temp1 - temp3*v2[1] - v1[0]*temp4 + v1[0]*temp5 + temp7*v0[1] - temp7*v1[1] + temp8*v1[1] - temp8*v2[1] - v0[1]*v1[1]*v1[1] + v0[1]*v2[1]*v2[1] + v1[1]*v1[1]*v2[1] - v1[1]*v2[1]*v2[1]) * temp2;
-    centre[1] = (- temp3*v1[0] + temp3*v2[0] + v0[0]*temp6 - v0[0]*temp7 + temp1*v1[1] - v0[0]*v2[1]*v2[1] - temp6*v2[0] + v1[0]*temp7 - temp4*v0[1] + temp5*v2[1] + v2[0]*temp8 - v2[0]*v1[1]*v1[1]) * temp2;
+    centreX = (ax*temp1 - temp3*cy - bx*temp4 + bx*temp5 + temp7*ay - temp7*by + temp8*by - temp8*cy - ay*by*by + ay*cy*cy + by*by*cy - by*cy*cy) * temp2;
+    centreY = (- temp3*bx + temp3*cx + ax*temp6 - ax*temp7 + temp1*by - ax*cy*cy - temp6*cx + bx*temp7 - temp4*ay + temp5*cy + cx*temp8 - cx*by*by) * temp2;
 
-    // Calculating the radius.
-    radius = sqrt(temp3 + temp8 - 2*centre[0]*v0[0] - 2*centre[1]*v0[1]+centre[0]*centre[0]+centre[1]*centre[1]);
-
-    this->setCircumcentrePoint(centre); // Storing the centre in the Triangle's object.
+    // Calculating the square of the radius.
+    radiusSquared = temp3 + temp8 - 2*centreX*ax - 2*centreY*ay+centreX*centreX+centreY*centreY;
 }
 
 /*
-    The following method is used to calculate the area of the triangle. The result
-    is stored within that triangle's object. The mathematics applied is from https://sciencing.com/area-triangle-its-vertices-8489292.html
+    The following method is used to calculate the area of the triangle.
+    The mathematics applied is from https://sciencing.com/area-triangle-its-vertices-8489292.html
 */
-void Triangle::calculateArea(std::vector<Vertex*> &myPoints) {
-    Vertex a = *myPoints.at(vertices[0]), b = *myPoints.at(vertices[1]), c = *myPoints.at(vertices[2]); // Obtain the coordinates using the vertices.
+float Triangle::getArea()
+{
+    float *x(mesh->getX()), *y(mesh->getY());
+    int *cell(mesh->getCell(slot)); // Obtain the coordinates using the vertices.
+    return calculateArea(x[cell[0]], y[cell[0]], x[cell[1]], y[cell[1]], x[cell[2]], y[cell[2]]);
+}
 
+/*
+    The following static method calculates the area of the triangle with the given vertices.
+*/
+float Triangle::calculateArea(float ax, float ay, float bx, float by, float cx, float cy)
+{
     // Applying the formula.
-    area = fabs((a[0] * (b[1] - c[1])) + (b[0] * (c[1] - a[1])) + (c[0] * (a[1] - b[1]))) / 2.0;
+    return fabs((ax * (by - cy)) + (bx * (cy - ay)) + (cx * (ay - by))) / 2.0;
 }
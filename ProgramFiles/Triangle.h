@@ -4,96 +4,94 @@
 #include <vector> // Needed for using the vector container.
 #include "Vertex.h" // Each triangle will have vertexes.
 #include "math.h" // Needed for mathematical operations used in methods.
+#include <algorithm> // Copying attributes into the mesh.
 /*
-    The following Triangle class is used to store a triangle with its associated
-    properties.
+    The following Triangle class is used to access a triangle with its associated properties. Like a Vertex of a
+    mesh it only refers to the position of the triangle in the PackedMesh of the mesh, which holds its vertices,
+    neighbours, ID and attributes, and a copy refers to the same triangle. The area and the circumcircle are
+    calculated from the coordinates of the vertices when they are asked for.
 */
 class Triangle
 {
 public:
-    Triangle() {;} // Constructor used for simply creating an object.
+    Triangle() : mesh(NULL), slot(-1) {;} // Constructor used for simply creating an object, which refers to no triangle until bind() is called.
 
-    Triangle(int node1, int node2, int node3, int lengthOfAttributes) // Overloaded constructor which initializes the vertexes.
-    {
-        vertices[0] = node1;
-        vertices[1] = node2;
-        vertices[2] = node3;
-        attributes = new float[lengthOfAttributes]; // Allocate memory for attributes as well.
-    }
+    Triangle(PackedMesh *mesh, int slot) : mesh(mesh), slot(slot) {;} // Constructor for the triangle at the given position of mesh.
 
-    ~Triangle() { // Destructor.
-        delete[] attributes; // clean up memory allocated for attributes.
+    void bind(PackedMesh *mesh, int slot) // Makes this object the triangle at the given position of mesh.
+    {
+        this->mesh = mesh;
+        this->slot = slot;
     }
 
     void setVertices(int *vertices) // Setter uses provided array to set values.
     {
-        for (int i = 0; i < 3; ++i)
-        {
-            this->vertices[i] = vertices[i];
-        }
+        mesh->setCell(slot, vertices[0], vertices[1], vertices[2]);
     }
 
-    void setId(int id) // Sets the ID
+    void setNeighbour(int edge, int triangle) // Sets the triangle across the given edge. -1 marks a boundary edge.
     {
-        this->id = id;
+        mesh->getNeighbours(slot)[edge] = triangle;
     }
 
-    void setAttributes(float *attributes) // Setter for the attributes requires an array input. Note that it should be dynamically allocated.
+    void setId(long long id) // Sets the ID
     {
-        this->attributes = attributes;
+        mesh->setCellId(slot, id);
     }
 
-    void setArea(float area) // Sets the area of the triangle.
+    void setAttributes(float *attributes) // Setter for the attributes requires an array input. Note that it should be dynamically allocated: the values are copied into the mesh and the array is freed.
     {
-        this->area = area;
+        std::copy(attributes, attributes + mesh->getAttributeStride(), getAttributes());
+        delete[] attributes;
     }
 
-    void setCircumcentrePoint(Vertex &point) // Given the circumcentre, the setter saves it to the triangle.
+    long long getId() // Returns the ID of this triangle.
     {
-        circumcentrePoint[0] = point[0];
-        circumcentrePoint[1] = point[1];
+        return mesh->getCellId(slot);
     }
 
-    void setRadius(float radius) // Sets the radius of the circumcircle.
+    int* getVertices() // Getter for the vertices array.
     {
-        this->radius = radius;
+        return mesh->getCell(slot);
     }
 
-    int getId() // Returns the ID of this triangle.
+    int *getNeighbours() // Getter for the neighbours array.
     {
-        return id;
+        return mesh->getNeighbours(slot);
     }
 
-    int* getVertices() // Getter for the vertices array.
+    int getNeighbour(int edge) // Returns the triangle across the given edge or -1 if there is none.
     {
-        return vertices;
+        return mesh->getNeighbours(slot)[edge];
     }
 
-    float *getAttributes() // Returns the pointer to the array of attributes.
+    bool isBoundaryEdge(int edge) // True if no other triangle shares the given edge.
     {
-        return attributes;
+        return (getNeighbour(edge) == -1);
     }
 
-    float getArea() // Returns the area of the triangle.
+    float *getAttributes() // Returns the pointer to the array of attributes.
     {
-        return area;
+        return mesh->getAttributes(slot);
     }
 
-    Vertex &getCircumcentrePoint() // Returns the circumcentre coordinates which are stored as a Vertex.
-    {
-        return circumcentrePoint;
-    }
+    float getArea(); // Returns the area of the triangle.
+    Vertex getCircumcentrePoint(); // Returns the circumcentre coordinates as a free Vertex.
+    float getRadius(); // Returns the radius of the circumcircle.
 
-    float getRadius() // Returns the radius.
+    bool isPointInTriangle(Vertex &newPoint, std::vector<Vertex*> &myPoints); // Method to check if a new point is inside a triangle.
+    static bool isPointInTriangle(float px, float py, float Ax, float Ay, float Bx, float By, float Cx, float Cy); // Same test on plain coordinates.
+    bool isPointInCircumcircle(Vertex &newPoint); // Deprecated: uses the float circumcircle of getCircumcentrePoint() and getRadius(), which may be wrong for points near the circle. Use the exact overload below.
+    bool isPointInCircumcircle(Vertex &newPoint, std::vector<Vertex*> &myPoints); // Same check done exactly from the vertices.
+    static bool isPointInCircumcircle(float px, float py, float Ax, float Ay, float Bx, float By, float Cx, float Cy); // Same test on plain coordinates.
+    static void calculateCircumcentre(float ax, float ay, float bx, float by, float cx, float cy, float &centreX, float &centreY, float &radiusSquared); // Circumcentre and squared radius from plain coordinates.
+    static float calculateArea(float ax, float ay, float bx, float by, float cx, float cy); // Area from plain coordinates.
+
+    static int sign(double value) // -1, 0 or 1, used on the results of the predicates.
     {
-        return radius;
+        return (value > 0) - (value < 0);
     }
 
-    bool isPointInTriangle(Vertex &newPoint, std::vector<Vertex*> &myPoints); // Method to check if a new point is inside a triangle.
-    bool isPointInCircumcircle(Vertex &newPoint); // Checks whether a point is inside the circumcircle of this triangle.
-    void calculateCircumcentre(std::vector<Vertex*> &myPoints); // Calculates the circumcentre.
-    void calculateArea(std::vector<Vertex*> &myPoints); // Calculates the area of the triangle.
-
     friend bool operator<(Triangle &t0, Triangle &t1) // Less than operator used for comparing and sorting the triangles by ID.
     {
         return (t0.getId() < t1.getId());
@@ -101,16 +99,12 @@ public:
 
     int &operator[](int index) // As for the getters/setters of the coordinates, the operator [] is used to access each dimension.
     {
-        return vertices[index];
+        return mesh->getCell(slot)[index];
     }
 
 private:
-    int vertices[3]; // Array stores the ID's of the vertex this triangle has. [0] => A, [1] => B, [2] => C
-    int id; // Unique ID of the triangle.
-    float *attributes; // Attributes of this triangle.
-    float radius; // Radius of the circumcircle.
-    Vertex circumcentrePoint; // Circumcentre of the triangle.
-    float area; // Area of the triangle.
+    PackedMesh *mesh; // Storage of the triangle.
+    int slot; // Position of the triangle in mesh. Its vertices are positions of points in mesh.
 };
 
 #endif
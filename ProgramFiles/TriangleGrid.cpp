@@ -0,0 +1,274 @@
+#include "TriangleGrid.h"
+#include <algorithm> // For std::min, std::max, std::find and std::copy.
+#include <math.h> // For sqrt and ceil.
+
+/*
+    The following method buckets all triangles of the provided mesh into the grid. The triangles and their
+    vertex coordinates are read from the flat arrays of the mesh. The grid is sized so
+    that on average every cell holds about one triangle. Building takes two passes over the triangles: the
+    first counts how many triangles land in each cell and the second fills the buckets, so the whole
+    build is linear in the number of triangles.
+*/
+void TriangleGrid::build(PackedMesh &mesh)
+{
+    clear(); // Start from an empty grid.
+    int numberOfTriangles = mesh.getNumberOfCells();
+    if (numberOfTriangles == 0) // Nothing to bucket.
+    {
+        return;
+    }
+
+    boxes.resize(4 * numberOfTriangles);
+    for (int j = 0; j < numberOfTriangles; ++j) // Compute the bounding boxes and the extent of the whole mesh.
+    {
+        computeBox(mesh, j);
+        if (j == 0) // The first box initialises the extent.
+        {
+            minX = boxes[0];
+            minY = boxes[1];
+            maxX = boxes[2];
+            maxY = boxes[3];
+        }
+        else
+        {
+            minX = std::min(minX, boxes[4 * j]);
+            minY = std::min(minY, boxes[4 * j + 1]);
+            maxX = std::max(maxX, boxes[4 * j + 2]);
+            maxY = std::max(maxY, boxes[4 * j + 3]);
+        }
+    }
+    coveredMinX = minX;
+    coveredMinY = minY;
+    coveredMaxX = maxX;
+    coveredMaxY = maxY;
+    builtTriangles = numberOfTriangles;
+
+    // Choose the resolution so that the cells are roughly square and there is about one cell per triangle.
+    float width(maxX - minX), height(maxY - minY);
+    if (width > 0 && height > 0)
+    {
+        columns = std::max(1, (int)ceil(sqrt(numberOfTriangles * (width / height))));
+        columns = std::min(columns, numberOfTriangles); // A very flat mesh should not end up with more cells than triangles.
+        rows = std::max(1, (int)ceil((double)numberOfTriangles / columns));
+    }
+    else // Degenerate mesh lying on a line: a single row or column is enough.
+    {
+        columns = width > 0 ? numberOfTriangles : 1;
+        rows = height > 0 ? numberOfTriangles : 1;
+    }
+    inverseCellWidth = width > 0 ? columns / width : 0;
+    inverseCellHeight = height > 0 ? rows / height : 0;
+
+    // First pass: count the triangles per cell. Every bucket gets exactly the room it needs.
+    cellCount.assign(columns * rows, 0);
+    for (int j = 0; j < numberOfTriangles; ++j)
+    {
+        visitCells(j, [&](int cell)
+        {
+            cellCount[cell]++;
+        });
+    }
+    cellStart.resize(columns * rows);
+    int offset(0);
+    for (int c = 0; c < columns * rows; ++c) // Prefix sum turns the counts into offsets.
+    {
+        cellStart[c] = offset;
+        offset += cellCount[c];
+    }
+    cellCapacity = cellCount;
+    unusedEntries = 0;
+
+    // Second pass: fill the buckets. Triangles are visited in container order so each bucket ends up sorted.
+    cellTriangles.resize(offset);
+    std::fill(cellCount.begin(), cellCount.end(), 0);
+    for (int j = 0; j < numberOfTriangles; ++j)
+    {
+        visitCells(j, [&](int cell)
+        {
+            cellTriangles[cellStart[cell] + cellCount[cell]++] = j;
+        });
+    }
+}
+
+/*
+    The following method releases the memory held by the grid. It is used when the mesh changes.
+*/
+void TriangleGrid::clear()
+{
+    std::vector<int>().swap(cellStart); // Swapping with an empty container actually frees the memory.
+    std::vector<int>().swap(cellCount);
+    std::vector<int>().swap(cellCapacity);
+    std::vector<int>().swap(cellTriangles);
+    std::vector<float>().swap(boxes);
+    columns = rows = 0;
+    unusedEntries = builtTriangles = 0;
+}
+
+/*
+    The following method puts the triangle at slot into the buckets of the cells its box overlaps. The slot is
+    either one past the last triangle of the grid or one which was taken out with erase() and changed shape.
+    A triangle outside the corners of the grid goes into the cells on the border, like a query point there.
+*/
+void TriangleGrid::insert(PackedMesh &mesh, int slot)
+{
+    if (4 * (std::size_t)slot == boxes.size())
+    {
+        boxes.resize(boxes.size() + 4);
+    }
+    computeBox(mesh, slot);
+    coveredMinX = std::min(coveredMinX, boxes[4 * slot]);
+    coveredMinY = std::min(coveredMinY, boxes[4 * slot + 1]);
+    coveredMaxX = std::max(coveredMaxX, boxes[4 * slot + 2]);
+    coveredMaxY = std::max(coveredMaxY, boxes[4 * slot + 3]);
+    visitCells(slot, [&](int cell)
+    {
+        addToCell(cell, slot);
+    });
+    if (2 * (std::size_t)unusedEntries > cellTriangles.size()) // More than half of the array is left behind by moved buckets.
+    {
+        compact();
+    }
+}
+
+/*
+    The following method takes the triangle at slot out of the buckets of its stored box. It has to be called
+    before the vertices of the triangle change, as long as the box still is the one it was bucketed with.
+*/
+void TriangleGrid::erase(int slot)
+{
+    visitCells(slot, [&](int cell)
+    {
+        int *bucket(&cellTriangles[cellStart[cell]]);
+        int *end(bucket + cellCount[cell]), *found(std::find(bucket, end, slot));
+        std::copy(found + 1, end, found);
+        cellCount[cell]--;
+    });
+}
+
+/*
+    The following method follows the removal of a triangle from the mesh, which moves the last triangle into
+    the position of the removed one. The moved triangle is the largest slot of its buckets, so it is the last
+    entry of each and is replaced by slot at its place in the order.
+*/
+void TriangleGrid::remove(int slot, int last)
+{
+    erase(slot);
+    if (slot != last)
+    {
+        std::copy(boxes.begin() + 4 * (std::size_t)last, boxes.end(), boxes.begin() + 4 * (std::size_t)slot);
+        visitCells(slot, [&](int cell)
+        {
+            cellCount[cell]--; // Drops last, which leaves room for slot.
+            addToCell(cell, slot);
+        });
+    }
+    boxes.resize(4 * (std::size_t)last);
+}
+
+/*
+    The following method returns the triangles which may contain the point (x, y). The output is a pointer
+    to the first slot of the bucket and count is set to the number of slots in it. Points outside the box of
+    all triangles return no candidates. The candidates still need to be tested exactly by the caller.
+*/
+const int *TriangleGrid::getCandidates(float x, float y, int &count)
+{
+    count = 0;
+    if (isEmpty() || !(x >= coveredMinX && y >= coveredMinY && x <= coveredMaxX && y <= coveredMaxY)) // Away from every triangle (the negated form also rejects NaN).
+    {
+        return NULL;
+    }
+    int cell(rowOf(y) * columns + columnOf(x));
+    count = cellCount[cell];
+    return cellTriangles.data() + cellStart[cell];
+}
+
+/*
+    Maps an x coordinate onto a column. The same mapping is used while building and while querying which
+    guarantees that a point inside a triangle's box always lands in one of the cells the box was put in.
+    The clamping is done before converting to int, so any float, including an infinite query box, gives a
+    column of the grid.
+*/
+int TriangleGrid::columnOf(float x)
+{
+    float column((x - minX) * inverseCellWidth);
+    if (!(column > 0.0f)) // Left of the grid, or NaN.
+    {
+        return 0;
+    }
+    return column < columns - 1 ? (int)column : columns - 1;
+}
+
+/*
+    Maps a y coordinate onto a row. See columnOf().
+*/
+int TriangleGrid::rowOf(float y)
+{
+    float row((y - minY) * inverseCellHeight);
+    if (!(row > 0.0f)) // Below the grid, or NaN.
+    {
+        return 0;
+    }
+    return row < rows - 1 ? (int)row : rows - 1;
+}
+
+/*
+    The following method computes the bounding box of the triangle at slot from the flat arrays of the mesh.
+    No padding is needed: the containment tests are exact on these same float coordinates, so a point in or on
+    the triangle lies in its box, and columnOf() and rowOf() never decrease with the coordinate, so it also
+    lands in one of the cells of the box.
+*/
+void TriangleGrid::computeBox(PackedMesh &mesh, int slot)
+{
+    float *x(mesh.getX()), *y(mesh.getY());
+    int *cell(mesh.getCell(slot));
+    float ax(x[cell[0]]), bx(x[cell[1]]), cx(x[cell[2]]), ay(y[cell[0]]), by(y[cell[1]]), cy(y[cell[2]]);
+    float *box(&boxes[4 * (std::size_t)slot]);
+    box[0] = std::min(ax, std::min(bx, cx));
+    box[1] = std::min(ay, std::min(by, cy));
+    box[2] = std::max(ax, std::max(bx, cx));
+    box[3] = std::max(ay, std::max(by, cy));
+}
+
+/*
+    The following method puts slot into the bucket of a cell at its place in the ascending order. A full bucket
+    is first moved to the end of cellTriangles with half as much room again, so adding to a bucket is constant
+    time on average.
+*/
+void TriangleGrid::addToCell(int cell, int slot)
+{
+    if (cellCount[cell] == cellCapacity[cell])
+    {
+        int start(cellTriangles.size()), capacity(cellCount[cell] + cellCount[cell] / 2 + 2);
+        cellTriangles.resize(start + capacity);
+        std::copy(cellTriangles.begin() + cellStart[cell], cellTriangles.begin() + cellStart[cell] + cellCount[cell], cellTriangles.begin() + start);
+        unusedEntries += cellCapacity[cell];
+        cellStart[cell] = start;
+        cellCapacity[cell] = capacity;
+    }
+    int *bucket(&cellTriangles[cellStart[cell]]);
+    int k(cellCount[cell]++);
+    for (; k > 0 && bucket[k - 1] > slot; --k) // Shift the larger slots up by one.
+    {
+        bucket[k] = bucket[k - 1];
+    }
+    bucket[k] = slot;
+}
+
+/*
+    The following method copies the buckets one after another into a new array, each with exactly the room it
+    needs, which frees the entries left behind when buckets moved.
+*/
+void TriangleGrid::compact()
+{
+    std::vector<int> packed;
+    packed.reserve(cellTriangles.size() - unusedEntries);
+    for (int c = 0; c < columns * rows; ++c)
+    {
+        int start(packed.size());
+        packed.insert(packed.end(), cellTriangles.begin() + cellStart[c], cellTriangles.begin() + cellStart[c] + cellCount[c]);
+        cellStart[c] = start;
+        cellCapacity[c] = cellCount[c];
+    }
+    cellTriangles.swap(packed);
+    unusedEntries = 0;
+}
@@ -0,0 +1,128 @@
+#ifndef TRIANGLEGRID_H
+#define TRIANGLEGRID_H
+
+#include <vector> // Needed for using the vector container.
+#include <algorithm> // For std::max.
+#include "PackedMesh.h" // The grid reads the triangles from the flat arrays.
+
+/*
+    The following TriangleGrid class is a uniform bucket grid laid over the bounding box of the mesh.
+    Every cell of the grid stores the positions (slots) of the triangles in the Triangulation container
+    whose bounding box overlaps that cell. A point query then only has to test the few triangles
+    stored in the cell the point falls into instead of every triangle in the mesh.
+    The buckets of all cells share one array: the bucket of cell c starts at cellStart[c], holds cellCount[c]
+    slots and has room for cellCapacity[c]. Within a cell the slots are kept in ascending order. When the
+    mesh changes, the changed triangles are taken out of their buckets and put into new ones with erase(),
+    insert() and remove() instead of building the whole grid again. A full bucket moves to the end of the
+    array with more room. The cells keep the size they were built with, so once the number of triangles has
+    doubled or halved isStale() says the grid should be built again.
+*/
+class TriangleGrid
+{
+public:
+    TriangleGrid() : minX(0), minY(0), maxX(0), maxY(0), coveredMinX(0), coveredMinY(0), coveredMaxX(0), coveredMaxY(0), inverseCellWidth(0), inverseCellHeight(0), columns(0), rows(0), unusedEntries(0), builtTriangles(0) {;} // Constructor creates an empty grid.
+
+    void build(PackedMesh &mesh); // Buckets every triangle of the mesh into the grid.
+    void clear(); // Releases the buckets.
+    void insert(PackedMesh &mesh, int slot); // Buckets the triangle at this position, which is new or was taken out with erase().
+    void erase(int slot); // Takes the triangle at this position out of its buckets, before it changes shape.
+    void remove(int slot, int last); // The triangle at slot was removed and the last one, at position last, moved there.
+    const int *getCandidates(float x, float y, int &count); // Returns the slots of the triangles which may contain the point (x, y).
+
+    template<typename T>
+    void visitCandidates(float lowX, float lowY, float highX, float highY, T visit); // Calls visit(slot) once for every triangle whose box overlaps the given box.
+
+    bool isEmpty() // True if nothing has been built yet.
+    {
+        return cellStart.empty();
+    }
+
+    bool isStale() // True if the number of triangles has doubled or halved since the grid was built.
+    {
+        int numberOfTriangles(boxes.size() / 4);
+        return numberOfTriangles > 2 * builtTriangles || 2 * numberOfTriangles < builtTriangles;
+    }
+
+    int getColumns() // Number of cells along the x axis.
+    {
+        return columns;
+    }
+
+    int getRows() // Number of cells along the y axis.
+    {
+        return rows;
+    }
+
+private:
+    int columnOf(float x); // Maps an x coordinate to a column, clamped to the grid.
+    int rowOf(float y); // Maps a y coordinate to a row, clamped to the grid.
+    void computeBox(PackedMesh &mesh, int slot); // Stores the bounding box of a triangle.
+    void addToCell(int cell, int slot); // Puts a slot into the bucket of a cell, keeping the order.
+    template<typename T>
+    void visitCells(int slot, T visit); // Calls visit(cell) for every cell the box of a triangle overlaps.
+    void compact(); // Lays the buckets out one after another again, dropping the room left by moved buckets.
+
+    float minX, minY; // Lower left corner of the grid.
+    float maxX, maxY; // Upper right corner of the grid.
+    float coveredMinX, coveredMinY, coveredMaxX, coveredMaxY; // Box covering every triangle put into the grid, which grows past the corners when triangles are added outside them.
+    float inverseCellWidth, inverseCellHeight; // Optimization: multiplying by the inverse of the cell size instead of dividing.
+    int columns, rows; // Resolution of the grid.
+    std::vector<int> cellStart; // Offset of the bucket of each cell into cellTriangles, has columns * rows entries.
+    std::vector<int> cellCount; // Number of slots in the bucket of each cell.
+    std::vector<int> cellCapacity; // Room of the bucket of each cell.
+    std::vector<int> cellTriangles; // Triangle slots of all buckets.
+    int unusedEntries; // Entries of cellTriangles left behind by buckets which moved.
+    int builtTriangles; // Number of triangles the cells were sized for.
+    std::vector<float> boxes; // Bounding box of each triangle stored as minX, minY, maxX, maxY.
+};
+
+/*
+    The following method finds the triangles whose bounding box overlaps the box [lowX, highX] x [lowY, highY].
+    A triangle spanning several cells is stored in each of them, so it is only reported from the first cell,
+    counted from the lower left, which both its box and the query box cover. Every triangle is therefore
+    visited exactly once without marking anything, and the grid is only read.
+*/
+template<typename T>
+void TriangleGrid::visitCandidates(float lowX, float lowY, float highX, float highY, T visit)
+{
+    if (isEmpty() || !(lowX <= coveredMaxX && lowY <= coveredMaxY && highX >= coveredMinX && highY >= coveredMinY)) // Away from every triangle (the negated form also rejects NaN).
+    {
+        return;
+    }
+    int firstColumn(columnOf(lowX)), lastColumn(columnOf(highX)), firstRow(rowOf(lowY)), lastRow(rowOf(highY));
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            int cell(row * columns + column);
+            for (int k = cellStart[cell]; k < cellStart[cell] + cellCount[cell]; ++k)
+            {
+                int slot(cellTriangles[k]);
+                const float *box(&boxes[4 * slot]);
+                if (box[0] <= highX && box[1] <= highY && box[2] >= lowX && box[3] >= lowY && column == std::max(columnOf(box[0]), firstColumn) && row == std::max(rowOf(box[1]), firstRow))
+                {
+                    visit(slot);
+                }
+            }
+        }
+    }
+}
+
+/*
+    The following method runs through the cells covered by the stored box of the triangle at slot.
+*/
+template<typename T>
+void TriangleGrid::visitCells(int slot, T visit)
+{
+    const float *box(&boxes[4 * slot]);
+    int firstColumn(columnOf(box[0])), lastColumn(columnOf(box[2])), firstRow(rowOf(box[1])), lastRow(rowOf(box[3]));
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            visit(row * columns + column);
+        }
+    }
+}
+
+#endif
@@ -1,99 +1,632 @@
 #include "Triangulation.h"
+#include <chrono> // Timing the fast loader.
+#include <cstring> // Copying the header of a binary mesh file.
+#include <charconv> // std::to_chars for the text writer.
 
 /*
     The following method checks whether a given newPoint lies within any triangles. There are two inputs.
     First of which is the point in question. The second is the container in which the triangles which contain
     that point will be pushed onto. Since only a few triangles are expected to have the point, no reserve is
-    done on the container.
+    done on the container. Instead of testing every triangle, the grid is used to find the handful of triangles
+    whose bounding box covers the point. The grid is built on the first call. The triangles are returned in the
+    same order as they appear in the container.
 */
 void Triangulation::isPointInAnyTriangle(Vertex &newPoint, std::vector<Triangle*> &inTriangles)
 {
-    std::vector<Triangle*>::iterator it; // Iterator to access the container elements.
+    MetricsTimer timer(Metrics::POINT_IN_TRIANGLE_LATENCY, Metrics::SAMPLE_PERIOD);
+    if (!isGridValid) // Build the grid lazily on the first query.
+    {
+        myGrid.build(myPacked);
+        isGridValid = true;
+    }
+    bindObjects(); // The triangles found are returned as objects.
+
+    float *x(myPacked.getX()), *y(myPacked.getY()); // The coordinates are read from the flat arrays.
+    int count; // Number of candidates in the cell of the point.
+    const int *candidates = myGrid.getCandidates(newPoint[0], newPoint[1], count);
+    Metrics::add(Metrics::GRID_CANDIDATES, count);
+    const int blockSize(64); // Candidates are gathered into small blocks and tested together with the batch kernel.
+    float ax[blockSize], ay[blockSize], bx[blockSize], by[blockSize], cx[blockSize], cy[blockSize];
+    unsigned char inside[blockSize];
+    for (int begin = 0; begin < count; begin += blockSize) // Browse through the candidates only.
+    {
+        int size(std::min(blockSize, count - begin));
+        for (int i = 0; i < size; ++i) // Copy the corners of the candidates next to each other.
+        {
+            int *cell(myPacked.getCell(candidates[begin + i]));
+            ax[i] = x[cell[0]];
+            ay[i] = y[cell[0]];
+            bx[i] = x[cell[1]];
+            by[i] = y[cell[1]];
+            cx[i] = x[cell[2]];
+            cy[i] = y[cell[2]];
+        }
+        BatchKernels::pointInTriangles(newPoint[0], newPoint[1], ax, ay, bx, by, cx, cy, size, inside); // Check if the point lies inside the triangles.
+        for (int i = 0; i < size; ++i)
+        {
+            if (inside[i])
+            {
+                inTriangles.push_back(myTriangles[candidates[begin + i]]); // If it does, go ahead and push it onto the return container.
+            }
+        }
+    }
+}
+
+/*
+    The following method finds the triangle containing newPoint by walking through the mesh instead of
+    testing every triangle. The walk starts from the triangle with ID hint, or from the result of the
+    previous call when no hint is given, so a stream of nearby points only needs a few steps per query.
+    If the walk cannot reach the point, for example because the mesh has holes or is not convex, the
+    grid is used instead. The return value is the ID of the containing triangle or -1 if there is none.
+*/
+long long Triangulation::locate(Vertex &newPoint, long long hint)
+{
+    int found(locatePosition(newPoint[0], newPoint[1], hint == -1 ? -1 : myTriangleIndex.find(hint)));
+    return found == -1 ? -1 : myPacked.getCellId(found);
+}
+
+/*
+    The following method does the work of locate() on positions instead of IDs, so that insertVertex() can use
+    it without going through the ID index.
+*/
+int Triangulation::locatePosition(float x, float y, int start)
+{
+    MetricsTimer timer(Metrics::LOCATE_LATENCY, Metrics::SAMPLE_PERIOD);
+    Metrics::add(Metrics::LOCATE_CALLS);
+    if (myPacked.getNumberOfCells() == 0) // Nothing to search.
+    {
+        return -1;
+    }
+
+    if (start < 0 || start >= myPacked.getNumberOfCells()) // Without a hint start from the previous result.
+    {
+        start = myLastLocated;
+    }
+    if (start < 0 || start >= myPacked.getNumberOfCells()) // No usable starting point, for example on the first call.
+    {
+        start = 0;
+    }
+
+    int found(walk(x, y, start, myWalkSeed));
+    if (found == -1) // The walk failed, fall back onto the grid.
+    {
+        Metrics::add(Metrics::LOCATE_FALLBACKS);
+        if (!isGridValid)
+        {
+            myGrid.build(myPacked);
+            isGridValid = true;
+        }
+        found = locateInGrid(x, y);
+        if (found == -1) // The point is outside the mesh. Keep the old hint.
+        {
+            return -1;
+        }
+    }
+    myLastLocated = found; // Remember the result as the start of the next walk.
+    return found;
+}
+
+/*
+    The following method performs a remembering stochastic visibility walk towards the point (x, y). In each
+    triangle the edges are checked in a random order, skipping the edge the walk just came through, and the walk
+    crosses the first edge which has the point strictly on its other side. When no such edge exists the point is
+    inside (or on the boundary of) the current triangle. The orientation tests are exact (see Predicates).
+    The seed is passed in by the caller so that concurrent walks do not share state. The return value is the
+    position of the triangle, or -1 if the walk steps outside the mesh, meets a degenerate triangle or takes
+    too long. The number of triangles visited goes to the LOCATE_VISITED histogram.
+*/
+int Triangulation::walk(float x, float y, int start, unsigned int &seed)
+{
+    int current(start), previous(-1), found(-1), step(0);
+    int maximumSteps(myPacked.getNumberOfCells() + 3); // A walk can never need to visit more triangles than there are.
+    for (; step < maximumSteps; ++step)
+    {
+        int *cell(myPacked.getCell(current)), *neighbours(myPacked.getNeighbours(current));
+        double px[3], py[3]; // Vertex coordinates of the current triangle.
+        for (int i = 0; i < 3; ++i)
+        {
+            px[i] = myPacked.getX()[cell[i]];
+            py[i] = myPacked.getY()[cell[i]];
+        }
+        double area(Predicates::orientation(px[0], py[0], px[1], py[1], px[2], py[2])); // The sign gives the orientation of the triangle.
+        if (area == 0) // Cannot decide sides in a degenerate triangle.
+        {
+            break;
+        }
+
+        seed ^= seed << 13; // Xorshift step for choosing the first edge to check.
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int first(seed % 3);
+        bool isOutside(false); // Set if an edge with the point behind it is found.
+        int next(-1); // Triangle across that edge.
+        for (int e = 0; e < 3; ++e)
+        {
+            int i((first + e) % 3); // Edge i runs from vertex i + 1 to vertex i + 2.
+            int neighbour(neighbours[i]);
+            if (neighbour == previous && previous != -1) // Remembering: the point cannot be behind the edge just crossed.
+            {
+                continue;
+            }
+            int a((i + 1) % 3), b((i + 2) % 3);
+            double side(Predicates::orientation(px[a], py[a], px[b], py[b], x, y)); // Same orientation as the triangle means the point is on the inner side.
+            if ((area > 0 && side < 0) || (area < 0 && side > 0)) // Strictly on the outer side of this edge.
+            {
+                isOutside = true;
+                next = neighbour;
+                break;
+            }
+        }
+
+        if (!isOutside) // The point is on the inner side of all edges.
+        {
+            found = current;
+            break;
+        }
+        if (next == -1) // The point is beyond a boundary edge.
+        {
+            break;
+        }
+        previous = current;
+        current = next;
+    }
+    Metrics::record(Metrics::LOCATE_VISITED, std::min(step + 1, maximumSteps));
+    return found;
+}
+
+/*
+    The following method locates many points at once. The ID of the triangle containing the point (x[i], y[i])
+    is written to triangles[i], or -1 if the point is outside the mesh; the output array must hold count entries.
+    The answer is the first triangle isPointInAnyTriangle() would return, so it does not depend on the number of
+    threads. The queries are first ordered along a Z-order curve so that consecutive queries look at the same
+    part of the grid, then handed out in blocks to numberOfThreads threads (0 uses every core) which steal
+    blocks from each other when they run out. The mesh must not be changed while this runs.
+*/
+void Triangulation::locate(const float *x, const float *y, int count, long long *triangles, int numberOfThreads)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    if (!isGridValid) // Build the grid up front, the threads only read it.
+    {
+        myGrid.build(myPacked);
+        isGridValid = true;
+    }
+
+    // Bounding box of the queries, used to map them onto a 256 x 256 raster along the curve.
+    float minX(0.0f), minY(0.0f), maxX(0.0f), maxY(0.0f);
+    bool isFirst(true);
+    for (int i = 0; i < count; ++i)
+    {
+        if (!(x[i] == x[i] && y[i] == y[i])) // Skip NaN coordinates.
+        {
+            continue;
+        }
+        if (isFirst)
+        {
+            minX = maxX = x[i];
+            minY = maxY = y[i];
+            isFirst = false;
+        }
+        minX = std::min(minX, x[i]);
+        maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]);
+        maxY = std::max(maxY, y[i]);
+    }
+    float scaleX(maxX > minX ? 255.99f / (maxX - minX) : 0.0f), scaleY(maxY > minY ? 255.99f / (maxY - minY) : 0.0f);
+
+    // Counting sort of the queries by their position on the curve.
+    const int numberOfKeys(1 << 16);
+    std::vector<unsigned short> keys(count);
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            float column((x[i] - minX) * scaleX), row((y[i] - minY) * scaleY);
+            if (!(column >= 0.0f && row >= 0.0f && column < 256.0f && row < 256.0f)) // NaN or infinite.
+            {
+                keys[i] = 0;
+                continue;
+            }
+            keys[i] = mortonKey((unsigned int)column, (unsigned int)row);
+        }
+    });
+    std::vector<int> start(numberOfKeys + 1, 0), order(count);
+    for (int i = 0; i < count; ++i)
+    {
+        start[keys[i] + 1]++;
+    }
+    for (int k = 0; k < numberOfKeys; ++k)
+    {
+        start[k + 1] += start[k];
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        order[start[keys[i]]++] = i;
+    }
+
+    parallelForDynamic(0, count, numberOfThreads, 1024, [&](int begin, int end, int)
+    {
+        for (int k = begin; k < end; ++k)
+        {
+            int i(order[k]);
+            int slot(locateInGrid(x[i], y[i]));
+            triangles[i] = slot == -1 ? -1 : myPacked.getCellId(slot);
+        }
+    });
+}
+
+/*
+    The following method returns the position of the first triangle in the grid containing (x, y), or -1. It
+    does the same test as isPointInAnyTriangle() but stops at the first hit and does not change any state, so
+    several threads can call it at once once the grid is built.
+*/
+int Triangulation::locateInGrid(float x, float y)
+{
+    float *px(myPacked.getX()), *py(myPacked.getY());
+    int count;
+    const int *candidates = myGrid.getCandidates(x, y, count);
+    Metrics::add(Metrics::GRID_CANDIDATES, count);
+    const int blockSize(16);
+    float ax[blockSize], ay[blockSize], bx[blockSize], by[blockSize], cx[blockSize], cy[blockSize];
+    unsigned char inside[blockSize];
+    for (int begin = 0; begin < count; begin += blockSize)
+    {
+        int size(std::min(blockSize, count - begin));
+        for (int i = 0; i < size; ++i)
+        {
+            int *cell(myPacked.getCell(candidates[begin + i]));
+            ax[i] = px[cell[0]];
+            ay[i] = py[cell[0]];
+            bx[i] = px[cell[1]];
+            by[i] = py[cell[1]];
+            cx[i] = px[cell[2]];
+            cy[i] = py[cell[2]];
+        }
+        BatchKernels::pointInTriangles(x, y, ax, ay, bx, by, cx, cy, size, inside);
+        for (int i = 0; i < size; ++i)
+        {
+            if (inside[i])
+            {
+                return candidates[begin + i];
+            }
+        }
+    }
+    return -1;
+}
+
+/*
+    Interleaves the bits of column and row, giving the position of the raster cell along a Z-order curve.
+    Cells close on the curve are close in the plane.
+*/
+unsigned int Triangulation::mortonKey(unsigned int column, unsigned int row)
+{
+    unsigned int key(0);
+    for (int bit = 0; bit < 16; ++bit)
+    {
+        key |= ((column >> bit) & 1u) << (2 * bit);
+        key |= ((row >> bit) & 1u) << (2 * bit + 1);
+    }
+    return key;
+}
+
+/*
+    The following methods answer nearest vertex queries with the vertex tree, which is built by the first query
+    and brought up to date with the vertices added since the previous one. The results are IDs; equally distant
+    vertices come in the order of their positions.
+*/
+long long Triangulation::nearestVertex(float x, float y)
+{
+    myVertexTree.update(myPacked);
+    int position(myVertexTree.nearest(x, y));
+    return position == -1 ? -1 : myPacked.getPointId(position);
+}
+
+void Triangulation::nearestVertices(float x, float y, int k, std::vector<long long> &ids)
+{
+    myVertexTree.update(myPacked);
+    std::vector<int> positions;
+    myVertexTree.nearest(x, y, k, positions);
+    ids.resize(positions.size());
+    for (int i = 0; i < (int)positions.size(); ++i)
+    {
+        ids[i] = myPacked.getPointId(positions[i]);
+    }
+}
+
+void Triangulation::verticesWithin(float x, float y, float radius, std::vector<long long> &ids)
+{
+    myVertexTree.update(myPacked);
+    std::vector<int> positions;
+    myVertexTree.within(x, y, radius, positions);
+    ids.resize(positions.size());
+    for (int i = 0; i < (int)positions.size(); ++i)
+    {
+        ids[i] = myPacked.getPointId(positions[i]);
+    }
+}
 
-    for (it = myTriangles.begin(); it != myTriangles.end(); ++it) // Browse through all elements.
+/*
+    The following methods are the batch versions of the queries above. The tree is updated up front and the
+    queries are then split over numberOfThreads threads (0 uses every core), which only read it.
+*/
+void Triangulation::nearestVertex(const float *x, const float *y, int count, long long *ids, int numberOfThreads)
+{
+    myVertexTree.update(myPacked);
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int)
     {
-        if ((**it).isPointInTriangle(newPoint, myPoints)) // Check if the point lies inside the triangle.
+        for (int i = begin; i < end; ++i)
         {
-            inTriangles.push_back(&(**it)); // If it does, go ahead and push it onto the return container.
+            int position(myVertexTree.nearest(x[i], y[i]));
+            ids[i] = position == -1 ? -1 : myPacked.getPointId(position);
         }
+    });
+}
+
+void Triangulation::nearestVertices(const float *x, const float *y, int count, int k, long long *ids, int numberOfThreads)
+{
+    if (k <= 0)
+    {
+        return;
     }
+    myVertexTree.update(myPacked);
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int)
+    {
+        std::vector<int> positions;
+        for (int i = begin; i < end; ++i)
+        {
+            myVertexTree.nearest(x[i], y[i], k, positions);
+            for (int j = 0; j < k; ++j)
+            {
+                ids[(std::size_t)i * k + j] = j < (int)positions.size() ? myPacked.getPointId(positions[j]) : -1;
+            }
+        }
+    });
+}
+
+void Triangulation::verticesWithin(const float *x, const float *y, int count, float radius, std::vector<std::vector<long long> > &ids, int numberOfThreads)
+{
+    myVertexTree.update(myPacked);
+    ids.resize(std::max(count, 0));
+    parallelFor(0, count, numberOfThreads, [&](int begin, int end, int)
+    {
+        std::vector<int> positions;
+        for (int i = begin; i < end; ++i)
+        {
+            myVertexTree.within(x[i], y[i], radius, positions);
+            ids[i].resize(positions.size());
+            for (int j = 0; j < (int)positions.size(); ++j)
+            {
+                ids[i][j] = myPacked.getPointId(positions[j]);
+            }
+        }
+    });
+}
+
+void Triangulation::trianglesInBox(float lowX, float lowY, float highX, float highY, std::vector<long long> &ids)
+{
+    ids.clear();
+    visitTrianglesInBox(lowX, lowY, highX, highY, [&ids](long long id)
+    {
+        ids.push_back(id);
+    });
+}
+
+void Triangulation::trianglesInPolygon(const float *x, const float *y, int count, std::vector<long long> &ids)
+{
+    ids.clear();
+    visitTrianglesInPolygon(x, y, count, [&ids](long long id)
+    {
+        ids.push_back(id);
+    });
 }
 
 /*
-    The following method is used to find the circumcentre of the triangle with the provided ID.
-    The coordinates are stored in the Triangle's object itself. The mathematics applied here is
-    taken from the appendix of the specifications.
+    The following method finds out how the triangle at position slot lies relative to a polygon. If no edge of the
+    polygon meets an edge of the triangle, the two boundaries are apart, so either one contains the other or they
+    are disjoint, which a single corner of each decides: a corner of the triangle is tested against the polygon
+    by its winding number and a corner of the polygon against the triangle. All tests use the exact orientation
+    predicate, so a triangle which only touches the polygon is still found.
 */
-void Triangulation::calculateCircumcentreOf(int id)
+Triangulation::Overlap Triangulation::overlapWith(int slot, const float *x, const float *y, int count)
 {
-    (*myTriangles.at(id)).calculateCircumcentre(myPoints);
+    float *px(myPacked.getX()), *py(myPacked.getY());
+    int *cell(myPacked.getCell(slot));
+    double tx[3] = {px[cell[0]], px[cell[1]], px[cell[2]]}, ty[3] = {py[cell[0]], py[cell[1]], py[cell[2]]};
+    double lowX(std::min(tx[0], std::min(tx[1], tx[2]))), highX(std::max(tx[0], std::max(tx[1], tx[2])));
+    double lowY(std::min(ty[0], std::min(ty[1], ty[2]))), highY(std::max(ty[0], std::max(ty[1], ty[2])));
+    int winding(0); // Winding number of the polygon around the first corner of the triangle.
+    for (int i = 0; i < count; ++i)
+    {
+        int next(i + 1 < count ? i + 1 : 0);
+        double ax(x[i]), ay(y[i]), bx(x[next]), by(y[next]);
+        if (std::max(ax, bx) >= lowX && std::min(ax, bx) <= highX && std::max(ay, by) >= lowY && std::min(ay, by) <= highY) // Only edges overlapping the box of the triangle can meet it.
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                if (segmentsIntersect(ax, ay, bx, by, tx[k], ty[k], tx[(k + 1) % 3], ty[(k + 1) % 3]))
+                {
+                    return PARTIAL;
+                }
+            }
+        }
+        if (ay <= ty[0])
+        {
+            if (by > ty[0] && Predicates::orientation(ax, ay, bx, by, tx[0], ty[0]) > 0) // Upward edge with the corner on its left.
+            {
+                ++winding;
+            }
+        }
+        else if (by <= ty[0] && Predicates::orientation(ax, ay, bx, by, tx[0], ty[0]) < 0) // Downward edge with the corner on its right.
+        {
+            --winding;
+        }
+    }
+    if (winding != 0)
+    {
+        return INSIDE;
+    }
+    double side(Predicates::orientation(tx[0], ty[0], tx[1], ty[1], tx[2], ty[2]));
+    if (count > 0 && side != 0)
+    {
+        bool isInside(true);
+        for (int k = 0; k < 3; ++k)
+        {
+            double edge(Predicates::orientation(tx[k], ty[k], tx[(k + 1) % 3], ty[(k + 1) % 3], x[0], y[0]));
+            isInside = isInside && (side > 0 ? edge >= 0 : edge <= 0);
+        }
+        if (isInside) // The polygon lies within the triangle.
+        {
+            return PARTIAL;
+        }
+    }
+    return OUTSIDE;
 }
 
 /*
-    The following method is used to calculate the area of the triangle with the given ID. The result
-    is stored within that triangle's object.
+    The following method clips the polygon to the triangle at position slot with the Sutherland-Hodgman algorithm:
+    the polygon is cut by the line through each edge of the triangle in turn, keeping the part on the inner side.
+    The corners of the result go to clipX and clipY in the direction of the polygon.
 */
-void Triangulation::calculateAreaOf(int id)
+int Triangulation::clipToTriangle(int slot, const float *x, const float *y, int count, std::vector<double> &clipX, std::vector<double> &clipY)
 {
-    (*myTriangles.at(id)).calculateArea(myPoints);
+    float *px(myPacked.getX()), *py(myPacked.getY());
+    int *cell(myPacked.getCell(slot));
+    double tx[3] = {px[cell[0]], px[cell[1]], px[cell[2]]}, ty[3] = {py[cell[0]], py[cell[1]], py[cell[2]]};
+    double direction((tx[1] - tx[0]) * (ty[2] - ty[0]) - (tx[2] - tx[0]) * (ty[1] - ty[0]) > 0 ? 1.0 : -1.0); // Makes the inner side positive.
+    clipX.assign(x, x + count);
+    clipY.assign(y, y + count);
+    std::vector<double> nextX, nextY;
+    for (int k = 0; k < 3 && !clipX.empty(); ++k)
+    {
+        double ax(tx[k]), ay(ty[k]), bx(tx[(k + 1) % 3]), by(ty[(k + 1) % 3]);
+        nextX.clear();
+        nextY.clear();
+        int size(clipX.size());
+        for (int i = 0; i < size; ++i)
+        {
+            int previous(i > 0 ? i - 1 : size - 1);
+            double here(direction * ((bx - ax) * (clipY[i] - ay) - (by - ay) * (clipX[i] - ax)));
+            double before(direction * ((bx - ax) * (clipY[previous] - ay) - (by - ay) * (clipX[previous] - ax)));
+            if ((here >= 0) != (before >= 0)) // The edge from the previous corner crosses the line.
+            {
+                double t(before / (before - here));
+                nextX.push_back(clipX[previous] + t * (clipX[i] - clipX[previous]));
+                nextY.push_back(clipY[previous] + t * (clipY[i] - clipY[previous]));
+            }
+            if (here >= 0)
+            {
+                nextX.push_back(clipX[i]);
+                nextY.push_back(clipY[i]);
+            }
+        }
+        clipX.swap(nextX);
+        clipY.swap(nextY);
+    }
+    return clipX.size();
+}
+
+bool Triangulation::segmentsIntersect(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+    double c(Predicates::orientation(ax, ay, bx, by, cx, cy)), d(Predicates::orientation(ax, ay, bx, by, dx, dy));
+    double a(Predicates::orientation(cx, cy, dx, dy, ax, ay)), b(Predicates::orientation(cx, cy, dx, dy, bx, by));
+    if (((c > 0 && d < 0) || (c < 0 && d > 0)) && ((a > 0 && b < 0) || (a < 0 && b > 0))) // Proper crossing.
+    {
+        return true;
+    }
+    // Otherwise they only meet where an end point lies on the other segment, which it does if it is on the line
+    // through that segment and within its box.
+    return (c == 0 && cx >= std::min(ax, bx) && cx <= std::max(ax, bx) && cy >= std::min(ay, by) && cy <= std::max(ay, by))
+        || (d == 0 && dx >= std::min(ax, bx) && dx <= std::max(ax, bx) && dy >= std::min(ay, by) && dy <= std::max(ay, by))
+        || (a == 0 && ax >= std::min(cx, dx) && ax <= std::max(cx, dx) && ay >= std::min(cy, dy) && ay <= std::max(cy, dy))
+        || (b == 0 && bx >= std::min(cx, dx) && bx <= std::max(cx, dx) && by >= std::min(cy, dy) && by <= std::max(cy, dy));
 }
 
 /*
     The following method is used to calculate whether a new point is within the circumcircle of any
     old triangles. This is useful when deploying DT. The inputs are the newPoint and a container where the
     output will be placed. The output will be the triangles whose circumcircle has the point. The reason
-    why the triangles are returned is so that they can be modified when deploying DT.
+    why the triangles are returned is so that they can be modified when deploying DT. The test is the exact
+    in-circle test on the vertices, so a point is never put on the wrong side of a circle by rounding.
+    The number of triangles found is counted in the CIRCUMCIRCLE_HITS metric.
 */
 void Triangulation::isPointInCircumcircle(Vertex &newPoint, std::vector<Triangle*> &inTriangles)
 {
-    for (std::vector<Triangle*>::iterator it = myTriangles.begin(); it != myTriangles.end(); ++it) // Loop to go through each triangle.
+    MetricsTimer timer(Metrics::CIRCUMCIRCLE_LATENCY);
+    Metrics::add(Metrics::CIRCUMCIRCLE_QUERIES);
+    bindObjects(); // The triangles found are returned as objects.
+    std::size_t oldSize(inTriangles.size());
+    float *x(myPacked.getX()), *y(myPacked.getY());
+    const int blockSize(256); // The circles are tested a block at a time with the batch kernel.
+    float ax[blockSize], ay[blockSize], bx[blockSize], by[blockSize], cx[blockSize], cy[blockSize];
+    unsigned char inside[blockSize];
+    for (int j = 0; j < myPacked.getNumberOfCells(); ++j) // Loop to go through each triangle.
     {
-        calculateCircumcentreOf((**it).getId()); // Calculate the circumcentre before beginning checks.
-        if ((**it).isPointInCircumcircle(newPoint)) // Call the function which checks if a point is in the circumcentre.
+        if (j % blockSize == 0) // Test the next block.
+        {
+            int size(std::min(blockSize, myPacked.getNumberOfCells() - j));
+            gatherCorners(j, size, ax, ay, bx, by, cx, cy);
+            BatchKernels::pointInCircumcircles(newPoint[0], newPoint[1], ax, ay, bx, by, cx, cy, size, inside);
+        }
+        if (inside[j % blockSize])
         {
             // The if-else below is to skip the point if it actually belongs to the triangle.
-            if ((*myPoints.at((**it)[0]))[0] == newPoint[0] && (*myPoints.at((**it)[0]))[1] == newPoint[1])
+            int *cell(myPacked.getCell(j));
+            if (x[cell[0]] == newPoint[0] && y[cell[0]] == newPoint[1])
             {
                 continue;
             }
-            else if ((*myPoints.at((**it)[1]))[0] == newPoint[0] && (*myPoints.at((**it)[1]))[1] == newPoint[1])
+            else if (x[cell[1]] == newPoint[0] && y[cell[1]] == newPoint[1])
             {
                 continue;
             }
-            else if ((*myPoints.at((**it)[2]))[0] == newPoint[0] && (*myPoints.at((**it)[2]))[1] == newPoint[1])
+            else if (x[cell[2]] == newPoint[0] && y[cell[2]] == newPoint[1])
             {
                 continue;
             }
-            std::cout << "Point id: " << newPoint.getId() << " In triangle id: " << (**it).getId() << "\n"; // Used for checking points which lie inside the circumcircle.
-            inTriangles.push_back(&(**it)); // Store the triangle in the container if it meets the criteria.
+            inTriangles.push_back(myTriangles[j]); // Store the triangle in the container if it meets the criteria.
         }
     }
+    Metrics::add(Metrics::CIRCUMCIRCLE_HITS, inTriangles.size() - oldSize);
 }
 
 /*
     The following method is used to verify whether an existing point in the mesh
     is in the circumcircle of any triangle. Used for the Delaunay check. Input is the
-    point whereas the output will be a true/false.
+    point whereas the output will be a true/false. The triangles found are counted in the CIRCUMCIRCLE_HITS metric.
 */
 bool Triangulation::isOldPointInCircumcircle(Vertex &oldPoint)
 {
-    int counter(0); // Initialise the counter to zero. Only for debugging.
-    for (std::vector<Triangle*>::iterator it = myTriangles.begin(); it != myTriangles.end(); ++it) // Iterate through each triangle.
+    MetricsTimer timer(Metrics::CIRCUMCIRCLE_LATENCY);
+    Metrics::add(Metrics::CIRCUMCIRCLE_QUERIES);
+    int counter(0); // Number of circumcircles containing the point.
+    int vertex(myPointIndex.find(oldPoint.getId())); // Position of the point, as the triangles refer to it.
+    const int blockSize(256); // The circles are tested a block at a time with the batch kernel.
+    float ax[blockSize], ay[blockSize], bx[blockSize], by[blockSize], cx[blockSize], cy[blockSize];
+    unsigned char inside[blockSize];
+    for (int j = 0; j < myPacked.getNumberOfCells(); ++j) // Iterate through each triangle.
     {
-        // Since this point is an existing point, it has an ID which we can use to filter the result if the point belongs to the triangle.
-        if (oldPoint.getId() == (**it)[0] || oldPoint.getId() == (**it)[1] || oldPoint.getId() == (**it)[2])
+        if (j % blockSize == 0) // Test the next block.
+        {
+            int size(std::min(blockSize, myPacked.getNumberOfCells() - j));
+            gatherCorners(j, size, ax, ay, bx, by, cx, cy);
+            BatchKernels::pointInCircumcircles(oldPoint[0], oldPoint[1], ax, ay, bx, by, cx, cy, size, inside);
+        }
+        // Since this point is an existing point, it has a position which we can use to filter the result if the point belongs to the triangle.
+        int *cell(myPacked.getCell(j));
+        if (vertex == cell[0] || vertex == cell[1] || vertex == cell[2])
         {
             continue; // Skip if it is a vertex of the triangle.
         }
-        calculateCircumcentreOf((**it).getId()); // Otherwise, calculate the circumcentre.
-        if ((**it).isPointInCircumcircle(oldPoint)) // Check if the point is in the circumcircle.
+        if (inside[j % blockSize]) // Check if the point is in the circumcircle.
         {
-            std::cout << "Point id: " << oldPoint.getId() << " In triangle id: " << (**it).getId() << "\n"; // Used for debugging.
             counter++; // Counts the number of times when the point was in the circumcircle of a triangle.
             //return true; // If we want to stop once we find one point, we can simply return from here.
         }
     }
 
+    Metrics::add(Metrics::CIRCUMCIRCLE_HITS, counter);
     if (counter != 0) // If the debugging is used, then we return true if counter is not 0 otherwise remove this if-statement.
     {
         return true;
@@ -101,57 +634,1478 @@ bool Triangulation::isOldPointInCircumcircle(Vertex &oldPoint)
     return false;
 }
 
+/*
+    The following method copies the corners of the triangles at positions [first, first + count) into the given
+    arrays, next to each other as the batch kernels want them.
+*/
+void Triangulation::gatherCorners(int first, int count, float *ax, float *ay, float *bx, float *by, float *cx, float *cy)
+{
+    float *x(myPacked.getX()), *y(myPacked.getY());
+    for (int i = 0; i < count; ++i)
+    {
+        int *cell(myPacked.getCell(first + i));
+        ax[i] = x[cell[0]];
+        ay[i] = y[cell[0]];
+        bx[i] = x[cell[1]];
+        by[i] = y[cell[1]];
+        cx[i] = x[cell[2]];
+        cy[i] = y[cell[2]];
+    }
+}
+
 /*
     The following method checks whether the mesh data in this Triangulation
     object follows DT or no. It has no inputs as it assumes data is fed into
-    the object already. The output is a true/false.
+    the object already. The output is a true/false. The check is done edge by
+    edge with checkDelaunay() and stops at the first violation found.
+*/
+bool Triangulation::isDelaunay(int numberOfThreads)
+{
+    return checkDelaunay(NULL, numberOfThreads);
+}
+
+/*
+    The following method checks the Delaunay condition locally on every interior edge: the vertex of the
+    neighbouring triangle opposite the edge must not lie strictly inside the circumcircle of the triangle.
+    For a valid triangulation this is equivalent to the global empty-circle property but it only needs one
+    test per edge instead of one per point and triangle. The triangles are split between numberOfThreads
+    threads (0 uses every core). If violations is NULL the check stops as soon as any thread finds a violation,
+    otherwise all violating edges are reported as (triangle ID, edge index) pairs ordered by triangle.
+    The output is true if the mesh is Delaunay.
 */
-bool Triangulation::isDelaunay()
+bool Triangulation::checkDelaunay(std::vector<std::pair<long long, int> > *violations, int numberOfThreads)
 {
-    int counter(0); // Initialise counter to zero.
-    for (std::vector<Vertex*>::iterator it = myPoints.begin(); it != myPoints.end(); ++it) // Iterate through each point.
+    if (violations == NULL)
     {
-        // We check if any of the points is inside the circumcircle of a triangle.
-        if (isOldPointInCircumcircle((**it))) // Check if it lies in the circumcircle of any triangle.
-        {
-            counter++; // Keep a track of the number of times it was inside the circumcircle.
-            //return false; // If not debugging, we can simply return false at the first piece of evidence we find that it is not DT.
-        }
+        return findViolations(NULL, numberOfThreads);
     }
-    if (counter != 0)
+    std::vector<std::pair<int, int> > found;
+    bool isValid(findViolations(&found, numberOfThreads));
+    for (std::size_t k = 0; k < found.size(); ++k) // Report the triangles by ID.
     {
-        return false; // Return false as long as counter is more than 0.
+        violations->push_back(std::make_pair(myPacked.getCellId(found[k].first), found[k].second));
     }
-    return true;
+    return isValid;
 }
 
 /*
-    The following method adds a new vertex to the container with the provided
-    data. The ID of the vertex is simply an increment of the ID of the last vertex in the container.
-    It is also important to update the number of points to make it consistent.
+    The following method does the check of checkDelaunay(), reporting the violating edges by the position of
+    their triangle.
 */
-void Triangulation::addNewVertex(float &x, float &y, float &z)
+bool Triangulation::findViolations(std::vector<std::pair<int, int> > *violations, int numberOfThreads)
 {
-    Vertex *pointToAdd = new Vertex(); // dynamically allocate a new Vertex object.
-    // Set the coordinates:
-    (*pointToAdd)[0] = x;
-    (*pointToAdd)[1] = y;
-    (*pointToAdd)[2] = z;
-    pointToAdd->setId((*myPoints.back()).getId() + 1); // Calculate and set the new ID based on the old one.
-    numberOfPoints++; // Increment the total number of points.
-    myPoints.push_back(pointToAdd); // Push back into the container.
+    MetricsTimer timer(Metrics::DELAUNAY_CHECK_LATENCY);
+    return MeshAlgorithms::findViolations(getPackedView(), myPacked.getNumberOfCells(), violations, numberOfThreads);
 }
 
 /*
-    The following method is used to add a new triangle. Similar to the above, the
-    ID of the triangle is an increment of the last triangle. We also increment the
-    number of triangles.
+    The following method turns the mesh into a Delaunay mesh in place with Lawson's edge flipping. The edges
+    which violate the Delaunay condition are found like checkDelaunay() does and put on a work queue. Each of them is
+    flipped to the other diagonal of its quadrilateral and the four outer edges of that quadrilateral are queued
+    again since they may have become illegal. When only a small part of the mesh is not Delaunay, only that part is
+    worked on. A flip keeps the positions and IDs of its two triangles and thereby their attributes.
+    The output is the number of flips performed.
 */
-void Triangulation::addNewTriangle(int &v0, int &v1, int &v2)
+int Triangulation::makeDelaunay()
 {
-    Triangle *triangleToAdd = new Triangle(v0, v1, v2, numberOfAttributesPerCell); // Allocate memory for a new Triangle.
-    triangleToAdd->setId((*myTriangles.back()).getId() + 1); // Calculate and set the new ID.
-    numberOfCells++; // Increment the number of cells.
-    myTriangles.push_back(triangleToAdd); // Add the triangle to the container.
+    std::vector<std::pair<int, int> > queue; // Edges to check, as (triangle position, edge index).
+    findViolations(&queue, 0); // Start with the edges which are known to be illegal.
+
+    int flips(0);
+    long long maximumFlips(10LL * myPacked.getNumberOfCells() + 100); // Guard against cycling on broken input. Valid meshes need far fewer.
+    while (!queue.empty() && flips < maximumFlips)
+    {
+        std::pair<int, int> edge = queue.back();
+        queue.pop_back();
+        if (MeshAlgorithms::isLocallyDelaunay(getPackedView(), edge.first, edge.second)) // The edge may have been fixed by an earlier flip.
+        {
+            continue;
+        }
+        int neighbour(myPacked.getNeighbours(edge.first)[edge.second]);
+        if (!flipEdge(edge.first, edge.second)) // The quadrilateral is not convex.
+        {
+            continue;
+        }
+        flips++;
+        for (int i = 0; i < 3; ++i) // Queue the outer edges of both triangles. The shared edge is Delaunay now.
+        {
+            if (myPacked.getNeighbours(edge.first)[i] != neighbour)
+            {
+                queue.push_back(std::make_pair(edge.first, i));
+            }
+            if (myPacked.getNeighbours(neighbour)[i] != edge.first)
+            {
+                queue.push_back(std::make_pair(neighbour, i));
+            }
+        }
+    }
+
+    return flips;
+}
+
+/*
+    The following method flips the given edge of the triangle at position slot. With the triangle being (v, a, b)
+    where the edge is (a, b) and d being the far vertex of the neighbour, the two triangles become (v, a, d) and
+    (v, d, b). The first keeps the position of the triangle, the second that of the neighbour and both keep the
+    orientation of the triangle. Neighbours, incident triangles and boundary edges are updated. The return value
+    is false (and nothing is changed) if the edge is on the boundary or the quadrilateral is not strictly convex.
+*/
+bool Triangulation::flipEdge(int slot, int edge)
+{
+    Triangle triangle(&myPacked, slot);
+    int other(triangle.getNeighbour(edge));
+    if (other == -1)
+    {
+        return false;
+    }
+    Triangle neighbour(&myPacked, other);
+    int v(triangle[edge]), a(triangle[(edge + 1) % 3]), b(triangle[(edge + 2) % 3]);
+    int da(-1), db(-1), dd(-1); // Positions of a, b and the far vertex d within the neighbour.
+    for (int k = 0; k < 3; ++k)
+    {
+        if (neighbour[k] == a)
+        {
+            da = k;
+        }
+        else if (neighbour[k] == b)
+        {
+            db = k;
+        }
+        else
+        {
+            dd = k;
+        }
+    }
+    if (da == -1 || db == -1 || dd == -1) // Not a proper pair of neighbours.
+    {
+        return false;
+    }
+    int d(neighbour[dd]);
+
+    // The new triangles must have the same orientation as the old one, otherwise the quadrilateral is not convex.
+    float *x(myPacked.getX()), *y(myPacked.getY());
+    double side(Predicates::orientation(x[v], y[v], x[a], y[a], x[b], y[b]));
+    double first(Predicates::orientation(x[v], y[v], x[a], y[a], x[d], y[d])), second(Predicates::orientation(x[v], y[v], x[d], y[d], x[b], y[b]));
+    if (!((side > 0 && first > 0 && second > 0) || (side < 0 && first < 0 && second < 0)))
+    {
+        return false;
+    }
+
+    int outerVA(triangle.getNeighbour((edge + 2) % 3)), outerBV(triangle.getNeighbour((edge + 1) % 3)); // Outer neighbours of the triangle.
+    int outerAD(neighbour.getNeighbour(db)), outerDB(neighbour.getNeighbour(da)); // Outer neighbours of the neighbour.
+
+    for (int i = 0; i < 3; ++i) // The corners are linked again below with their new vertices.
+    {
+        unlinkCorner(3 * slot + i);
+        unlinkCorner(3 * other + i);
+    }
+    eraseFromGrid(slot); // Both triangles change shape and are bucketed again below.
+    eraseFromGrid(other);
+    int first3[3] = {v, a, d}, second3[3] = {v, d, b};
+    triangle.setVertices(first3); // (v, a, d): opposite v is (a, d), opposite a is (d, v), opposite d is (v, a).
+    myGeometry.markDirty(slot);
+    triangle.setNeighbour(0, outerAD);
+    triangle.setNeighbour(1, other);
+    triangle.setNeighbour(2, outerVA);
+    neighbour.setVertices(second3); // (v, d, b): opposite v is (d, b), opposite d is (b, v), opposite b is (v, d).
+    myGeometry.markDirty(other);
+    neighbour.setNeighbour(0, outerDB);
+    neighbour.setNeighbour(1, outerBV);
+    neighbour.setNeighbour(2, slot);
+
+    replaceNeighbour(outerAD, a, d, slot); // (a, d) moved from the neighbour to the triangle.
+    replaceNeighbour(outerBV, b, v, other); // (b, v) moved from the triangle to the neighbour.
+    for (int i = 0; i < 3; ++i)
+    {
+        linkCorner(3 * slot + i);
+        linkCorner(3 * other + i);
+    }
+    insertIntoGrid(slot);
+    insertIntoGrid(other);
+    return true;
 }
 
+/*
+    The following method makes the triangle at position outer refer to slot across its edge (v0, v1). If outer is
+    -1 the edge is on the boundary and its entry in myOpenEdges is updated instead.
+*/
+void Triangulation::replaceNeighbour(int outer, int v0, int v1, int slot)
+{
+    if (outer == -1)
+    {
+        myOpenEdges.set(MeshAlgorithms::edgeKey(v0, v1), slot);
+        return;
+    }
+    Triangle triangle(&myPacked, outer);
+    for (int k = 0; k < 3; ++k)
+    {
+        if (triangle[k] != v0 && triangle[k] != v1) // The edge is opposite the vertex not on it.
+        {
+            triangle.setNeighbour(k, slot);
+            return;
+        }
+    }
+}
+
+/*
+    The following method adds a new vertex to the mesh with the provided
+    data. The ID of the vertex is one more than the largest ID in the mesh.
+    It is also important to update the number of points to make it consistent.
+*/
+void Triangulation::addNewVertex(float &x, float &y, float &z)
+{
+    long long id(myPointIndex.getNextId()); // Calculate the new ID based on the old ones.
+    myPointIndex.insert(id, myPacked.appendPoint(x, y, z, id)); // Add the point at the end of the mesh.
+    numberOfPoints++; // Increment the total number of points.
+    myFirstCorner.push_back(-1); // No triangle uses it yet.
+}
+
+/*
+    The following method is used to add a new triangle with the vertices of the given IDs. Similar to the
+    above, the ID of the triangle is one more than the largest triangle ID. We also increment the
+    number of triangles. Returns false, adding nothing, if a vertex does not exist.
+*/
+bool Triangulation::addNewTriangle(long long v0, long long v1, long long v2)
+{
+    int p0(myPointIndex.find(v0)), p1(myPointIndex.find(v1)), p2(myPointIndex.find(v2)); // Positions of the vertices.
+    if (p0 == -1 || p1 == -1 || p2 == -1)
+    {
+        return false;
+    }
+    int slot(appendTriangle(p0, p1, p2)); // Create the triangle at the end of the mesh.
+    linkTriangle(slot); // Hook it up to the triangles it shares edges with.
+    insertIntoGrid(slot);
+    return true;
+}
+
+/*
+    The following method creates a triangle with the vertices at the given positions at the end of the mesh.
+    Its ID is one more than the largest triangle ID and its attributes are zero. The return value is the position
+    of the new triangle.
+*/
+int Triangulation::appendTriangle(int v0, int v1, int v2)
+{
+    long long id(myTriangleIndex.getNextId()); // Calculate the new ID.
+    int slot(myPacked.appendCell(v0, v1, v2, id));
+    myTriangleIndex.insert(id, slot);
+    numberOfCells++; // Increment the number of cells.
+    myNextCorner.resize(3 * (std::size_t)(slot + 1));
+    for (int i = 0; i < 3; ++i)
+    {
+        linkCorner(3 * slot + i);
+    }
+    return slot;
+}
+
+/*
+    The following method brings the Vertex and Triangle objects handed out by getMyPoints() and getMyTriangles()
+    to the number of points and triangles of the mesh. An object only refers to a position, so the existing ones
+    stay valid and only the positions added since the last call need new objects.
+*/
+void Triangulation::bindObjects()
+{
+    int points(myPacked.getNumberOfPoints()), cells(myPacked.getNumberOfCells());
+    while ((int)myPoints.size() > points) // The mesh shrank.
+    {
+        myVertexPool.release(myPoints.back());
+        myPoints.pop_back();
+    }
+    while ((int)myPoints.size() < points)
+    {
+        Vertex *vertex(myVertexPool.acquire());
+        vertex->bind(&myPacked, myPoints.size());
+        myPoints.push_back(vertex);
+    }
+    while ((int)myTriangles.size() > cells)
+    {
+        myTrianglePool.release(myTriangles.back());
+        myTriangles.pop_back();
+    }
+    while ((int)myTriangles.size() < cells)
+    {
+        Triangle *triangle(myTrianglePool.acquire());
+        triangle->bind(&myPacked, myTriangles.size());
+        myTriangles.push_back(triangle);
+    }
+}
+
+/*
+    The following method builds the topology of the mesh: for every triangle the neighbour across each of its
+    edges and for every vertex the triangles using it. Edges are matched with a hash map so the whole build is
+    linear in the number of triangles. Edges left unmatched are boundary edges and are kept in myOpenEdges.
+*/
+void Triangulation::buildAdjacency()
+{
+    myOpenEdges.clear();
+    int *neighbours(myPacked.getNeighbours(0));
+    std::fill(neighbours, neighbours + 3 * (std::size_t)myPacked.getNumberOfCells(), -1); // Forget the old topology.
+    for (int j = 0; j < myPacked.getNumberOfCells(); ++j) // Connect each triangle to the ones seen before it.
+    {
+        linkTriangle(j);
+    }
+    linkCorners();
+}
+
+/*
+    The following method builds the ring of corners of every point from scratch. The corners are linked from
+    the last to the first, so each ring is in triangle order and the incident triangle of a point is the first
+    triangle using it. Corners referring to a point which does not exist are left out.
+*/
+void Triangulation::linkCorners()
+{
+    int points(myPacked.getNumberOfPoints());
+    myFirstCorner.assign(points, -1);
+    myNextCorner.assign(3 * (std::size_t)myPacked.getNumberOfCells(), -1);
+    for (int j = 0; j < points; ++j)
+    {
+        myPacked.setIncidentCell(j, -1);
+    }
+    int *connectivity(myPacked.getConnectivity());
+    for (int corner = (int)myNextCorner.size() - 1; corner >= 0; --corner)
+    {
+        if (connectivity[corner] >= 0 && connectivity[corner] < points)
+        {
+            linkCorner(corner);
+        }
+    }
+}
+
+/*
+    The following method puts a corner at the front of the ring of its point, which makes its triangle the
+    incident triangle of the point.
+*/
+void Triangulation::linkCorner(int corner)
+{
+    int vertex(myPacked.getConnectivity()[corner]);
+    myNextCorner[corner] = myFirstCorner[vertex];
+    myFirstCorner[vertex] = corner;
+    myPacked.setIncidentCell(vertex, corner / 3);
+}
+
+/*
+    The following method takes a corner out of the ring of its point, which has to be done before the vertex of
+    the corner changes. The ring is searched for the corner before it, which takes as many steps as the point
+    has triangles. If the corner was the first, the triangle of the next corner becomes the incident triangle.
+*/
+void Triangulation::unlinkCorner(int corner)
+{
+    int vertex(myPacked.getConnectivity()[corner]);
+    if (myFirstCorner[vertex] == corner)
+    {
+        myFirstCorner[vertex] = myNextCorner[corner];
+        myPacked.setIncidentCell(vertex, myFirstCorner[vertex] == -1 ? -1 : myFirstCorner[vertex] / 3);
+        return;
+    }
+    for (int previous = myFirstCorner[vertex]; previous != -1; previous = myNextCorner[previous])
+    {
+        if (myNextCorner[previous] == corner)
+        {
+            myNextCorner[previous] = myNextCorner[corner];
+            return;
+        }
+    }
+}
+
+/*
+    The following method connects the triangle at the given position with the triangles sharing its edges.
+    Each edge is looked up in myOpenEdges: if another triangle is waiting on it, the two become neighbours and the
+    edge is closed, otherwise the edge is left open for a triangle added later.
+*/
+void Triangulation::linkTriangle(int slot)
+{
+    MeshAlgorithms::linkCell(getPackedView(), myOpenEdges, slot);
+}
+
+/*
+    The following method inserts a new point into the mesh with the Bowyer-Watson algorithm. The triangle
+    containing the point is found with locate(), the cavity of triangles whose circumcircle contains the point
+    is grown from there through the neighbours, and the cavity is replaced by a fan of triangles connecting the
+    new point to the edges on the border of the cavity. Only the cavity is touched, so the cost depends on its
+    size and not on the size of the mesh. If the mesh was Delaunay before, it is Delaunay afterwards.
+    The positions (and IDs) of the removed triangles are reused for the new ones and the remaining new triangles
+    are appended. All new triangles take the attributes of the triangle which contained the point.
+    The return value is the ID of the new vertex, or -1 if the point lies outside the mesh or on an existing vertex.
+*/
+long long Triangulation::insertVertex(float x, float y, float z)
+{
+    MetricsTimer timer(Metrics::INSERT_LATENCY);
+    int start(locatePosition(x, y, -1)); // Triangle containing the point.
+    if (start == -1)
+    {
+        return -1;
+    }
+
+    std::vector<int> &cavity = myCavity; // Positions of the triangles to remove.
+    if (!findCavity(x, y, start, cavity))
+    {
+        return -1;
+    }
+    unsigned int inCavity(nextStamp());
+    for (std::vector<int>::iterator it = cavity.begin(); it != cavity.end(); ++it)
+    {
+        myTriangleMarks[*it] = inCavity;
+    }
+
+    // Collect the border of the cavity. Each edge keeps the direction it had in its triangle so the new triangle keeps the orientation.
+    std::vector<int> &edgeStart = myBorderStart, &edgeEnd = myBorderEnd, &edgeOuter = myBorderOuter; // Vertices of each border edge and the triangle behind it (-1 on the mesh boundary).
+    std::vector<long long> &collapsedEdges = mySplitEdges; // Boundary edges on which the point lies. They are split instead of getting a flat triangle.
+    edgeStart.clear();
+    edgeEnd.clear();
+    edgeOuter.clear();
+    collapsedEdges.clear();
+    for (std::vector<int>::iterator it = cavity.begin(); it != cavity.end(); ++it)
+    {
+        Triangle triangle(&myPacked, *it);
+        for (int i = 0; i < 3; ++i)
+        {
+            int neighbour(triangle.getNeighbour(i));
+            if (neighbour != -1 && myTriangleMarks[neighbour] == inCavity) // Interior edge of the cavity.
+            {
+                continue;
+            }
+            int a(triangle[(i + 1) % 3]), b(triangle[(i + 2) % 3]);
+            if (neighbour == -1 && Predicates::orientation(myPacked.getX()[a], myPacked.getY()[a], myPacked.getX()[b], myPacked.getY()[b], x, y) == 0) // The point is on this boundary edge.
+            {
+                collapsedEdges.push_back(MeshAlgorithms::edgeKey(a, b));
+                continue;
+            }
+            edgeStart.push_back(a);
+            edgeEnd.push_back(b);
+            edgeOuter.push_back(neighbour);
+        }
+    }
+    if (edgeStart.size() < cavity.size()) // Cannot happen for a valid cavity but every removed position has to be refilled.
+    {
+        return -1;
+    }
+
+    std::vector<float> &attributes = myFanAttributes; // Attributes for the new triangles.
+    attributes.assign(myPacked.getAttributes(start), myPacked.getAttributes(start) + numberOfAttributesPerCell);
+    for (std::vector<int>::iterator it = cavity.begin(); it != cavity.end(); ++it) // The removed triangles no longer use their vertices.
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            unlinkCorner(3 * *it + i);
+        }
+        eraseFromGrid(*it); // Their positions are bucketed again with the shape of the fan triangles.
+    }
+    addNewVertex(x, y, z); // The new point goes to the end of the mesh.
+    int p(myPacked.getNumberOfPoints() - 1);
+
+    unsigned int onBorder(nextStamp()); // myPointFrom and myPointTo give the new triangle by the first and by the second vertex of its border edge.
+    for (int e = 0; e < (int)edgeStart.size(); ++e)
+    {
+        int ends[2] = {edgeStart[e], edgeEnd[e]};
+        for (int k = 0; k < 2; ++k)
+        {
+            if (myPointMarks[ends[k]] != onBorder)
+            {
+                myPointMarks[ends[k]] = onBorder;
+                myPointFrom[ends[k]] = -1;
+                myPointTo[ends[k]] = -1;
+            }
+        }
+    }
+    std::vector<int> &slots = myFanSlots; // Position of the new triangle built on each border edge.
+    slots.resize(edgeStart.size());
+    for (int e = 0; e < (int)edgeStart.size(); ++e) // Create the fan. Vertex 0 of every new triangle is the new point, edge 0 is the border edge.
+    {
+        int slot;
+        if (e < (int)cavity.size()) // Reuse the position of a removed triangle.
+        {
+            slot = cavity[e];
+            myPacked.setCell(slot, p, edgeStart[e], edgeEnd[e]);
+            for (int i = 0; i < 3; ++i)
+            {
+                linkCorner(3 * slot + i);
+            }
+        }
+        else // Append a new triangle.
+        {
+            slot = appendTriangle(p, edgeStart[e], edgeEnd[e]);
+        }
+        insertIntoGrid(slot);
+        Triangle triangle(&myPacked, slot);
+        myGeometry.markDirty(slot); // Appended triangles are picked up by the cache anyway.
+        std::copy(attributes.begin(), attributes.end(), triangle.getAttributes());
+        triangle.setNeighbour(0, edgeOuter[e]);
+        slots[e] = slot;
+        myPointFrom[edgeStart[e]] = slot;
+        myPointTo[edgeEnd[e]] = slot;
+
+        if (edgeOuter[e] == -1) // Border edge on the mesh boundary.
+        {
+            myOpenEdges.set(MeshAlgorithms::edgeKey(edgeStart[e], edgeEnd[e]), slot);
+        }
+        else // Point the outer triangle back at the new one.
+        {
+            Triangle outer(&myPacked, edgeOuter[e]);
+            for (int k = 0; k < 3; ++k)
+            {
+                if (outer[k] != edgeStart[e] && outer[k] != edgeEnd[e])
+                {
+                    outer.setNeighbour(k, slot);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int e = 0; e < (int)edgeStart.size(); ++e) // Connect the fan triangles with each other.
+    {
+        Triangle triangle(&myPacked, slots[e]);
+        int found(myPointFrom[edgeEnd[e]]); // Edge 1 runs from the end of the border edge to the new point.
+        triangle.setNeighbour(1, found);
+        if (found == -1) // The point split a boundary edge, so this side is on the boundary now.
+        {
+            myOpenEdges.set(MeshAlgorithms::edgeKey(edgeEnd[e], p), slots[e]);
+        }
+        found = myPointTo[edgeStart[e]]; // Edge 2 runs from the new point to the start of the border edge.
+        triangle.setNeighbour(2, found);
+        if (found == -1)
+        {
+            myOpenEdges.set(MeshAlgorithms::edgeKey(p, edgeStart[e]), slots[e]);
+        }
+    }
+    for (std::vector<long long>::iterator it = collapsedEdges.begin(); it != collapsedEdges.end(); ++it) // Split boundary edges no longer exist.
+    {
+        myOpenEdges.erase(*it);
+    }
+
+    myLastLocated = slots[0]; // The next query is likely to be close to this one.
+    return myPacked.getPointId(p);
+}
+
+/*
+    The following method finds the cavity for a new point at (x, y) which lies in the triangle at position start.
+    The cavity is grown from start through the neighbours whose circumcircle strictly contains the point. In a
+    Delaunay mesh this is always a valid cavity. In a mesh which is not Delaunay the grown region might not be
+    star-shaped from the point or might enclose a vertex, so triangles causing this are dropped again until the
+    cavity can be re-filled with a fan. The output is placed into cavity. Returns false if the point coincides
+    with a vertex of start or no valid cavity exists.
+*/
+bool Triangulation::findCavity(float x, float y, int start, std::vector<int> &cavity)
+{
+    float *px(myPacked.getX()), *py(myPacked.getY()); // Coordinates from the flat arrays.
+    int *first(myPacked.getCell(start));
+    for (int i = 0; i < 3; ++i) // A point on top of an existing vertex cannot be inserted.
+    {
+        if (px[first[i]] == x && py[first[i]] == y)
+        {
+            return false;
+        }
+    }
+
+    // Grow the cavity with a flood fill through the neighbours. The cavity itself serves as the queue.
+    unsigned int inCavity(nextStamp());
+    cavity.assign(1, start);
+    myTriangleMarks[start] = inCavity;
+    for (std::size_t next = 0; next < cavity.size(); ++next)
+    {
+        Triangle triangle(&myPacked, cavity[next]);
+        for (int i = 0; i < 3; ++i)
+        {
+            int neighbour(triangle.getNeighbour(i));
+            if (neighbour == -1 || myTriangleMarks[neighbour] == inCavity)
+            {
+                continue;
+            }
+            int *other(myPacked.getCell(neighbour));
+            double side(Predicates::orientation(px[other[0]], py[other[0]], px[other[1]], py[other[1]], px[other[2]], py[other[2]]));
+            double inside(Predicates::inCircle(px[other[0]], py[other[0]], px[other[1]], py[other[1]], px[other[2]], py[other[2]], x, y));
+            if ((side > 0 && inside > 0) || (side < 0 && inside < 0)) // Strictly inside the circumcircle, whatever the orientation of the triangle.
+            {
+                myTriangleMarks[neighbour] = inCavity;
+                cavity.push_back(neighbour);
+            }
+        }
+    }
+
+    for (int attempt = 0; attempt < 64; ++attempt) // Shrink the cavity until it is valid.
+    {
+        std::vector<int> &toRemove = myCavityDropped; // Triangles breaking the cavity in this round.
+        std::vector<int> &cavityVertices = myCavityVertices; // myPointCounts gives the number of border edges touching each of them.
+        toRemove.clear();
+        cavityVertices.clear();
+        unsigned int counted(nextStamp());
+        for (std::vector<int>::iterator it = cavity.begin(); it != cavity.end(); ++it)
+        {
+            Triangle triangle(&myPacked, *it);
+            int *cell(myPacked.getCell(*it));
+            double side(Predicates::orientation(px[cell[0]], py[cell[0]], px[cell[1]], py[cell[1]], px[cell[2]], py[cell[2]]));
+            for (int i = 0; i < 3; ++i)
+            {
+                if (myPointMarks[triangle[i]] != counted)
+                {
+                    myPointMarks[triangle[i]] = counted;
+                    myPointCounts[triangle[i]] = 0;
+                    cavityVertices.push_back(triangle[i]);
+                }
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                int neighbour(triangle.getNeighbour(i));
+                if (neighbour != -1 && myTriangleMarks[neighbour] == inCavity) // Interior edge.
+                {
+                    continue;
+                }
+                int u(cell[(i + 1) % 3]), v(cell[(i + 2) % 3]);
+                double visible(Predicates::orientation(px[u], py[u], px[v], py[v], x, y));
+                if (neighbour == -1 && visible == 0) // The point lies on a boundary edge which will be split.
+                {
+                    continue;
+                }
+                myPointCounts[triangle[(i + 1) % 3]]++;
+                myPointCounts[triangle[(i + 2) % 3]]++;
+                if (!((side > 0 && visible > 0) || (side < 0 && visible < 0))) // The new triangle on this edge would be flat or flipped.
+                {
+                    toRemove.push_back(*it);
+                }
+            }
+        }
+
+        for (std::vector<int>::iterator it = cavityVertices.begin(); it != cavityVertices.end(); ++it) // Every vertex must stay on the border exactly once.
+        {
+            if (myPointCounts[*it] > 0 && myPointCounts[*it] <= 2)
+            {
+                continue;
+            }
+            for (std::vector<int>::iterator jt = cavity.begin(); jt != cavity.end(); ++jt) // Drop the triangles around an enclosed or pinched vertex.
+            {
+                Triangle triangle(&myPacked, *jt);
+                if (triangle[0] == *it || triangle[1] == *it || triangle[2] == *it)
+                {
+                    toRemove.push_back(*jt);
+                }
+            }
+        }
+
+        if (toRemove.empty()) // The cavity is valid.
+        {
+            return true;
+        }
+        for (std::vector<int>::iterator it = toRemove.begin(); it != toRemove.end(); ++it)
+        {
+            if (*it == start) // The point's own triangle cannot be dropped.
+            {
+                return false;
+            }
+            myTriangleMarks[*it] = 0; // No stamp is 0.
+        }
+
+        // Dropping triangles may have cut the cavity into pieces, keep the piece containing start.
+        std::vector<int> &connected = myCavityPiece;
+        unsigned int inPiece(nextStamp());
+        connected.assign(1, start);
+        myTriangleMarks[start] = inPiece;
+        for (std::size_t next = 0; next < connected.size(); ++next)
+        {
+            Triangle triangle(&myPacked, connected[next]);
+            for (int i = 0; i < 3; ++i)
+            {
+                int neighbour(triangle.getNeighbour(i));
+                if (neighbour != -1 && myTriangleMarks[neighbour] == inCavity)
+                {
+                    myTriangleMarks[neighbour] = inPiece;
+                    connected.push_back(neighbour);
+                }
+            }
+        }
+        cavity.swap(connected);
+        inCavity = inPiece;
+    }
+    return false;
+}
+
+/*
+    The following method starts a new set of marks for insertVertex() and findCavity(): a triangle or point belongs to
+    the set while its entry in myTriangleMarks or myPointMarks equals the returned stamp, so a set is emptied without
+    touching the arrays. They grow with the mesh and are only cleared when the stamp wraps around.
+*/
+unsigned int Triangulation::nextStamp()
+{
+    std::size_t points(myPacked.getNumberOfPoints()), cells(myPacked.getNumberOfCells());
+    if (myTriangleMarks.size() < cells)
+    {
+        myTriangleMarks.resize(cells, 0);
+    }
+    if (myPointMarks.size() < points)
+    {
+        myPointMarks.resize(points, 0);
+        myPointCounts.resize(points);
+        myPointFrom.resize(points);
+        myPointTo.resize(points);
+    }
+    if (++myStamp == 0) // Marks left from the previous round of stamps could be taken for new ones.
+    {
+        std::fill(myTriangleMarks.begin(), myTriangleMarks.end(), 0);
+        std::fill(myPointMarks.begin(), myPointMarks.end(), 0);
+        myStamp = 1;
+    }
+    return myStamp;
+}
+
+/*
+    The following method removes the triangle with the given ID. Its neighbours lose it across the shared edges,
+    which become boundary edges, and its corners leave the rings of their points, which gives the points another
+    incident triangle. The last triangle is then moved into the freed position, together with its attributes and
+    cached geometry, and the references to it are updated, so the mesh stays without gaps. Everything is local
+    to the two triangles involved and their vertices.
+*/
+bool Triangulation::removeTriangle(long long id)
+{
+    int slot(myTriangleIndex.find(id));
+    if (slot == -1)
+    {
+        return false;
+    }
+    Triangle triangle(&myPacked, slot);
+    for (int i = 0; i < 3; ++i) // Detach from the neighbours.
+    {
+        int a(triangle[(i + 1) % 3]), b(triangle[(i + 2) % 3]), neighbour(triangle.getNeighbour(i));
+        if (neighbour == -1) // The edge disappears with the triangle.
+        {
+            if (myOpenEdges.find(MeshAlgorithms::edgeKey(a, b)) == slot)
+            {
+                myOpenEdges.erase(MeshAlgorithms::edgeKey(a, b));
+            }
+        }
+        else // The neighbour is left alone on the edge.
+        {
+            replaceNeighbour(neighbour, a, b, -1);
+            myOpenEdges.set(MeshAlgorithms::edgeKey(a, b), neighbour);
+        }
+    }
+    for (int i = 0; i < 3; ++i) // The vertices no longer use the triangle.
+    {
+        unlinkCorner(3 * slot + i);
+    }
+
+    int last(myPacked.getNumberOfCells() - 1);
+    myTriangleIndex.erase(id);
+    if (slot != last) // Move the last triangle into the position.
+    {
+        Triangle moved(&myPacked, last);
+        for (int i = 0; i < 3; ++i)
+        {
+            int a(moved[(i + 1) % 3]), b(moved[(i + 2) % 3]), neighbour(moved.getNeighbour(i));
+            if (neighbour != -1)
+            {
+                replaceNeighbour(neighbour, a, b, slot);
+            }
+            else
+            {
+                if (myOpenEdges.find(MeshAlgorithms::edgeKey(a, b)) == last)
+                {
+                    myOpenEdges.set(MeshAlgorithms::edgeKey(a, b), slot);
+                }
+            }
+            unlinkCorner(3 * last + i); // Linked again below under the new position.
+        }
+        myTriangleIndex.erase(moved.getId());
+        myTriangleIndex.insert(moved.getId(), slot);
+    }
+    myPacked.removeCell(slot);
+    myNextCorner.resize(3 * (std::size_t)last);
+    for (int i = 0; slot != last && i < 3; ++i)
+    {
+        linkCorner(3 * slot + i);
+    }
+    myGeometry.remove(slot, last);
+    if (isGridValid)
+    {
+        myGrid.remove(slot, last);
+        if (myGrid.isStale()) // Far fewer triangles than the cells were sized for.
+        {
+            invalidateGrid();
+        }
+    }
+    numberOfCells--;
+    if (myLastLocated == last)
+    {
+        myLastLocated = slot;
+    }
+    return true;
+}
+
+/*
+    The following method removes the vertex with the given ID. Only a vertex which no triangle uses can be
+    removed; remove its triangles first. The last vertex is moved into the freed position and the triangles
+    using it, found in its ring of corners, are updated.
+*/
+bool Triangulation::removeVertex(long long id)
+{
+    int slot(myPointIndex.find(id));
+    if (slot == -1 || myFirstCorner[slot] != -1)
+    {
+        return false;
+    }
+    int last(myPacked.getNumberOfPoints() - 1);
+    myPointIndex.erase(id);
+    if (slot != last) // Move the last vertex into the position.
+    {
+        std::vector<int> &users = myCavity; // Scratch space shared with insertVertex().
+        findUses(last, users);
+        for (std::vector<int>::iterator it = users.begin(); it != users.end(); ++it)
+        {
+            Triangle triangle(&myPacked, *it);
+            for (int i = 0; i < 3; ++i) // Boundary edges are keyed by their vertices and have to be keyed again.
+            {
+                int a(triangle[(i + 1) % 3]), b(triangle[(i + 2) % 3]);
+                if (triangle.getNeighbour(i) == -1 && (a == last || b == last))
+                {
+                    if (myOpenEdges.find(MeshAlgorithms::edgeKey(a, b)) == *it)
+                    {
+                        myOpenEdges.erase(MeshAlgorithms::edgeKey(a, b));
+                        myOpenEdges.set(MeshAlgorithms::edgeKey(a == last ? slot : a, b == last ? slot : b), *it);
+                    }
+                }
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                if (triangle[i] == last)
+                {
+                    triangle[i] = slot; // Same coordinates, so the cached geometry stays valid.
+                }
+            }
+        }
+        myFirstCorner[slot] = myFirstCorner[last]; // The corners in the ring refer to the new position now.
+        myPointIndex.erase(myPacked.getPointId(last));
+        myPointIndex.insert(myPacked.getPointId(last), slot);
+    }
+    myFirstCorner.pop_back();
+    myPacked.removePoint(slot);
+    numberOfPoints--;
+    myVertexTree.clear(); // A vertex changed position.
+    return true;
+}
+
+/*
+    The following method collects the positions of the triangles using the point at position vertex, which are
+    the triangles of the corners in its ring.
+*/
+void Triangulation::findUses(int vertex, std::vector<int> &triangles)
+{
+    triangles.clear();
+    for (int corner = myFirstCorner[vertex]; corner != -1; corner = myNextCorner[corner])
+    {
+        triangles.push_back(corner / 3);
+    }
+}
+
+/*
+    The following method throws away the point location grid, the vertex tree and the cached geometry of the
+    triangles. It is called when the mesh is loaded and should also be called by the user after moving points or
+    changing triangles through the objects returned by getMyPoints()/getMyTriangles(). Everything is rebuilt by
+    the next query.
+*/
+void Triangulation::invalidateSpatialIndex()
+{
+    invalidateGrid();
+    myVertexTree.clear();
+    myGeometry.markAllDirty();
+}
+
+/*
+    The following method throws away the point location grid only, to be built again by the next query.
+*/
+void Triangulation::invalidateGrid()
+{
+    myGrid.clear();
+    isGridValid = false;
+}
+
+/*
+    The following two methods keep the point location grid in step with the triangles: a triangle is taken out
+    of the grid before its vertices change and put back afterwards, and a new one is put in. Nothing is done
+    while the grid is not built. Once the grid is stale, because the number of triangles has doubled or halved
+    since its cells were sized, or it was built for an empty mesh, it is thrown away instead and built again by
+    the next query, which only happens after the mesh has changed a lot.
+*/
+void Triangulation::eraseFromGrid(int slot)
+{
+    if (isGridValid)
+    {
+        myGrid.erase(slot);
+    }
+}
+
+void Triangulation::insertIntoGrid(int slot)
+{
+    if (!isGridValid)
+    {
+        return;
+    }
+    if (myGrid.isEmpty())
+    {
+        invalidateGrid();
+        return;
+    }
+    myGrid.insert(myPacked, slot);
+    if (myGrid.isStale())
+    {
+        invalidateGrid();
+    }
+}
+
+
+/*
+    The following method reads a .tri file like operator>> does, but much faster: the file is memory mapped and
+    the numbers are parsed in place with std::from_chars straight into the flat arrays, without going through
+    a stream. The header counts are validated: every section must have exactly the announced number of lines
+    with exactly the announced number of values, and the IDs of each section must be unique and not negative.
+    The records are stored in file order and indexed by ID (see IdIndex), and the vertices of the cells are
+    turned into positions of points as they are parsed. Whatever follows the cells, such as the names of the
+    attributes, is ignored as it is by operator>>. The object must be empty.
+    With numberOfThreads other than 1 (0 uses every core) the sections are split at line breaks and the pieces
+    parsed concurrently; the result is identical to the single-threaded load. If statistics is not NULL it
+    receives the size of the file, the time taken and the reason of a failure. On failure the object is left
+    empty.
+*/
+bool Triangulation::load(const char *fileName, LoadStatistics *statistics, int numberOfThreads)
+{
+    std::chrono::steady_clock::time_point startTime(std::chrono::steady_clock::now());
+    LoadStatistics local;
+    LoadStatistics &report(statistics != NULL ? *statistics : local);
+    report = LoadStatistics();
+
+    if (myPacked.getNumberOfPoints() != 0 || myPacked.getNumberOfCells() != 0)
+    {
+        report.error = "the triangulation already holds a mesh";
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(fileName))
+    {
+        report.error = std::string("unable to open ") + fileName;
+        return false;
+    }
+    report.bytes = file.getSize();
+
+    const char *begin(file.getData()), *end(begin + file.getSize());
+    bool isLoaded(false);
+    if (getNumberOfThreads(numberOfThreads) > 1)
+    {
+        isLoaded = parseParallel(begin, end, getNumberOfThreads(numberOfThreads));
+        if (!isLoaded) // Parse again in one piece, which finds the first error in the file for the report.
+        {
+            discardLoad();
+        }
+    }
+    if (!isLoaded)
+    {
+        const char *position(begin);
+        std::string error;
+        bool isParsed(parsePoints(position, end, error));
+        bool isIndexed(isParsed && indexPoints(error));
+        if (isIndexed)
+        {
+            isParsed = parseCells(position, end, error);
+            isIndexed = isParsed && indexCells(error);
+        }
+        if (!isIndexed)
+        {
+            report.error = isParsed ? error : "line " + std::to_string(TriFormat::lineNumber(begin, position)) + ": " + error; // A repeated ID is not the error of one line.
+            discardLoad();
+            return false;
+        }
+    }
+
+    invalidateSpatialIndex();
+    buildAdjacency();
+
+    report.numberOfPoints = numberOfPoints;
+    report.numberOfCells = numberOfCells;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    Metrics::add(Metrics::PARSED_BYTES, report.bytes);
+    Metrics::record(Metrics::PARSE_LATENCY, (unsigned long long)(report.seconds * 1e9));
+    return true;
+}
+
+/*
+    The following method throws away a partially loaded mesh.
+*/
+void Triangulation::discardLoad()
+{
+    myPoints.clear();
+    myTriangles.clear();
+    myTrianglePool.clear();
+    myVertexPool.clear();
+    myFirstCorner.clear();
+    myNextCorner.clear();
+    myPacked.clear();
+    myPointIndex.clear();
+    myTriangleIndex.clear();
+}
+
+/*
+    The following method checks the header of the points section and allocates the storage for the points.
+*/
+bool Triangulation::beginPoints(TriHeader &header, std::string &error)
+{
+    if (header.valuesPerEntry < 1 || header.valuesPerEntry > 3)
+    {
+        error = "points must have 1 to 3 dimensions";
+        return false;
+    }
+    numberOfPoints = header.count;
+    numberOfDimensions = header.valuesPerEntry;
+    numberOfAttributesPerPoint = header.attributesPerEntry;
+
+    myPacked.resize(numberOfPoints, 0);
+    return true;
+}
+
+/*
+    The following method checks the header of the cells section and allocates the storage for the cells.
+*/
+bool Triangulation::beginCells(TriHeader &header, std::string &error)
+{
+    if (header.valuesPerEntry != 3)
+    {
+        error = "cells must have 3 vertices";
+        return false;
+    }
+    numberOfCells = header.count;
+    numberOfVerticesPerCell = header.valuesPerEntry;
+    numberOfAttributesPerCell = header.attributesPerEntry;
+
+    myPacked.setAttributeStride(numberOfAttributesPerCell);
+    myPacked.resize(numberOfPoints, numberOfCells);
+    return true;
+}
+
+/*
+    The following method parses one line of the points section, starting at its first token, into the ID and
+    coordinate arrays at the given position. Coordinates beyond numberOfDimensions are zero and
+    the attributes of the points are checked but not stored, the same as readPoints().
+*/
+bool Triangulation::parsePoint(const char *&position, const char *end, int slot, std::string &error)
+{
+    long long id;
+    float coordinate[3] = {0.0f, 0.0f, 0.0f};
+    if (!TriFormat::parsePointRecord(position, end, id, coordinate, numberOfDimensions, (float *)NULL, numberOfAttributesPerPoint, error))
+    {
+        return false;
+    }
+    myPacked.setPointId(slot, id);
+    myPacked.setPoint(slot, coordinate[0], coordinate[1], coordinate[2]);
+    return true;
+}
+
+/*
+    The following method parses one line of the cells section into the ID and connectivity arrays and the
+    attribute buffer at the given position. The points must have been indexed: the IDs of the vertices
+    are looked up and stored as positions.
+*/
+bool Triangulation::parseCell(const char *&position, const char *end, int slot, std::string &error)
+{
+    long long id;
+    int vertices[3];
+    if (!TriFormat::parseCellRecord(position, end, id, [this](long long vertexId) { return myPointIndex.find(vertexId); }, vertices, myPacked.getAttributes(slot), numberOfAttributesPerCell, error))
+    {
+        return false;
+    }
+    myPacked.setCellId(slot, id);
+    myPacked.setCell(slot, vertices[0], vertices[1], vertices[2]);
+    return true;
+}
+
+/*
+    The following method indexes the parsed points by ID. Returns false if an ID is repeated or negative.
+*/
+bool Triangulation::indexPoints(std::string &error)
+{
+    long long conflict(-1);
+    if (!myPointIndex.build(numberOfPoints, [this](int p) { return myPacked.getPointId(p); }, &conflict))
+    {
+        error = "point ID " + std::to_string(conflict) + (conflict < 0 ? " is negative" : " is repeated");
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method indexes the parsed cells by ID. Returns false if an ID is repeated or negative.
+*/
+bool Triangulation::indexCells(std::string &error)
+{
+    long long conflict(-1);
+    if (!myTriangleIndex.build(numberOfCells, [this](int t) { return myPacked.getCellId(t); }, &conflict))
+    {
+        error = "cell ID " + std::to_string(conflict) + (conflict < 0 ? " is negative" : " is repeated");
+        return false;
+    }
+    return true;
+}
+
+/*
+    The following method parses the header and the lines of the points section in one piece.
+*/
+bool Triangulation::parsePoints(const char *&position, const char *end, std::string &error)
+{
+    TriHeader header;
+    if (!TriFormat::parseHeader(position, end, header))
+    {
+        error = "malformed points header";
+        return false;
+    }
+    if (!beginPoints(header, error))
+    {
+        return false;
+    }
+    for (int j = 0; j < numberOfPoints; ++j)
+    {
+        TriFormat::skipWhitespace(position, end);
+        if (position == end)
+        {
+            error = "expected " + std::to_string(numberOfPoints) + " points, found " + std::to_string(j);
+            return false;
+        }
+        if (!parsePoint(position, end, j, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    The following method parses the header and the lines of the cells section in one piece.
+*/
+bool Triangulation::parseCells(const char *&position, const char *end, std::string &error)
+{
+    TriHeader header;
+    if (!TriFormat::parseHeader(position, end, header))
+    {
+        error = "malformed cells header";
+        return false;
+    }
+    if (!beginCells(header, error))
+    {
+        return false;
+    }
+    for (int j = 0; j < numberOfCells; ++j)
+    {
+        TriFormat::skipWhitespace(position, end);
+        if (position == end)
+        {
+            error = "expected " + std::to_string(numberOfCells) + " cells, found " + std::to_string(j);
+            return false;
+        }
+        if (!parseCell(position, end, j, error))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    The following method parses the file with several threads. Everything after the points header is cut into
+    one piece per thread at line breaks. A first parallel pass counts the records (non-blank lines) in every
+    piece, which tells each piece the index of its first record: records 0 to numberOfPoints - 1 are points,
+    the next one is the cells header and the numberOfCells after it are cells. The cells header is parsed,
+    then a parallel pass parses the points of every piece, the points are indexed by ID and a last parallel pass
+    parses the cells, which need the index to resolve their vertices. Each record goes to the position given by
+    its index. Returns false on any problem without saying what it is; load() then parses the file again in one
+    piece to report it.
+*/
+bool Triangulation::parseParallel(const char *begin, const char *end, int numberOfThreads)
+{
+    const char *position(begin);
+    TriHeader header;
+    std::string error;
+    if (!TriFormat::parseHeader(position, end, header) || !beginPoints(header, error))
+    {
+        return false;
+    }
+
+    std::vector<const char*> pieces(numberOfThreads + 1); // Piece t is [pieces[t], pieces[t + 1]).
+    pieces[0] = position;
+    pieces[numberOfThreads] = end;
+    for (int t = 1; t < numberOfThreads; ++t) // Move each cut to the start of the next line.
+    {
+        const char *cut(std::max(position + (end - position) * (long long)t / numberOfThreads, pieces[t - 1]));
+        pieces[t] = cut == pieces[t - 1] ? cut : TriFormat::nextLine(cut - 1, end);
+    }
+
+    std::vector<long long> firstRecord(numberOfThreads + 1, 0); // Index of the first record of each piece.
+    parallelFor(0, numberOfThreads, numberOfThreads, [&](int first, int last, int)
+    {
+        for (int t = first; t < last; ++t)
+        {
+            firstRecord[t + 1] = TriFormat::countRecords(pieces[t], pieces[t + 1]);
+        }
+    });
+    for (int t = 0; t < numberOfThreads; ++t)
+    {
+        firstRecord[t + 1] += firstRecord[t];
+    }
+    if (firstRecord[numberOfThreads] <= numberOfPoints) // The cells header is missing.
+    {
+        return false;
+    }
+
+    int piece(0); // Find and parse the cells header, record numberOfPoints.
+    while (firstRecord[piece + 1] <= numberOfPoints)
+    {
+        ++piece;
+    }
+    const char *cellsHeader(pieces[piece]);
+    for (long long r = firstRecord[piece]; r < numberOfPoints; ++r)
+    {
+        TriFormat::skipWhitespace(cellsHeader, end);
+        cellsHeader = TriFormat::nextLine(cellsHeader, end);
+    }
+    if (!TriFormat::parseHeader(cellsHeader, end, header) || !beginCells(header, error))
+    {
+        return false;
+    }
+    long long lastRecord((long long)numberOfPoints + 1 + numberOfCells); // Records from here on are not part of the mesh.
+    if (firstRecord[numberOfThreads] < lastRecord)
+    {
+        return false;
+    }
+
+    std::vector<const char*> cellsBegin(pieces.begin(), pieces.end() - 1); // Where the cells pass starts in each piece.
+    std::atomic<bool> isValid(true);
+    parallelFor(0, numberOfThreads, numberOfThreads, [&](int first, int last, int)
+    {
+        std::string threadError; // Not reported, load() finds the error again.
+        for (int t = first; t < last; ++t)
+        {
+            const char *p(pieces[t]);
+            for (long long r = firstRecord[t]; r < firstRecord[t + 1] && r < numberOfPoints && isValid.load(std::memory_order_relaxed); ++r)
+            {
+                TriFormat::skipWhitespace(p, pieces[t + 1]);
+                if (!parsePoint(p, pieces[t + 1], (int)r, threadError))
+                {
+                    isValid = false;
+                }
+            }
+            cellsBegin[t] = p;
+        }
+    });
+    if (!isValid || !indexPoints(error))
+    {
+        return false;
+    }
+
+    parallelFor(0, numberOfThreads, numberOfThreads, [&](int first, int last, int)
+    {
+        std::string threadError;
+        for (int t = first; t < last; ++t)
+        {
+            const char *p(cellsBegin[t]);
+            for (long long r = std::max(firstRecord[t], (long long)numberOfPoints); r < firstRecord[t + 1] && r < lastRecord && isValid.load(std::memory_order_relaxed); ++r)
+            {
+                TriFormat::skipWhitespace(p, pieces[t + 1]);
+                if (r == numberOfPoints) // The cells header, already parsed.
+                {
+                    p = TriFormat::nextLine(p, pieces[t + 1]);
+                }
+                else if (!parseCell(p, pieces[t + 1], (int)(r - numberOfPoints - 1), threadError))
+                {
+                    isValid = false;
+                }
+            }
+        }
+    });
+    return isValid && indexCells(error);
+}
+
+/*
+    The following method writes the mesh in the binary format described in TriBinary.h: a header and then the
+    flat arrays as they are in memory, each block aligned, followed by the neighbours so that loading does not
+    have to rebuild them. Points and cells are written in the order of the mesh. Their IDs are only written when
+    they are not simply the positions.
+*/
+bool Triangulation::writeBinary(const char *fileName)
+{
+    std::ofstream myFile(fileName, std::ios::binary);
+    if (!myFile.is_open())
+    {
+        return false;
+    }
+    int points(myPacked.getNumberOfPoints()), cells(myPacked.getNumberOfCells()), stride(myPacked.getAttributeStride());
+    bool hasIds(!myPointIndex.isIdentity() || !myTriangleIndex.isIdentity());
+    TriBinaryHeader header;
+    TriBinary::initialise(header, points, numberOfDimensions, numberOfAttributesPerPoint, cells, stride, true, hasIds);
+
+    std::vector<std::int64_t> pointIds(hasIds ? points : 0), cellIds(hasIds ? cells : 0);
+    for (std::size_t j = 0; j < pointIds.size(); ++j)
+    {
+        pointIds[j] = myPacked.getPointId(j);
+    }
+    for (std::size_t j = 0; j < cellIds.size(); ++j)
+    {
+        cellIds[j] = myPacked.getCellId(j);
+    }
+
+    const char *blocks[8] = {(const char *)myPacked.getX(), (const char *)myPacked.getY(), (const char *)myPacked.getZ(), (const char *)myPacked.getConnectivity(), (const char *)myPacked.getAttributeBuffer(), (const char *)myPacked.getNeighbours(0), (const char *)pointIds.data(), (const char *)cellIds.data()};
+    std::uint64_t offsets[8] = {header.xOffset, header.yOffset, header.zOffset, header.connectivityOffset, header.attributesOffset, header.neighboursOffset, header.pointIdsOffset, header.cellIdsOffset};
+    std::uint64_t sizes[8] = {sizeof(float) * (std::uint64_t)points, sizeof(float) * (std::uint64_t)points, sizeof(float) * (std::uint64_t)points, 3 * sizeof(int) * (std::uint64_t)cells, sizeof(float) * (std::uint64_t)stride * cells, 3 * sizeof(int) * (std::uint64_t)cells, sizeof(std::int64_t) * pointIds.size(), sizeof(std::int64_t) * cellIds.size()};
+    myFile.write((const char *)&header, sizeof(header));
+    std::uint64_t written(sizeof(header));
+    const char padding[TriBinary::ALIGNMENT] = {0};
+    for (int i = 0; i < (hasIds ? 8 : 6); ++i)
+    {
+        myFile.write(padding, offsets[i] - written); // Up to the start of the block.
+        myFile.write(blocks[i], sizes[i]);
+        written = offsets[i] + sizes[i];
+    }
+    return (bool)myFile;
+}
+
+/*
+    The following method opens a file written by writeBinary(). The file is memory mapped copy-on-write and the
+    PackedMesh is pointed straight at its blocks of coordinates, connectivity, attributes, neighbours and IDs,
+    so nothing is parsed or copied, and the Vertex and Triangle objects read the file as they read any other
+    mesh. Processes opening the same file share one copy of it in the page cache. What the file does not hold
+    is built in two passes over the cells: the boundary edges, and the ring of corners of every point, which
+    gives its incident triangle (or the whole adjacency if the file has no neighbours). The IDs are indexed as
+    load() does. Changing values in place only copies the pages touched; adding points or triangles copies
+    the arrays concerned out of the file first. The object must be empty.
+*/
+bool Triangulation::loadBinary(const char *fileName, LoadStatistics *statistics)
+{
+    std::chrono::steady_clock::time_point startTime(std::chrono::steady_clock::now());
+    LoadStatistics local;
+    LoadStatistics &report(statistics != NULL ? *statistics : local);
+    report = LoadStatistics();
+
+    if (myPacked.getNumberOfPoints() != 0 || myPacked.getNumberOfCells() != 0)
+    {
+        report.error = "the triangulation already holds a mesh";
+        return false;
+    }
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    if (!file->open(fileName, true))
+    {
+        report.error = std::string("unable to open ") + fileName;
+        return false;
+    }
+    report.bytes = file->getSize();
+    TriBinaryHeader header;
+    if (file->getSize() >= sizeof(header))
+    {
+        std::memcpy(&header, file->getData(), sizeof(header));
+    }
+    if (!TriBinary::check(header, file->getSize(), report.error))
+    {
+        return false;
+    }
+
+    char *data(file->getWritableData());
+    int points(header.numberOfPoints), cells(header.numberOfCells);
+    std::int64_t *pointIds(header.pointIdsOffset != 0 ? (std::int64_t *)(data + header.pointIdsOffset) : NULL);
+    std::int64_t *cellIds(header.cellIdsOffset != 0 ? (std::int64_t *)(data + header.cellIdsOffset) : NULL);
+    int *connectivity((int *)(data + header.connectivityOffset)), *neighbours(header.neighboursOffset != 0 ? (int *)(data + header.neighboursOffset) : NULL);
+    for (std::size_t k = 0; k < 3 * (std::size_t)cells; ++k) // Reject references which would lead outside the arrays.
+    {
+        if (connectivity[k] < 0 || connectivity[k] >= points || (neighbours != NULL && (neighbours[k] < -1 || neighbours[k] >= cells)))
+        {
+            report.error = "cell " + std::to_string(k / 3) + " refers to a point or neighbour which does not exist";
+            return false;
+        }
+    }
+
+    numberOfPoints = points;
+    numberOfDimensions = header.numberOfDimensions;
+    numberOfAttributesPerPoint = header.numberOfAttributesPerPoint;
+    numberOfCells = cells;
+    numberOfVerticesPerCell = header.numberOfVerticesPerCell;
+    numberOfAttributesPerCell = header.numberOfAttributesPerCell;
+    myPacked.view(file, (float *)(data + header.xOffset), (float *)(data + header.yOffset), (float *)(data + header.zOffset), pointIds, points, connectivity, neighbours, cellIds, (float *)(data + header.attributesOffset), cells, numberOfAttributesPerCell);
+    if (!indexPoints(report.error) || !indexCells(report.error))
+    {
+        discardLoad();
+        return false;
+    }
+
+    invalidateSpatialIndex();
+    if (neighbours == NULL)
+    {
+        buildAdjacency();
+    }
+    else // Take the stored neighbours; only the boundary edges and the rings of corners are left to find.
+    {
+        myOpenEdges.clear();
+        for (int j = 0; j < cells; ++j)
+        {
+            int *cell(connectivity + 3 * (std::size_t)j);
+            for (int i = 0; i < 3; ++i)
+            {
+                if (neighbours[3 * (std::size_t)j + i] == -1)
+                {
+                    myOpenEdges.set(MeshAlgorithms::edgeKey(cell[(i + 1) % 3], cell[(i + 2) % 3]), j);
+                }
+            }
+        }
+        linkCorners();
+    }
+
+    report.numberOfPoints = points;
+    report.numberOfCells = cells;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+/*
+    The following function writes value at p with the given number of significant digits, or the shortest text
+    which reads back to the same float if precision is 0, and returns the position after it. With precision 6
+    the text is the same as the default output of the stream operators.
+*/
+static char *formatFloat(char *p, char *last, float value, int precision)
+{
+    std::to_chars_result result(precision > 0 ? std::to_chars(p, last, value, std::chars_format::general, precision) : std::to_chars(p, last, value));
+    return result.ptr;
+}
+
+/*
+    The following method formats the text lines of points or cells [begin, end) into buffer, in the same layout
+    as the stream writer produced: a point is "ID x y z", a cell is "ID v0 v1 v2 " followed by each attribute and
+    a space, where the vertices are written as the IDs of the points. Returns the number of characters written.
+*/
+std::size_t Triangulation::formatRecords(bool isCells, int begin, int end, int precision, std::vector<char> &buffer)
+{
+    precision = std::min(std::max(precision, 0), 9); // 9 significant digits always identify a float.
+    std::size_t numberWidth(precision == 0 ? 16 : precision + 9); // Sign, point, exponent and separator included.
+    std::size_t lineWidth(isCells ? 4 * 21 + numberOfAttributesPerCell * numberWidth + 1 : 21 + 3 * numberWidth + 1); // 64 bit IDs take up to 19 digits.
+    buffer.resize((end - begin) * lineWidth);
+    char *p(buffer.data()), *last(buffer.data() + buffer.size());
+    bool isPointIdentity(myPointIndex.isIdentity()); // The vertices can be written as they are.
+    for (int j = begin; j < end; ++j)
+    {
+        if (isCells)
+        {
+            Triangle triangle(&myPacked, j);
+            p = std::to_chars(p, last, triangle.getId()).ptr;
+            for (int i = 0; i < 3; ++i)
+            {
+                *p++ = ' ';
+                p = std::to_chars(p, last, isPointIdentity ? (long long)triangle[i] : myPacked.getPointId(triangle[i])).ptr;
+            }
+            *p++ = ' ';
+            float *attributes(triangle.getAttributes());
+            for (int i = 0; i < numberOfAttributesPerCell; ++i)
+            {
+                p = formatFloat(p, last, attributes != NULL ? attributes[i] : 0.0f, precision);
+                *p++ = ' ';
+            }
+        }
+        else
+        {
+            Vertex vertex(&myPacked, j);
+            p = std::to_chars(p, last, vertex.getId()).ptr;
+            for (int i = 0; i < numberOfDimensions && i < 3; ++i)
+            {
+                *p++ = ' ';
+                p = formatFloat(p, last, vertex[i], precision);
+            }
+        }
+        *p++ = '\n';
+    }
+    return p - buffer.data();
+}
@@ -2,9 +2,27 @@
 #define TRIANGULATION_H
 
 #include "Triangle.h" // Triangulation requires triangles and other header files within this.
+#include "PackedMesh.h" // Flat storage of the coordinates, connectivity and attributes.
+#include "TriangleGrid.h" // Spatial index used for point location.
+#include "VertexTree.h" // Spatial index used for nearest vertex queries.
+#include "GeometryCache.h" // Areas and circumcircles of the triangles.
+#include "Parallel.h" // Splitting loops over several threads.
+#include "BatchKernels.h" // Vectorised point-in-triangle and point-in-circle tests.
+#include "MappedFile.h" // Memory mapped input for the fast loader.
+#include "TriFormat.h" // Parsing routines for the fast loader.
+#include "TriBinary.h" // Layout of the binary mesh format.
+#include "Quadrature.h" // Quadrature rules and compensated summation for integration().
+#include "Predicates.h" // Exact orientation and in-circle tests.
+#include "Metrics.h" // Counters and latency histograms of the hot paths.
+#include "IdIndex.h" // Positions of the points and triangles by ID.
+#include "ObjectPool.h" // Storage of the Vertex and Triangle objects.
+#include "EdgeMap.h" // Hash table matching the edges of neighbouring triangles.
+#include "MeshAlgorithms.h" // Adjacency, Delaunay check and integration shared with StaticMesh.
 #include <fstream> // File streaming.
 #include <algorithm> // Sorting algorithm from STL.
 #include <iostream> // To print out some information on the screen.
+#include <atomic> // Flags shared between threads.
+#include <cmath> // Absolute value of the areas in integration().
 
 /*
     The following class holds information of the mesh. It is the main interface
@@ -13,22 +31,23 @@
 class Triangulation
 {
 public:
-    Triangulation() {;} // Constructor
+    Triangulation() : myStamp(0), isGridValid(false), myLastLocated(-1), myWalkSeed(12345) {;} // Constructor
 
-    ~Triangulation()   // Destructor for cleaning up the container objects.
+    std::vector<Vertex*>& getMyPoints() // Returns a reference to the container with a Vertex for each point, in the order of the mesh. It must not be changed.
     {
-        delete[] temp1;
-        delete[] temp2;
+        bindObjects();
+        return myPoints;
     }
 
-    std::vector<Vertex*>& getMyPoints() // Returns a reference to the container.
+    std::vector<Triangle*>& getMyTriangles() // Returns a reference to the container with a Triangle for each triangle, in the order of the mesh. It must not be changed.
     {
-        return myPoints;
+        bindObjects();
+        return myTriangles;
     }
 
-    std::vector<Triangle*>& getMyTriangles() // Returns a reference to the container.
+    PackedMesh& getPackedMesh() // Returns the flat arrays holding the mesh, which the Vertex and Triangle objects read and write.
     {
-        return myTriangles;
+        return myPacked;
     }
 
     int getNumberOfPoints() // Provides the number of vertexes.
@@ -91,47 +110,220 @@ public:
         this->numberOfAttributesPerCell = numberOfAttributesPerCell;
     }
 
+    int findPoint(long long id) // Position of the vertex with the given ID in the container, or -1 if there is none.
+    {
+        return myPointIndex.find(id);
+    }
+
+    int findTriangle(long long id) // Position of the triangle with the given ID in the container, or -1 if there is none.
+    {
+        return myTriangleIndex.find(id);
+    }
+
     void isPointInAnyTriangle(Vertex &newPoint, std::vector<Triangle*> &inTriangles); // Method fills the inTriangles container with triangles which contain the newPoint.
-    void calculateCircumcentreOf(int id); // Method calculates the circumcentre point of the triangle with ID id and stores it in the triangle's object.
-    void calculateAreaOf(int id); // Calculates the area of the triangle with ID as id and stores it in the triangle's object.
+    long long locate(Vertex &newPoint, long long hint = -1); // Walks from the hint (by default the previous result) to the triangle containing newPoint and returns its ID, or -1 if none does.
+    void locate(const float *x, const float *y, int count, long long *triangles, int numberOfThreads = 0); // Batch version: writes the ID of the triangle containing each point (x[i], y[i]) to triangles[i], -1 if none does.
+    long long nearestVertex(float x, float y); // ID of the vertex closest to (x, y), or -1 if the mesh has none.
+    void nearestVertex(const float *x, const float *y, int count, long long *ids, int numberOfThreads = 0); // Batch version: writes the ID of the vertex closest to each point (x[i], y[i]) to ids[i].
+    void nearestVertices(float x, float y, int k, std::vector<long long> &ids); // IDs of the k vertices closest to (x, y), closest first.
+    void nearestVertices(const float *x, const float *y, int count, int k, long long *ids, int numberOfThreads = 0); // Batch version: k IDs per point from ids[i * k], padded with -1.
+    void verticesWithin(float x, float y, float radius, std::vector<long long> &ids); // IDs of the vertices at most radius away from (x, y), closest first.
+    void verticesWithin(const float *x, const float *y, int count, float radius, std::vector<std::vector<long long> > &ids, int numberOfThreads = 0); // Batch version: the IDs for point i go to ids[i].
+    void trianglesInBox(float lowX, float lowY, float highX, float highY, std::vector<long long> &ids); // IDs of the triangles which share at least a point with the box [lowX, highX] x [lowY, highY].
+    void trianglesInPolygon(const float *x, const float *y, int count, std::vector<long long> &ids); // IDs of the triangles which share at least a point with the polygon with corners (x[i], y[i]).
+
+    // The same queries handing each ID to visit(id) as it is found instead of collecting them, in no particular order.
+    template<typename T>
+    void visitTrianglesInBox(float lowX, float lowY, float highX, float highY, T visit);
+
+    template<typename T>
+    void visitTrianglesInPolygon(const float *x, const float *y, int count, T visit);
+
     void isPointInCircumcircle(Vertex &newPoint, std::vector<Triangle*> &inTriangles); // Method to evaluate whether the given newPoint lies inside the circumcircle of any triangle in the mesh. The triangles are returned in inTriangles.
     bool isOldPointInCircumcircle(Vertex &oldPoint); // Method which checks if any of the old points in the mesh already lie in the circumcentre of any triangle.
-    bool isDelaunay(); // Method to check if this mesh is DT.
+    bool isDelaunay(int numberOfThreads = 0); // Method to check if this mesh is DT.
+    bool checkDelaunay(std::vector<std::pair<long long, int> > *violations, int numberOfThreads = 0); // Edge by edge Delaunay check. Reports the violating (triangle ID, edge) pairs unless violations is NULL.
     void addNewVertex(float &x, float &y, float &z); // To add a new point.
-    void addNewTriangle(int &v0, int &v1, int &v2); // To add a new triangle into the mesh.
+    bool addNewTriangle(long long v0, long long v1, long long v2); // To add a new triangle into the mesh, given the IDs of its vertices. Returns false if one of them does not exist.
+    int makeDelaunay(); // Flips edges until the mesh is Delaunay. Returns the number of flips done.
+    long long insertVertex(float x, float y, float z); // Inserts a point into the mesh keeping it Delaunay (Bowyer-Watson). Returns the ID of the new vertex or -1.
+    bool removeTriangle(long long id); // Removes the triangle with the given ID; the last triangle takes its position. Returns false if there is none.
+    bool removeVertex(long long id); // Removes the vertex with the given ID if no triangle uses it; the last vertex takes its position. Returns false otherwise.
+    void buildAdjacency(); // Finds the neighbours of every triangle and an incident triangle of every vertex. Called after loading and to be called after changing the vertices of triangles through the objects.
+    void invalidateSpatialIndex(); // Discards the point location grid, the vertex tree and the cached geometry. Must be called after moving points or changing triangles through the objects.
+
+    bool load(const char *fileName, LoadStatistics *statistics = NULL, int numberOfThreads = 1); // Fast alternative to operator>> for an empty object: maps the file and parses it in place, with several threads if asked. Returns false on a malformed file.
 
     template<typename T>
     float integration(T t, bool method); // Method for integration which uses wildcard T for the function to integrate over the triangle domain.
 
+    // Integrates t over the mesh with a quadrature rule in double precision with compensated summation, on numberOfThreads
+    // threads (0 uses every core). The result only depends on the number of threads, not on their timing.
+    template<typename T>
+    double integration(T t, Quadrature::Rule rule, int numberOfThreads = 0);
+
+    // Integrates t with a quadrature rule over the part of the mesh inside the simple polygon with the corners (x[i], y[i]),
+    // given in either direction. Triangles cut by the boundary of the polygon only contribute the part inside it.
+    template<typename T>
+    double integration(T t, Quadrature::Rule rule, const float *x, const float *y, int count);
+
     template<typename T>
     friend T &operator>>(T &myFile, Triangulation &myTriangulation) // Stream operator to read data into the object. Assumes only files.
     {
+        // The points and triangles stay in file order. IDs may have gaps and need not be sorted; they are looked up
+        // through the ID indexes, and the vertices of the triangles are turned into positions while reading.
         myTriangulation.readPoints(myFile); // Reads the first segment of the file which are the vertexes.
         myTriangulation.readCells(myFile); // Followed by the triangles.
-        std::sort(myTriangulation.myPoints.begin(), myTriangulation.myPoints.end()); // Sorts points according to ID to ensure that when accessing the container the at() method is consistent. Assumes that IDs are not skipped.
-        std::sort(myTriangulation.myTriangles.begin(), myTriangulation.myTriangles.end()); // Sorts the triangles according to their IDs assuming that none are skipped.
-        // If IDs are skipped, we can implement a Predicate function and use find_if but this will be immensely slow.
+        myTriangulation.invalidateSpatialIndex(); // Any previously built grid no longer matches the data.
+        myTriangulation.buildAdjacency(); // Connect the triangles to their neighbours once they are in their final positions.
         return myFile;
     }
 
     friend std::ofstream &operator<<(std::ofstream &myFile, Triangulation &myTriangulation) // Stream operator to write data to a file. Assumes only files
     {
-        myTriangulation.writePoints(myFile); // Writes the vertexes out first.
-        myTriangulation.writeCells(myFile); // Followed by the triangles.
+        myTriangulation.writeText(myFile); // Same output as before with the default 6 significant digits, formatted in parallel.
         return myFile;
     }
 
+    // Writes the mesh as .tri text with the given number of significant digits (0 for the shortest text which reads back
+    // to the same float, at most 9 which always does), formatting on numberOfThreads threads (0 uses every core).
+    template<typename T>
+    void writeText(T &myFile, int precision = 6, int numberOfThreads = 0)
+    {
+        writePoints(myFile, precision, numberOfThreads); // Writes the vertexes out first.
+        writeCells(myFile, precision, numberOfThreads); // Followed by the triangles.
+    }
+
+    bool writeBinary(const char *fileName); // Writes the mesh in the binary format (see TriBinary.h). Returns false if the file cannot be written.
+    bool loadBinary(const char *fileName, LoadStatistics *statistics = NULL); // Maps a binary mesh file into an empty object whose arrays then are the blocks of the file. Returns false on an invalid file.
+
 private:
-    std::vector<Vertex*> myPoints; // Container with all vertexes.
-    std::vector<Triangle*> myTriangles; // Container with all triangles
+    PackedMesh myPacked; // The mesh in flat arrays: coordinates, connectivity, neighbours, IDs and attributes.
+    GeometryCache myGeometry; // Area and circumcircle of every triangle, recomputed only for triangles which changed.
 
     // Properties read from the data files:
     int numberOfPoints, numberOfDimensions, numberOfAttributesPerPoint;
     int numberOfCells, numberOfVerticesPerCell, numberOfAttributesPerCell;
 
-    // Pointers to objects in the containers used to deallocate when destroying this object.
-    Triangle *temp1;
-    Vertex *temp2;
+    // Vertex and Triangle objects for the positions of myPacked, handed out by getMyPoints() and getMyTriangles().
+    // They only refer to their position, so they are made when the containers are asked for (see bindObjects())
+    // and the mesh itself never uses them. Objects past the end of a mesh which shrank go back to the pools.
+    std::vector<Vertex*> myPoints;
+    std::vector<Triangle*> myTriangles;
+    ObjectPool<Vertex> myVertexPool;
+    ObjectPool<Triangle> myTrianglePool;
+
+    // The triangles using each point, as a ring of corners, a corner being 3 * triangle + i for vertex i of a
+    // triangle. myFirstCorner gives the first corner of each point, myNextCorner the following corner of the same
+    // point and -1 ends a ring. The triangle of the first corner is the incident triangle of the point in
+    // myPacked. A point may only be removed when its ring is empty.
+    std::vector<int> myFirstCorner, myNextCorner;
+
+    // Edges which so far belong to a single triangle, keyed by their two vertex positions. After buildAdjacency()
+    // these are exactly the boundary edges. It allows addNewTriangle() to find its neighbours in constant time.
+    EdgeMap myOpenEdges;
+
+    // Scratch space of insertVertex() and findCavity(), kept between calls so that an insertion does not allocate
+    // once it has grown. Sets of triangles and points are marked with a stamp (see nextStamp()).
+    std::vector<int> myCavity, myCavityPiece, myCavityDropped, myCavityVertices;
+    std::vector<int> myBorderStart, myBorderEnd, myBorderOuter, myFanSlots;
+    std::vector<long long> mySplitEdges;
+    std::vector<float> myFanAttributes;
+    std::vector<unsigned int> myTriangleMarks, myPointMarks; // Stamp of the set each triangle or point was last put in.
+    std::vector<int> myPointCounts, myPointFrom, myPointTo; // Values per point, valid while the point is marked with the current stamp.
+    unsigned int myStamp;
+
+    // Positions of the points and triangles in the containers by their IDs.
+    IdIndex myPointIndex, myTriangleIndex;
+
+    // Point location grid over the triangles. It is built on the first query and updated in place when triangles
+    // are added, removed or change shape.
+    TriangleGrid myGrid;
+    bool isGridValid;
+
+    // Tree over the vertices for nearest vertex queries. It is built on the first query, takes in new vertices as
+    // they are added and is thrown away when vertices move or are removed.
+    VertexTree myVertexTree;
+
+    // State of the point location walk: the last triangle found and the seed for choosing which edge to test first.
+    int myLastLocated;
+    unsigned int myWalkSeed;
+
+    struct PackedView // View for MeshAlgorithms of myPacked.
+    {
+        PackedMesh *packed;
+
+        int getVertex(int cell, int i)
+        {
+            return packed->getCell(cell)[i];
+        }
+
+        int getNeighbour(int cell, int i)
+        {
+            return packed->getNeighbours(cell)[i];
+        }
+
+        void setNeighbour(int cell, int i, int neighbour)
+        {
+            packed->getNeighbours(cell)[i] = neighbour;
+        }
+
+        double getX(int point)
+        {
+            return packed->getX()[point];
+        }
+
+        double getY(int point)
+        {
+            return packed->getY()[point];
+        }
+    };
+
+    PackedView getPackedView()
+    {
+        PackedView view = {&myPacked};
+        return view;
+    }
+
+    void bindObjects(); // Brings myPoints and myTriangles to the size of the mesh.
+    int appendTriangle(int v0, int v1, int v2); // Creates a triangle at the end of the mesh and returns its position.
+    void linkTriangle(int slot); // Connects the triangle at the given position to the neighbours already in myOpenEdges.
+    void linkCorners(); // Builds the rings of corners and the incident triangles from the triangles.
+    void linkCorner(int corner); // Puts a corner at the front of the ring of its point.
+    void unlinkCorner(int corner); // Takes a corner out of the ring of its point.
+    void findUses(int vertex, std::vector<int> &triangles); // Positions of all triangles using the point at position vertex.
+
+    void gatherCorners(int first, int count, float *ax, float *ay, float *bx, float *by, float *cx, float *cy); // Corners of consecutive triangles for the batch kernels.
+    bool findViolations(std::vector<std::pair<int, int> > *violations, int numberOfThreads); // checkDelaunay() reporting (triangle position, edge) pairs.
+    bool flipEdge(int slot, int edge); // Replaces the given edge by the other diagonal of the quadrilateral around it.
+    void replaceNeighbour(int outer, int v0, int v1, int slot); // Makes the triangle across edge (v0, v1) point at slot.
+    bool findCavity(float x, float y, int start, std::vector<int> &cavity); // Collects the triangles a new point at (x, y) replaces.
+    unsigned int nextStamp(); // Starts a new set of marked triangles and points.
+    int locatePosition(float x, float y, int start); // locate() working on positions. start is -1 to use the previous result.
+    int walk(float x, float y, int start, unsigned int &seed); // Visibility walk from the triangle at position start. Returns -1 if the walk leaves the mesh or gets stuck.
+    int locateInGrid(float x, float y); // Position of the first triangle in the grid containing (x, y), or -1.
+    static unsigned int mortonKey(unsigned int column, unsigned int row); // Interleaves the bits of two 16 bit numbers (Z-order curve).
+    void invalidateGrid(); // Discards only the point location grid.
+    void eraseFromGrid(int slot); // Takes the triangle at this position out of the grid before it changes shape.
+    void insertIntoGrid(int slot); // Puts the new or changed triangle at this position into the grid.
+
+    // Region queries.
+    enum Overlap {OUTSIDE, PARTIAL, INSIDE}; // How a triangle lies relative to a polygon.
+    Overlap overlapWith(int slot, const float *x, const float *y, int count); // Exact position of the triangle at position slot relative to the polygon.
+    int clipToTriangle(int slot, const float *x, const float *y, int count, std::vector<double> &clipX, std::vector<double> &clipY); // Part of the polygon inside the triangle. Returns its number of corners.
+    static bool segmentsIntersect(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy); // True if the closed segments ab and cd share a point.
+
+    // Parsing steps of load().
+    void discardLoad(); // Empties the object after a failed load.
+    bool beginPoints(TriHeader &header, std::string &error); // Checks the points header and allocates the points.
+    bool beginCells(TriHeader &header, std::string &error); // Checks the cells header and allocates the cells.
+    bool parsePoint(const char *&position, const char *end, int slot, std::string &error); // Parses one point line into the given position.
+    bool parseCell(const char *&position, const char *end, int slot, std::string &error); // Parses one cell line into the given position, resolving the IDs of its vertices.
+    bool indexPoints(std::string &error); // Builds the ID index of the points once they are parsed.
+    bool indexCells(std::string &error); // Builds the ID index of the cells.
+    bool parsePoints(const char *&position, const char *end, std::string &error); // Parses the points section in one piece.
+    bool parseCells(const char *&position, const char *end, std::string &error); // Parses the cells section in one piece.
+    bool parseParallel(const char *begin, const char *end, int numberOfThreads); // Parses both sections with several threads.
 
     // I/O methods called by the stream operators above. All incorporate wildcard input types for flexibility.
     template<typename T>
@@ -141,10 +333,14 @@ private:
     void readCells(T &myFile);
 
     template<typename T>
-    void writePoints(T &myFile);
+    void writePoints(T &myFile, int precision, int numberOfThreads);
+
+    template<typename T>
+    void writeCells(T &myFile, int precision, int numberOfThreads);
 
     template<typename T>
-    void writeCells(T &myFile);
+    void writeRecords(T &myFile, bool isCells, int precision, int numberOfThreads); // Formats the lines of one section in parallel chunks and writes them in order.
+    std::size_t formatRecords(bool isCells, int begin, int end, int precision, std::vector<char> &buffer); // Formats the lines of points or cells [begin, end) into buffer and returns their length.
 
     // Integration methods to provide modular design for the integration() method.
     template<typename T>
@@ -179,18 +375,18 @@ float Triangulation::integration(T t, bool method) // Method for integration whi
 /*
     Templated method to calculate the integral using Constant Value Approximation. The
     method uses the area and the circumcentre of the triangle which is passed to the function.
+    Both are taken from the geometry cache, so repeated integrations do not recompute them.
 */
 template<typename T>
 float Triangulation::constantValueApprox(T t)
 {
-    std::vector<Triangle*>::iterator it;
+    myGeometry.update(myPacked); // Calculates the areas and circumcentres which are not known yet.
+    float *area(myGeometry.getArea()), *centreX(myGeometry.getCentreX()), *centreY(myGeometry.getCentreY());
     float sum = 0; // Summing variable initialised to 0.
-    for (it = myTriangles.begin(); it != myTriangles.end(); ++it) // Iterate through each triangle.
+    for (int j = 0; j < myPacked.getNumberOfCells(); ++j) // Iterate through each triangle.
     {
-        calculateAreaOf((**it).getId()); // Calculate the area of the triangle.
-        calculateCircumcentreOf((**it).getId()); // Calculate the circumcentre.
         // sum += A * fc
-        sum += ((**it).getArea() * t((**it).getCircumcentrePoint()[0], (**it).getCircumcentrePoint()[1])); // Calculate the integral and accumulate it.
+        sum += (area[j] * t(centreX[j], centreY[j])); // Calculate the integral and accumulate it.
     }
     return sum;
 }
@@ -203,95 +399,272 @@ float Triangulation::constantValueApprox(T t)
 template<typename T>
 float Triangulation::linearInterpolationApprox(T t)
 {
-    std::vector<Triangle*>::iterator it;
+    myGeometry.update(myPacked); // Calculates the areas which are not known yet.
+    float *area(myGeometry.getArea()), *x(myPacked.getX()), *y(myPacked.getY());
     float sum = 0; // Summing variable initialised to 0.
-    for (it = myTriangles.begin(); it != myTriangles.end(); ++it) // Also iterates through all triangles.
+    for (int j = 0; j < myPacked.getNumberOfCells(); ++j) // Also iterates through all triangles.
     {
-        calculateAreaOf((**it).getId()); // Calculate the area of the triangle.
+        int *cell(myPacked.getCell(j));
         // sum += (A/3) * (f0 + f1 + f2)
-        sum += ((((**it).getArea()) / 3) * (t((*myPoints.at((**it)[0]))[0], (*myPoints.at((**it)[0]))[1]) + t((*myPoints.at((**it)[1]))[0], (*myPoints.at((**it)[1]))[1]) + t((*myPoints.at((**it)[2]))[0], (*myPoints.at((**it)[2]))[1])));
+        sum += ((area[j] / 3) * (t(x[cell[0]], y[cell[0]]) + t(x[cell[1]], y[cell[1]]) + t(x[cell[2]], y[cell[2]])));
     }
     return sum;
 }
 
+/*
+    The following method integrates t with the given quadrature rule, see MeshAlgorithms::integration(). The same
+    number of threads always gives the same result.
+*/
+template<typename T>
+double Triangulation::integration(T t, Quadrature::Rule rule, int numberOfThreads)
+{
+    return MeshAlgorithms::integration(getPackedView(), myPacked.getNumberOfCells(), t, rule, numberOfThreads);
+}
+
+/*
+    The following method integrates t over a polygon. The grid gives the triangles whose box overlaps the box of
+    the polygon. A triangle inside the polygon is integrated whole with the rule; the polygon is clipped to a
+    triangle it crosses (Sutherland-Hodgman, which is exact for a convex window such as a triangle even if the
+    polygon is not convex) and the clipped piece is cut into a fan of triangles from its first corner. The areas
+    of the fan carry a sign, so a piece which is not convex still adds up correctly, and the sign of the whole
+    polygon makes the result independent of the direction of its corners. As in MeshAlgorithms::integration() the quadrature
+    points are collected in blocks so t may take batches.
+*/
+template<typename T>
+double Triangulation::integration(T t, Quadrature::Rule rule, const float *x, const float *y, int count)
+{
+    double direction(0.0); // Twice the signed area of the polygon.
+    float lowX(INFINITY), lowY(INFINITY), highX(-INFINITY), highY(-INFINITY);
+    for (int i = 0; i < count; ++i)
+    {
+        int next(i + 1 < count ? i + 1 : 0);
+        direction += (double)x[i] * y[next] - (double)x[next] * y[i];
+        lowX = std::min(lowX, x[i]);
+        lowY = std::min(lowY, y[i]);
+        highX = std::max(highX, x[i]);
+        highY = std::max(highY, y[i]);
+    }
+    if (count < 3 || direction == 0)
+    {
+        return 0.0;
+    }
+    direction = direction > 0 ? 1.0 : -1.0;
+
+    const int block(256); // Triangles per block.
+    int numberOfRulePoints(Quadrature::getNumberOfPoints(rule)), pending(0);
+    const QuadraturePoint *rulePoints(Quadrature::getPoints(rule));
+    std::vector<double> pointX(block * numberOfRulePoints), pointY(block * numberOfRulePoints), values(block * numberOfRulePoints), area(block);
+    std::vector<double> clipX, clipY;
+    CompensatedSum sum;
+    auto flush = [&]()
+    {
+        MeshAlgorithms::evaluate(t, pointX.data(), pointY.data(), pending * numberOfRulePoints, values.data());
+        for (int k = 0; k < pending; ++k)
+        {
+            double weighted(0.0);
+            for (int q = 0; q < numberOfRulePoints; ++q)
+            {
+                weighted += rulePoints[q].weight * values[k * numberOfRulePoints + q];
+            }
+            sum.add(area[k] * weighted);
+        }
+        pending = 0;
+    };
+    auto add = [&](double x0, double y0, double x1, double y1, double x2, double y2, double signedArea)
+    {
+        area[pending] = signedArea;
+        for (int q = 0; q < numberOfRulePoints; ++q)
+        {
+            const QuadraturePoint &point = rulePoints[q];
+            pointX[pending * numberOfRulePoints + q] = point.a * x0 + point.b * x1 + point.c * x2;
+            pointY[pending * numberOfRulePoints + q] = point.a * y0 + point.b * y1 + point.c * y2;
+        }
+        if (++pending == block)
+        {
+            flush();
+        }
+    };
+
+    if (!isGridValid)
+    {
+        myGrid.build(myPacked);
+        isGridValid = true;
+    }
+    float *px(myPacked.getX()), *py(myPacked.getY());
+    myGrid.visitCandidates(lowX, lowY, highX, highY, [&](int slot)
+    {
+        Overlap overlap(overlapWith(slot, x, y, count));
+        if (overlap == INSIDE)
+        {
+            int *cell(myPacked.getCell(slot));
+            double x0(px[cell[0]]), y0(py[cell[0]]), x1(px[cell[1]]), y1(py[cell[1]]), x2(px[cell[2]]), y2(py[cell[2]]);
+            add(x0, y0, x1, y1, x2, y2, std::abs((x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0)) / 2);
+        }
+        else if (overlap == PARTIAL)
+        {
+            int corners(clipToTriangle(slot, x, y, count, clipX, clipY));
+            for (int i = 1; i + 1 < corners; ++i)
+            {
+                double signedArea(((clipX[i] - clipX[0]) * (clipY[i + 1] - clipY[0]) - (clipX[i + 1] - clipX[0]) * (clipY[i] - clipY[0])) / 2);
+                add(clipX[0], clipY[0], clipX[i], clipY[i], clipX[i + 1], clipY[i + 1], direction * signedArea);
+            }
+        }
+    });
+    flush();
+    return sum.getSum();
+}
+
+/*
+    The following methods visit the triangles which share at least a point with a box or a polygon, boundaries
+    included. The grid narrows them down to the triangles whose box overlaps the region, and each of those is
+    then tested exactly. A triangle lying within the box is accepted without further tests.
+*/
+template<typename T>
+void Triangulation::visitTrianglesInBox(float lowX, float lowY, float highX, float highY, T visit)
+{
+    if (!isGridValid)
+    {
+        myGrid.build(myPacked);
+        isGridValid = true;
+    }
+    float cornerX[4] = {lowX, highX, highX, lowX}, cornerY[4] = {lowY, lowY, highY, highY};
+    float *px(myPacked.getX()), *py(myPacked.getY());
+    myGrid.visitCandidates(lowX, lowY, highX, highY, [&](int slot)
+    {
+        int *cell(myPacked.getCell(slot));
+        bool isWithin(true);
+        for (int k = 0; k < 3; ++k)
+        {
+            isWithin = isWithin && px[cell[k]] >= lowX && px[cell[k]] <= highX && py[cell[k]] >= lowY && py[cell[k]] <= highY;
+        }
+        if (isWithin || overlapWith(slot, cornerX, cornerY, 4) != OUTSIDE)
+        {
+            visit(myPacked.getCellId(slot));
+        }
+    });
+}
+
+template<typename T>
+void Triangulation::visitTrianglesInPolygon(const float *x, const float *y, int count, T visit)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    if (!isGridValid)
+    {
+        myGrid.build(myPacked);
+        isGridValid = true;
+    }
+    float lowX(x[0]), lowY(y[0]), highX(x[0]), highY(y[0]);
+    for (int i = 1; i < count; ++i)
+    {
+        lowX = std::min(lowX, x[i]);
+        lowY = std::min(lowY, y[i]);
+        highX = std::max(highX, x[i]);
+        highY = std::max(highY, y[i]);
+    }
+    myGrid.visitCandidates(lowX, lowY, highX, highY, [&](int slot)
+    {
+        if (overlapWith(slot, x, y, count) != OUTSIDE)
+        {
+            visit(myPacked.getCellId(slot));
+        }
+    });
+}
+
 /*
     The readPoints method reads the points used by the triangle. It has a single input
     which is the input file stream passed by reference. Data is then stored appropriately.
+    The points are then indexed by ID; a repeated ID sets the failbit of the stream.
 */
 template<typename T>
 void Triangulation::readPoints(T &myFile)
 {
-    int tempId; // Temporary ID storage.
+    long long tempId; // Temporary ID storage.
+    float coordinate[3], ignored; // Coordinates of one point, and those beyond the third which are dropped.
 
     // Read the line with information about the structure of the rest of the points.
     myFile >> numberOfPoints >> numberOfDimensions >> numberOfAttributesPerPoint;
 
-    temp2 = new Vertex[numberOfPoints]; // Allocate memory based on the number of points.
-
-    myPoints.reserve(numberOfPoints-1); // Reserve enough space in the container to store the points we have in the file.
+    myPacked.resize(numberOfPoints, 0); // Make room for the points we have in the file.
     for (int j = 0; j < numberOfPoints; ++j) // The rest of the data is of the same format hence looping through it using the number of points mentioned
     {
         myFile >> tempId; // Store temporary ID.
-        temp2[j].setId(tempId); // Set the value to the temporary Vertex object.
+        myPacked.setPointId(j, tempId);
+        coordinate[0] = coordinate[1] = coordinate[2] = 0.0f;
         for (int i = 0; i < numberOfDimensions; ++i) // Read and store the coordinate value in each dimension.
         {
-            myFile >> (temp2[j])[i]; // Copy the values into the Vertex object.
+            myFile >> (i < 3 ? coordinate[i] : ignored);
         }
-        myPoints.push_back(&temp2[j]); // Push the object into the container.
+        myPacked.setPoint(j, coordinate[0], coordinate[1], coordinate[2]);
+    }
+    if (!myPointIndex.build(numberOfPoints, [this](int p) { return myPacked.getPointId(p); }))
+    {
+        myFile.setstate(std::ios::failbit);
     }
 }
 
 /*
     readCells is similar to readPoints but since the triangles have attributes,
     it takes that into account as well. The input is the input file stream and the
-    output is stored into the Triangle container.
+    output is stored into the packed mesh. The vertex IDs are replaced by the
+    positions of the points. A vertex which does not exist or a repeated triangle ID
+    sets the failbit of the stream; in the first case the vertex becomes point 0.
 */
 template<typename T>
 void Triangulation::readCells(T &myFile)
 {
-    int tempId; // Unique ID of the triangle.
+    long long tempId, vertexId; // Unique ID of the triangle and of one of its vertices.
 
     // Reading the information on the structure of the triangles.
     myFile >> numberOfCells >> numberOfVerticesPerCell >> numberOfAttributesPerCell;
 
-    temp1 = new Triangle[numberOfCells]; // Allocate memory based on the number of triangles.
+    // The attributes are read straight into one buffer instead of a separate allocation per triangle.
+    myPacked.setAttributeStride(numberOfAttributesPerCell);
+    myPacked.resize(myPacked.getNumberOfPoints(), numberOfCells);
 
     float *attributes;
-    myTriangles.reserve(numberOfCells-1); // Reserve memory in the container for all data.
     for (int j = 0; j < numberOfCells; ++j) // Going through each line using the number of cells as the limit.
     {
-        attributes = new float[numberOfAttributesPerCell];
-        temp1[j].setAttributes(attributes);
+        attributes = myPacked.getAttributes(j);
+        int *cell(myPacked.getCell(j));
         myFile >> tempId; // Reading the unique ID of this triangle.
-        temp1[j].setId(tempId); // Storing the ID within the object.
+        myPacked.setCellId(j, tempId);
         for (int i = 0; i < numberOfVerticesPerCell; ++i) // Reading the ID of the vertex a triangle has.
         {
-            myFile >> (temp1[j])[i];
+            myFile >> vertexId;
+            int vertex(myPointIndex.find(vertexId)); // Position of the vertex.
+            if (vertex == -1)
+            {
+                myFile.setstate(std::ios::failbit);
+                vertex = 0;
+            }
+            cell[i] = vertex;
         }
 
         for (int i = 0; i < numberOfAttributesPerCell; ++i) // Reading the attributes.
         {
             myFile >> attributes[i];
         }
-
-        myTriangles.push_back(&temp1[j]); // Pushing the filled object onto the container.
+    }
+    if (!myTriangleIndex.build(numberOfCells, [this](int t) { return myPacked.getCellId(t); }))
+    {
+        myFile.setstate(std::ios::failbit);
     }
 }
 
 /*
     The following method is used to write points to a provided file. The input is an
-    input file stream reference.
+    input file stream reference. Exactly numberOfDimensions coordinates are written per
+    point. The points have no attributes to write, so the header announces none.
 */
 template<typename T>
-void Triangulation::writePoints(T &myFile)
+void Triangulation::writePoints(T &myFile, int precision, int numberOfThreads)
 {
     // First writing the information on the structure of this segment.
-    myFile << numberOfPoints << " " << numberOfDimensions << " " << numberOfAttributesPerPoint << "\n";
-
-    for (std::vector<Vertex*>::iterator it = myPoints.begin(); it != myPoints.end(); ++it) // Loop through each object.
-    {
-        myFile << (**it).getId() << " " << (**it)[0] << " " << (**it)[1] << " " << (**it)[2] << "\n"; // Write it out.
-    }
+    myFile << numberOfPoints << " " << numberOfDimensions << " " << 0 << "\n";
+    writeRecords(myFile, false, precision, numberOfThreads);
 }
 
 /*
@@ -299,25 +672,42 @@ void Triangulation::writePoints(T &myFile)
     provided file reference.
 */
 template<typename T>
-void Triangulation::writeCells(T &myFile)
+void Triangulation::writeCells(T &myFile, int precision, int numberOfThreads)
 {
-    // Pointers used for accessing.
-    float *attributes;
-
     // Information header.
     myFile << numberOfCells << " " << numberOfVerticesPerCell << " " << numberOfAttributesPerCell << "\n";
+    writeRecords(myFile, true, precision, numberOfThreads);
+}
 
-    for (std::vector<Triangle*>::iterator it = myTriangles.begin(); it != myTriangles.end(); ++it) // Going through each triangle.
+/*
+    The following method writes the lines of the points or the cells section. The records are cut into chunks;
+    in every round each thread formats one chunk into its own buffer with std::to_chars, then the buffers are
+    written to the file in order with one call each. The output does not depend on the number of threads.
+*/
+template<typename T>
+void Triangulation::writeRecords(T &myFile, bool isCells, int precision, int numberOfThreads)
+{
+    const int chunkSize(1 << 16); // Records per chunk.
+    int count(isCells ? myPacked.getNumberOfCells() : myPacked.getNumberOfPoints());
+    int threads(getNumberOfThreads(numberOfThreads));
+    std::vector<std::vector<char> > buffers(threads); // Reused from round to round.
+    std::vector<std::size_t> lengths(threads);
+    for (int begin = 0; begin < count; begin += chunkSize * threads)
     {
-        attributes = (*it)->getAttributes(); // Get the attributes.
-        myFile << (*it)->getId() << " " << (**it)[0] << " " << (**it)[1] << " " << (**it)[2] << " "; // Write it out in the correct format.
-        for (int i = 0; i < numberOfAttributesPerCell; ++i) // Write out the attributes.
+        int chunks(std::min(threads, (count - begin + chunkSize - 1) / chunkSize)); // Chunks in this round.
+        parallelFor(0, chunks, chunks, [&](int first, int last, int)
+        {
+            for (int c = first; c < last; ++c)
+            {
+                int chunkBegin(begin + c * chunkSize);
+                lengths[c] = formatRecords(isCells, chunkBegin, std::min(chunkBegin + chunkSize, count), precision, buffers[c]);
+            }
+        });
+        for (int c = 0; c < chunks; ++c)
         {
-            myFile << attributes[i] << " ";
+            myFile.write(buffers[c].data(), lengths[c]);
         }
-        myFile << "\n";
     }
-
 }
 
 #endif
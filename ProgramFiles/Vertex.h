@@ -1,38 +1,40 @@
 #ifndef VERTEX_H
 #define VERTEX_H
 
+#include "PackedMesh.h" // The points of a mesh are stored there.
+
 /*
-    The following Vertex class is responsible for holding a coordinate in a grid space.
-    The class is hardwired for a 3 dimensional coordinate and has no attributes.
+    The following Vertex class gives access to a coordinate in a grid space, hardwired for 3 dimensions and no
+    attributes. A Vertex of a mesh only refers to the position of its point in the PackedMesh of the mesh, which
+    holds the coordinates, the ID and the incident triangle, so reading or writing it reads or writes the mesh;
+    a copy refers to the same point. A Vertex made by the constructors taking coordinates is a free point, such
+    as a query point: it keeps its coordinates itself and has no ID or incident triangle.
 */
 class Vertex
 {
 public:
-    Vertex() { // Constructor for simply creating the object.
-
+    Vertex() : slot(-1), z(0.0f) { // Constructor for simply creating the object, a free point at the origin.
+        coordinate[0] = coordinate[1] = 0.0f;
     }
 
-    Vertex(float x, float y) // Constructor with initialization of coordinates except z.
+    Vertex(float x, float y) : slot(-1), z(0.0f) // Constructor with initialization of coordinates except z.
     {
         coordinate[0] = x;
         coordinate[1] = y;
     }
 
-    Vertex(float x, float y, float z) // Constructor with initialization of coordinates.
+    Vertex(float x, float y, float z) : slot(-1), z(z) // Constructor with initialization of coordinates.
     {
         coordinate[0] = x;
         coordinate[1] = y;
-        coordinate[2] = z;
     }
 
-    ~Vertex()   // Destructor
-    {
-
-    }
+    Vertex(PackedMesh *mesh, int slot) : mesh(mesh), slot(slot), z(0.0f) {;} // Constructor for the point at the given position of mesh.
 
-    float* getCoordinate() // Returns a pointer to the coordinate array.
+    void bind(PackedMesh *mesh, int slot) // Makes this object the point at the given position of mesh.
     {
-        return coordinate;
+        this->mesh = mesh;
+        this->slot = slot;
     }
 
     /*
@@ -43,18 +45,34 @@ public:
     {
         for (int i = 0; i < 3; ++i)
         {
-            this->coordinate[i] = coordinate[i];
+            (*this)[i] = coordinate[i];
+        }
+    }
+
+    long long getId() // Getter for the ID of the vertex from the file, -1 for a free point.
+    {
+        return slot != -1 ? mesh->getPointId(slot) : -1;
+    }
+
+    void setId(long long id) // Modifying the ID of the vertex. A free point has none.
+    {
+        if (slot != -1)
+        {
+            mesh->setPointId(slot, id);
         }
     }
 
-    int getId() // Getter for the ID of the vertex from the file.
+    int getIncidentTriangle() // Returns one triangle which uses this vertex or -1 if none does.
     {
-        return id;
+        return slot != -1 ? mesh->getIncidentCell(slot) : -1;
     }
 
-    void setId(int id) // Modifying the ID of the vertex.
+    void setIncidentTriangle(int triangle) // Records a triangle which uses this vertex.
     {
-        this->id = id;
+        if (slot != -1)
+        {
+            mesh->setIncidentCell(slot, triangle);
+        }
     }
 
     friend bool operator<(Vertex &v0, Vertex &v1) // This operator allows the use of sort algorithm to ensure that the vertexes are in ID order.
@@ -64,12 +82,21 @@ public:
 
     float &operator[](int index) // As for the getters/setters of the coordinates, the operator [] is used to access each dimension.
     {
-        return coordinate[index];
+        if (slot == -1)
+        {
+            return index < 2 ? coordinate[index] : z;
+        }
+        return (index == 0 ? mesh->getX() : index == 1 ? mesh->getY() : mesh->getZ())[slot];
     }
 
 private:
-    float coordinate[3]; // Array for holding the coordinates.
-    int id; // ID of this point used by the triangles to reference to.
+    union
+    {
+        PackedMesh *mesh; // Storage of a point of a mesh.
+        float coordinate[2]; // x and y of a free point.
+    };
+    int slot; // Position of the point in mesh, -1 for a free point.
+    float z; // z of a free point.
 };
 
 #endif
@@ -0,0 +1,218 @@
+#include "VertexTree.h"
+#include <algorithm> // nth_element, heaps and sorting.
+#include <math.h> // For INFINITY.
+
+/*
+    The following method brings the tree up to date with the points of the mesh. The points appended since the
+    last update become a new tree at the end; then, while the last tree is at least half as large as the one
+    before it, the two are rebuilt as one. If the mesh has fewer points than the tree, points were removed and
+    everything is rebuilt.
+*/
+void VertexTree::update(PackedMesh &mesh)
+{
+    int count(mesh.getNumberOfPoints()), old(myEntries.size());
+    if (count < old)
+    {
+        clear();
+        old = 0;
+    }
+    if (count == old)
+    {
+        return;
+    }
+    float *x(mesh.getX()), *y(mesh.getY());
+    myEntries.resize(count);
+    myAxis.resize(count);
+    for (int j = old; j < count; ++j)
+    {
+        Entry entry = {x[j], y[j], j};
+        myEntries[j] = entry;
+    }
+    myTrees.push_back(old);
+    build(old, count);
+    while (myTrees.size() >= 2 && 2 * (count - myTrees.back()) >= myTrees.back() - myTrees[myTrees.size() - 2]) // Merge trees of similar size.
+    {
+        myTrees.pop_back();
+        build(myTrees.back(), count);
+    }
+}
+
+void VertexTree::clear()
+{
+    std::vector<Entry>().swap(myEntries); // Swapping with an empty container actually frees the memory.
+    std::vector<unsigned char>().swap(myAxis);
+    myTrees.clear();
+}
+
+/*
+    The following method arranges the entries [begin, end) as a tree: the middle entry is the median along the
+    longer side of the bounding box of the range, and both halves are arranged the same way.
+*/
+void VertexTree::build(int begin, int end)
+{
+    if (end - begin <= LEAF_SIZE)
+    {
+        return;
+    }
+    float minX(myEntries[begin].x), maxX(minX), minY(myEntries[begin].y), maxY(minY);
+    for (int j = begin + 1; j < end; ++j)
+    {
+        minX = std::min(minX, myEntries[j].x);
+        maxX = std::max(maxX, myEntries[j].x);
+        minY = std::min(minY, myEntries[j].y);
+        maxY = std::max(maxY, myEntries[j].y);
+    }
+    int middle(begin + (end - begin) / 2);
+    unsigned char axis(maxY - minY > maxX - minX);
+    myAxis[middle] = axis;
+    std::nth_element(myEntries.begin() + begin, myEntries.begin() + middle, myEntries.begin() + end, [axis](const Entry &a, const Entry &b)
+    {
+        return axis ? a.y < b.y : a.x < b.x;
+    });
+    build(begin, middle);
+    build(middle + 1, end);
+}
+
+int VertexTree::getEnd(int tree)
+{
+    return tree + 1 < (int)myTrees.size() ? myTrees[tree + 1] : myEntries.size();
+}
+
+int VertexTree::nearest(float x, float y)
+{
+    Candidate best(INFINITY, -1);
+    for (int tree = 0; tree < (int)myTrees.size(); ++tree)
+    {
+        searchNearest(myTrees[tree], getEnd(tree), x, y, best);
+    }
+    return best.second;
+}
+
+/*
+    The following method finds the k closest points. The candidates are kept in a max-heap of size k so the
+    worst of them, which sets how far the search has to look, is always on top.
+*/
+void VertexTree::nearest(float x, float y, int k, std::vector<int> &positions)
+{
+    positions.clear();
+    if (k <= 0)
+    {
+        return;
+    }
+    std::vector<Candidate> heap;
+    heap.reserve(k);
+    for (int tree = 0; tree < (int)myTrees.size(); ++tree)
+    {
+        searchNearest(myTrees[tree], getEnd(tree), x, y, k, heap);
+    }
+    std::sort_heap(heap.begin(), heap.end()); // Closest first.
+    for (std::vector<Candidate>::iterator it = heap.begin(); it != heap.end(); ++it)
+    {
+        positions.push_back(it->second);
+    }
+}
+
+void VertexTree::within(float x, float y, float radius, std::vector<int> &positions)
+{
+    positions.clear();
+    if (!(radius >= 0))
+    {
+        return;
+    }
+    std::vector<Candidate> found;
+    for (int tree = 0; tree < (int)myTrees.size(); ++tree)
+    {
+        searchWithin(myTrees[tree], getEnd(tree), x, y, (double)radius * radius, found);
+    }
+    std::sort(found.begin(), found.end());
+    for (std::vector<Candidate>::iterator it = found.begin(); it != found.end(); ++it)
+    {
+        positions.push_back(it->second);
+    }
+}
+
+/*
+    The following methods search one range. The middle entry of a range is tested, then the half on the side of
+    the query, then the other half if the splitting line is not further away than the worst distance that is
+    still of interest. Leaves are scanned.
+*/
+void VertexTree::searchNearest(int begin, int end, double x, double y, Candidate &best)
+{
+    int middle(end - begin <= LEAF_SIZE ? end : begin + (end - begin) / 2);
+    for (int j = (middle == end ? begin : middle); j < (middle == end ? end : middle + 1); ++j) // The whole leaf or the middle entry.
+    {
+        double dx(myEntries[j].x - x), dy(myEntries[j].y - y);
+        best = std::min(best, Candidate(dx * dx + dy * dy, myEntries[j].position));
+    }
+    if (middle == end)
+    {
+        return;
+    }
+    double side(myAxis[middle] ? myEntries[middle].y - y : myEntries[middle].x - x); // Positive if the query is on the lower side.
+    int nearBegin(side > 0 ? begin : middle + 1), nearEnd(side > 0 ? middle : end);
+    int farBegin(side > 0 ? middle + 1 : begin), farEnd(side > 0 ? end : middle);
+    searchNearest(nearBegin, nearEnd, x, y, best);
+    if (side * side <= best.first)
+    {
+        searchNearest(farBegin, farEnd, x, y, best);
+    }
+}
+
+void VertexTree::searchNearest(int begin, int end, double x, double y, int k, std::vector<Candidate> &heap)
+{
+    int middle(end - begin <= LEAF_SIZE ? end : begin + (end - begin) / 2);
+    for (int j = (middle == end ? begin : middle); j < (middle == end ? end : middle + 1); ++j) // The whole leaf or the middle entry.
+    {
+        double dx(myEntries[j].x - x), dy(myEntries[j].y - y);
+        Candidate candidate(dx * dx + dy * dy, myEntries[j].position);
+        if ((int)heap.size() < k)
+        {
+            heap.push_back(candidate);
+            std::push_heap(heap.begin(), heap.end());
+        }
+        else if (candidate < heap.front())
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = candidate;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+    if (middle == end)
+    {
+        return;
+    }
+    double side(myAxis[middle] ? myEntries[middle].y - y : myEntries[middle].x - x);
+    int nearBegin(side > 0 ? begin : middle + 1), nearEnd(side > 0 ? middle : end);
+    int farBegin(side > 0 ? middle + 1 : begin), farEnd(side > 0 ? end : middle);
+    searchNearest(nearBegin, nearEnd, x, y, k, heap);
+    if ((int)heap.size() < k || side * side <= heap.front().first)
+    {
+        searchNearest(farBegin, farEnd, x, y, k, heap);
+    }
+}
+
+void VertexTree::searchWithin(int begin, int end, double x, double y, double radiusSquared, std::vector<Candidate> &found)
+{
+    int middle(end - begin <= LEAF_SIZE ? end : begin + (end - begin) / 2);
+    for (int j = (middle == end ? begin : middle); j < (middle == end ? end : middle + 1); ++j) // The whole leaf or the middle entry.
+    {
+        double dx(myEntries[j].x - x), dy(myEntries[j].y - y);
+        if (dx * dx + dy * dy <= radiusSquared)
+        {
+            found.push_back(Candidate(dx * dx + dy * dy, myEntries[j].position));
+        }
+    }
+    if (middle == end)
+    {
+        return;
+    }
+    double side(myAxis[middle] ? myEntries[middle].y - y : myEntries[middle].x - x);
+    if (side > 0 || side * side <= radiusSquared) // The lower half may hold points in the circle.
+    {
+        searchWithin(begin, middle, x, y, radiusSquared, found);
+    }
+    if (side <= 0 || side * side <= radiusSquared)
+    {
+        searchWithin(middle + 1, end, x, y, radiusSquared, found);
+    }
+}
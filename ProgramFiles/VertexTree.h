@@ -0,0 +1,58 @@
+#ifndef VERTEXTREE_H
+#define VERTEXTREE_H
+
+#include <vector> // Needed for using the vector container.
+#include "PackedMesh.h" // The tree reads the points from the flat arrays.
+
+/*
+    The following VertexTree class answers nearest neighbour and radius queries over the points of a mesh. The
+    points are copied into an implicit kd-tree: a range of the array is split at its middle entry along the
+    longer side of its bounding box, the entries before it lie on the lower side and the entries after it on the
+    upper side, and the two halves are split again down to small leaves. No child pointers are stored.
+    Points added to the mesh later are not inserted one by one. update() builds them into a small tree of their
+    own behind the existing ones and merges trees of similar size, as in a binary counter (the logarithmic
+    method of Bentley and Saxe), so there are at most about log2(n) trees and appending is amortised
+    O(log^2 n) per point. Queries visit every tree, pruning each with the best distance found so far.
+    Results are positions of the points in the mesh. Distances are compared in double; equally distant points
+    are ordered by position, so the answers do not depend on how the trees happen to be arranged. After update()
+    the queries only read the tree and may run on several threads at once.
+*/
+class VertexTree
+{
+public:
+    VertexTree() {;} // Constructor creates an empty tree.
+
+    void update(PackedMesh &mesh); // Adds the points appended to the mesh since the last update, building everything if the mesh has fewer points than the tree.
+    void clear(); // Releases the tree. Must be done when points are moved or removed.
+    int nearest(float x, float y); // Position of the point closest to (x, y), or -1 if there are none.
+    void nearest(float x, float y, int k, std::vector<int> &positions); // Positions of the k closest points, closest first.
+    void within(float x, float y, float radius, std::vector<int> &positions); // Positions of the points at most radius away, closest first.
+
+    int getNumberOfPoints() // Points in the tree.
+    {
+        return myEntries.size();
+    }
+
+private:
+    struct Entry
+    {
+        float x, y;
+        int position; // Position of the point in the mesh.
+    };
+
+    typedef std::pair<double, int> Candidate; // Squared distance and position of a point found by a query.
+
+    static const int LEAF_SIZE = 8; // Ranges this small are scanned instead of split.
+
+    void build(int begin, int end); // Arranges the entries [begin, end) as one tree.
+    int getEnd(int tree); // End of the range of a tree.
+    void searchNearest(int begin, int end, double x, double y, Candidate &best);
+    void searchNearest(int begin, int end, double x, double y, int k, std::vector<Candidate> &heap);
+    void searchWithin(int begin, int end, double x, double y, double radiusSquared, std::vector<Candidate> &found);
+
+    std::vector<Entry> myEntries; // Points of all trees, each tree in a contiguous range.
+    std::vector<unsigned char> myAxis; // Axis the range with its middle at this entry is split along: 0 for x, 1 for y.
+    std::vector<int> myTrees; // First entry of each tree, largest tree first.
+};
+
+#endif
@@ -1,12 +1,28 @@
 #include "Triangulation.h"
+#include "MeshStream.h"
+#include "StaticMesh.h"
 using namespace std;
 
 struct one { // Functor used for testing integration method
-    float operator()(float x, float y) { // Simply returns 1 for any value given to it.
+    float operator()(float, float) { // Simply returns 1 for any value given to it.
         return 1.0;
     }
 };
 
+struct cubic { // Functor used for testing the quadrature rules: a polynomial of degree 3.
+    double operator()(double x, double y) {
+        return x * x * y;
+    }
+};
+
+struct cubicBatch { // The same polynomial evaluated for a whole batch of points in one call.
+    void operator()(const double *x, const double *y, int count, double *values) {
+        for (int i = 0; i < count; ++i) {
+            values[i] = x[i] * x[i] * y[i];
+        }
+    }
+};
+
 int main()
 {
     // The main() consists of the various tests conducted to showcase the correct functionality and usage of the classes provided.
@@ -45,15 +61,14 @@ int main()
     for (std::vector<Triangle*>::iterator it = inTriangles2.begin(); it != inTriangles2.end(); ++it) // Iterate through the container.
     {
         cout << "The triangle number:" << (*it)->getId() << " Contains the point\n"; // Print out the IDs of the triangle which contain the point.
-        // This tests an extreme case and showcases a clear problem of precision in the program.
+        // This tests an extreme case: the point is on the boundary of all 7 triangles, which only the exact predicates find.
     }
 
     /********************************Test*3************************************/
-    // Test for calculateCircumcentre() where the properties such as the circumcentre and radius are printed.
+    // Test for getCircumcentrePoint() and getRadius() where the properties such as the circumcentre and radius are printed.
     // Test 3
-    myTriangulation.calculateCircumcentreOf(983); // calculate the properties of the circumcircle of the triangle with ID as 983.
     cout << "\nMy Test 3 result = \n";
-    // Print the outputs which are placed in the Triangle objects:
+    // Print the properties of the circumcircle of the triangle with ID as 983, calculated from its vertices:
     cout << "The circumcentre of triangle 983 is: Ox = " << (*myTriangulation.getMyTriangles().at(983)).getCircumcentrePoint()[0] << " Oy = " << (*myTriangulation.getMyTriangles().at(983)).getCircumcentrePoint()[1] << "\n";
     cout << "The radius of triangle 983 is " << (*myTriangulation.getMyTriangles().at(983)).getRadius() << "\n";
 
@@ -63,19 +78,18 @@ int main()
     // The dummy point is from Test 1.
     cout << "\nMy Test 4 result = \n";
     // Print the result of the test:
-    cout << "Does first test point lie inside circumcircle: " << (*myTriangulation.getMyTriangles().at(983)).isPointInCircumcircle(myTestVertex1) << "\n";
+    cout << "Does first test point lie inside circumcircle: " << (*myTriangulation.getMyTriangles().at(983)).isPointInCircumcircle(myTestVertex1, myTriangulation.getMyPoints()) << "\n";
 
     /********************************Test*5************************************/
     // Test for isPointInCircumcircle() where the dummy point does not lie inside.
     // Test 5
     Vertex myTestVertex3(169, -4); // Dummy point which actually lies outside the circumcircle of triangle 983.
     cout << "\nMy Test 5 result = \n";
-    cout << "Does second test point lie inside circumcircle: " << (*myTriangulation.getMyTriangles().at(983)).isPointInCircumcircle(myTestVertex3) << "\n";
+    cout << "Does second test point lie inside circumcircle: " << (*myTriangulation.getMyTriangles().at(983)).isPointInCircumcircle(myTestVertex3, myTriangulation.getMyPoints()) << "\n";
 
     /********************************Test*6************************************/
-    // Test for calculateArea() where the area of a chosen triangle is calculated and compared with the 11th attribute of the triangle.
+    // Test for getArea() where the area of a chosen triangle is calculated and compared with the 11th attribute of the triangle.
     // Test 6
-    myTriangulation.calculateAreaOf(983); // Compute the area of the triangle with ID 983.
     cout << "\nMy Test 6 result = \n";
     cout << "Calculated area = " << (*myTriangulation.getMyTriangles().at(983)).getArea() << " "; // Print the value.
     // Square the area taken from the attributes as it stores the sqrt(area) and display it.
@@ -86,6 +100,13 @@ int main()
     // Test 7
     cout << "\nMy Test 7 result = \n";
     cout << "Is Delaunay? " << myTriangulation.isDelaunay() << "\n"; // Check and print the result.
+    vector<pair<long long, int> > violations; // Container for the edges which break the rule.
+    myTriangulation.checkDelaunay(&violations); // Full report instead of stopping at the first violation.
+    for (vector<pair<long long, int> >::iterator it = violations.begin(); it != violations.end(); ++it) // Print each violating edge.
+    {
+        Triangle &triangle = *myTriangulation.getMyTriangles()[myTriangulation.findTriangle(it->first)];
+        cout << "Triangle id: " << it->first << " Edge: " << it->second << " Neighbour id: " << (*myTriangulation.getMyTriangles()[triangle.getNeighbour(it->second)]).getId() << "\n";
+    }
 
     /********************************Test*8************************************/
     // Test for integration() using both approximations over a self-created .tri file which consists of a single triangle.
@@ -104,7 +125,7 @@ int main()
     myFileTest8 >> test8; // Obtain the data.
     cout << "Linear Interpolation Approximation output = " << test8.integration<one>(myOne, false) << "\n"; // Perform the first integration type and print the result.
     cout << "Constant Approximation output = " << test8.integration<one>(myOne, true) << "\n"; // Perform the second integration type and print the result.
-    test8.calculateAreaOf(0); // To verify the integration result, we must know the area of the single triangle in out mesh.
+    // To verify the integration result, we must know the area of the single triangle in out mesh.
     cout << "Area of the triangle = " << (*test8.getMyTriangles().at(0)).getArea() << "\n"; // Print that value.
 
     /********************************Test*9************************************/
@@ -148,6 +169,188 @@ int main()
     // Print the ID and data using the container for verification.
     cout << (*test8.getMyTriangles().back()).getId() << " " << (*test8.getMyTriangles().back())[0] << " " << (*test8.getMyTriangles().back())[1] << " " << (*test8.getMyTriangles().back())[2] << "\n";
 
+    /********************************Test*12************************************/
+    // Test for makeDelaunay() which repairs the triangulation#1.tri mesh found to be non-Delaunay in Test 7.
+    // Test 12
+    cout << "\nMy Test 12 result = \n";
+    cout << "Number of flips = " << myTriangulation.makeDelaunay() << "\n"; // Flip the illegal edges.
+    cout << "Is Delaunay? " << myTriangulation.isDelaunay() << "\n"; // Should now be true.
+
+    /********************************Test*13************************************/
+    // Test for load(), the fast loader, which reads triangulation#1.tri into a new object.
+    // Test 13
+    cout << "\nMy Test 13 result = \n";
+    Triangulation test13; // Fresh object, load() requires an empty one.
+    LoadStatistics statistics; // Receives the throughput or the reason of a failure.
+    if (test13.load(filename, &statistics))
+    {
+        cout << "Points: " << test13.getNumberOfPoints() << " Cells: " << test13.getNumberOfCells() << "\n"; // Should match the header lines of the file.
+        cout << "Parsed " << statistics.bytes << " bytes at " << statistics.getMegabytesPerSecond() << " MB/s\n";
+    }
+    else
+    {
+        cout << "Load failed: " << statistics.error << "\n";
+    }
+
+    /********************************Test*14************************************/
+    // Test for writeBinary() and loadBinary(): the mesh of Test 13 is written in the binary format and mapped back.
+    // Test 14
+    cout << "\nMy Test 14 result = \n";
+    char filename3[] = "./triangulation#1.bin";
+    Triangulation test14;
+    if (test13.writeBinary(filename3) && test14.loadBinary(filename3, &statistics))
+    {
+        cout << "Points: " << test14.getNumberOfPoints() << " Cells: " << test14.getNumberOfCells() << "\n"; // Should match Test 13.
+        cout << "Is Delaunay? " << test14.isDelaunay() << "\n"; // Same mesh as loaded in Test 13, so false.
+    }
+    else
+    {
+        cout << "Binary round trip failed: " << statistics.error << "\n";
+    }
+
+    /********************************Test*15************************************/
+    // Test for MeshStream which integrates over triangulation#1.tri without loading it, using at most 1 MB, and then over
+    // the binary file of Test 14.
+    // Test 15
+    cout << "\nMy Test 15 result = \n";
+    MeshStream test15(1 << 20);
+    if (test15.open(filename))
+    {
+        cout << "Streamed integral = " << test15.integration(myOne, true) << "\n"; // Should equal the next lines.
+        cout << "Loaded integral = " << test13.integration(myOne, true) << "\n";
+    }
+    else
+    {
+        cout << "Open failed: " << test15.getError() << "\n";
+    }
+    if (test15.open(filename3))
+    {
+        cout << "Streamed from the binary file = " << test15.integration(myOne, true) << "\n";
+    }
+    else
+    {
+        cout << "Open failed: " << test15.getError() << "\n";
+    }
+
+    /********************************Test*16************************************/
+    // Test for integration() with quadrature rules. A polynomial of degree 3 is integrated exactly by every rule of degree 3
+    // or more, so the results agree, whether t is called point by point or for a batch, on one thread or on four.
+    // Test 16
+    cout << "\nMy Test 16 result = \n";
+    cubic myCubic;
+    cubicBatch myCubicBatch;
+    cout.precision(12);
+    cout << "Dunavant 3 = " << test13.integration(myCubic, Quadrature::DUNAVANT_3, 1) << "\n";
+    cout << "Dunavant 7 = " << test13.integration(myCubic, Quadrature::DUNAVANT_7, 1) << "\n";
+    cout << "Dunavant 7, batch = " << test13.integration(myCubicBatch, Quadrature::DUNAVANT_7, 1) << "\n";
+    cout << "Dunavant 7, 4 threads = " << test13.integration(myCubicBatch, Quadrature::DUNAVANT_7, 4) << "\n";
+    cout << "Area = " << test13.integration(myOne, Quadrature::CENTROID) << "\n"; // Same as Test 15 in double precision.
+    cout.precision(6);
+
+    /********************************Test*17************************************/
+    // Report of the predicates used by all tests above: how many tests the floating point filter could not decide.
+    // Two cases the filter cannot decide come first: a point 2^-53 off the line through two others, which the determinant
+    // in double puts on the line, and the corners of a square, which lie on one circle.
+    // Test 17
+    cout << "\nMy Test 17 result = \n";
+    double offset(ldexp(1.0, -53)); // Smallest step above 0.5 in double.
+    double lineDeterminant((0.5 - 24.0) * (12.0 - 24.0) - (0.5 + offset - 24.0) * (12.0 - 24.0)); // Rounds to 0.
+    double lineExact(Predicates::orientation(0.5, 0.5 + offset, 12.0, 12.0, 24.0, 24.0));
+    cout << "Orientation of (0.5, 0.5 + 2^-53), (12, 12), (24, 24): double " << lineDeterminant << " exact " << (lineExact > 0) - (lineExact < 0) << "\n"; // 0 and 1: the point is to the left.
+    cout << "In-circle of the corners of the unit square: " << Predicates::inCircle(0, 0, 1, 0, 1, 1, 0, 1) << "\n"; // Exactly 0: on the circle.
+    PredicateStatistics predicates(Predicates::getStatistics());
+    cout << "Orientation tests: " << predicates.orientationTests << " exact: " << predicates.orientationExact << "\n";
+    cout << "In-circle tests: " << predicates.inCircleTests << " exact: " << predicates.inCircleExact << "\n";
+    cout << "Exact fraction: " << predicates.getExactFraction() << "\n";
+
+    /********************************Test*18************************************/
+    // Test for the metrics collected during all tests above. The counters are printed, the latencies vary between runs.
+    // Metrics::writeJson() and Metrics::writePrometheus() export everything including the histograms.
+    // Test 18
+    cout << "\nMy Test 18 result = \n";
+    MetricsSnapshot metrics(Metrics::getSnapshot());
+    for (int c = 0; c < Metrics::NUMBER_OF_COUNTERS; ++c)
+    {
+        cout << Metrics::getName((Metrics::Counter)c) << ": " << metrics.counters[c] << "\n";
+    }
+    cout << "Walks: " << metrics.counts[Metrics::LOCATE_VISITED] << " triangles visited: " << metrics.sums[Metrics::LOCATE_VISITED] << "\n";
+
+    /********************************Test*19************************************/
+    // Test for removeTriangle() and removeVertex() on the mesh of Test 13. The last triangle or vertex moves into the freed
+    // position and keeps its ID. A vertex still used by a triangle cannot be removed.
+    // Test 19
+    cout << "\nMy Test 19 result = \n";
+    long long lastTriangle(test13.getMyTriangles().back()->getId());
+    cout << "Removed triangle 0? " << test13.removeTriangle(0) << " Cells: " << test13.getNumberOfCells() << "\n";
+    cout << "Triangle 0 at " << test13.findTriangle(0) << ", triangle " << lastTriangle << " at " << test13.findTriangle(lastTriangle) << "\n"; // -1 and 0.
+    cout << "Removed vertex 0? " << test13.removeVertex(0) << "\n"; // Still used by other triangles, so 0.
+    float newX(0.5f), newY(0.5f), newZ(0.0f);
+    test13.addNewVertex(newX, newY, newZ); // Takes a Vertex object from the pool.
+    long long newVertex(test13.getMyPoints().back()->getId());
+    cout << "Removed vertex " << newVertex << "? " << test13.removeVertex(newVertex) << " Points: " << test13.getNumberOfPoints() << "\n";
+
+    /********************************Test*20************************************/
+    // Test for StaticMesh, the mesh with its layout fixed at compile time: triangulation#1.tri has 3 coordinates per point
+    // and 17 attributes per cell, read here in single and in double precision. In single precision the coordinates are
+    // those of Test 16 and so is the integral. In double precision they keep the digits float rounds away, which moves
+    // the integral in the ninth significant digit. A file with another layout is rejected.
+    // Test 20
+    cout << "\nMy Test 20 result = \n";
+    StaticMesh<float, 3, 17> test20Float;
+    StaticMesh<double, 3, 17> test20;
+    if (test20Float.load(filename, &statistics) && test20.load(filename, &statistics))
+    {
+        cout << "Points: " << test20.getNumberOfPoints() << " Cells: " << test20.getNumberOfCells() << "\n";
+        cout.precision(12);
+        cout << "Dunavant 7, float = " << test20Float.integration(myCubic, Quadrature::DUNAVANT_7, 1) << "\n"; // Same as Test 16.
+        cout << "Dunavant 7, double = " << test20.integration(myCubic, Quadrature::DUNAVANT_7, 1) << "\n";
+        cout.precision(6);
+        cout << "Is Delaunay? " << test20.isDelaunay() << "\n"; // Same as Test 14.
+    }
+    StaticMesh<float, 2, 3> wrongLayout;
+    if (!wrongLayout.load(filename, &statistics))
+    {
+        cout << "Load failed: " << statistics.error << "\n";
+    }
+
+    /********************************Test*21************************************/
+    // Test for the nearest vertex queries on the mesh of Test 14. The queries use a kd-tree over the vertices which is built
+    // by the first query; vertices added afterwards are taken into the tree without rebuilding it.
+    // Test 21
+    cout << "\nMy Test 21 result = \n";
+    vector<long long> nearIds;
+    cout << "Nearest vertex to (0, 0): " << test14.nearestVertex(0.0f, 0.0f) << "\n";
+    test14.nearestVertices(0.0f, 0.0f, 3, nearIds);
+    cout << "3 nearest:";
+    for (int i = 0; i < (int)nearIds.size(); ++i)
+    {
+        cout << " " << nearIds[i];
+    }
+    test14.verticesWithin(0.0f, 0.0f, 6.0f, nearIds);
+    cout << "\nWithin 6: " << nearIds.size() << "\n";
+    float snapX(0.0f), snapY(0.0f), snapZ(0.0f);
+    test14.addNewVertex(snapX, snapY, snapZ); // Now the nearest vertex is the new one.
+    cout << "Nearest vertex after adding one at (0, 0): " << test14.nearestVertex(0.0f, 0.0f) << " of " << test14.getNumberOfPoints() << "\n";
+
+    /********************************Test*22************************************/
+    // Test for the region queries on the mesh of Test 13: the triangles meeting a box and a polygon, and integration() over
+    // the two halves of a box around the whole mesh, which add up to the integral over the whole mesh printed after them. It
+    // differs from Test 16 because Test 19 removed a triangle.
+    // Test 22
+    cout << "\nMy Test 22 result = \n";
+    vector<long long> regionIds;
+    test13.trianglesInBox(-10.0f, -10.0f, 10.0f, 10.0f, regionIds);
+    cout << "Triangles meeting the box: " << regionIds.size() << "\n";
+    float polygonX[] = {-10.0f, 10.0f, 0.0f}, polygonY[] = {-10.0f, -10.0f, 10.0f};
+    int meeting(0);
+    test13.visitTrianglesInPolygon(polygonX, polygonY, 3, [&meeting](long long) { ++meeting; }); // Counted as they are found.
+    cout << "Triangles meeting the polygon: " << meeting << "\n";
+    float leftX[] = {-1000.0f, 0.0f, 0.0f, -1000.0f}, rightX[] = {0.0f, 1000.0f, 1000.0f, 0.0f}, halfY[] = {-1000.0f, -1000.0f, 1000.0f, 1000.0f};
+    double left(test13.integration(myCubic, Quadrature::DUNAVANT_3, leftX, halfY, 4)), right(test13.integration(myCubic, Quadrature::DUNAVANT_3, rightX, halfY, 4));
+    cout.precision(12);
+    cout << "Left + right = " << left + right << " Whole mesh = " << test13.integration(myCubic, Quadrature::DUNAVANT_3, 1) << "\n";
+    cout.precision(6);
+
     // Close the files opened for all tests.
     myFile.close();
     myFile2.close();